@@ -3,15 +3,22 @@
 
 #include <memory>
 #include <string.h>
+#include <sys/param.h>
 
 #include <esp_http_client.h>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/timers.h>
+#include <nvs.h>
 
+#include "acl_client_util.h"
 #include "fcch_acl_client/acl_client.h"
 #include "fcch_connmgr/cm.h"
 #include "fcch_connmgr/cm_conf.h"
 #include "fcch_connmgr/cm_net.h"
 #include "fcch_connmgr/cm_util.h"
+#include "fcch_trace/trace.h"
 
 static const char *TAG = "acl_client";
 
@@ -42,10 +49,33 @@ static cm_conf_item acl_client_item_acl_name = {
     .default_func = &cm_conf_default_str_empty,
 };
 
+static uint16_t acl_client_cache_minutes;
+static cm_conf_item acl_client_item_cache_minutes = {
+    .slug_name = "ct", // Cache Time
+    .text_name = "Decision Cache Lifetime (Minutes, 0 to disable)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &acl_client_cache_minutes },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static const uint16_t acl_client_default_cache_restored_minutes = 10;
+
+static uint16_t acl_client_cache_restored_minutes;
+static cm_conf_item acl_client_item_cache_restored_minutes = {
+    .slug_name = "cr", // Cache Restored
+    .text_name =
+        "Restored Decision Lifetime Until Clock Sync (Minutes, 0 for 10)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &acl_client_cache_restored_minutes },
+    .default_func = &cm_conf_default_u16_0,
+};
+
 static cm_conf_item *acl_client_items[] = {
     &acl_client_item_hostname,
     &acl_client_item_port,
     &acl_client_item_acl_name,
+    &acl_client_item_cache_minutes,
+    &acl_client_item_cache_restored_minutes,
 };
 
 static cm_conf_page access_control_page_acc = {
@@ -56,6 +86,8 @@ static cm_conf_page access_control_page_acc = {
 };
 
 static const char *acl_client_user_agent;
+static portMUX_TYPE acl_client_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static acl_client_stats acl_client_cur_stats;
 static bool acl_allow_any;
 
 static void acl_http_action_allow_any() {
@@ -70,10 +102,283 @@ static const char *acl_http_action_allow_any_description() {
     }
 }
 
+// Recent decisions from the ACL server, so a card can be granted without
+// waiting for (or reaching) the server. Entries are replaced oldest first.
+//
+// The cache is persisted to NVS, so that cards can be decided immediately
+// after a reboot, before WiFi and the ACL server are reachable. Only the RAM
+// table is updated as a card is decided; saving happens later in the
+// FreeRTOS timer service task, so a flash write is never between a card and
+// the relay. A save follows a few seconds after an entry is added or a
+// decision changes, batching changes from several cards, and otherwise the
+// cache is saved periodically so that saved ages stay current.
+//
+// Each entry is saved with the wall clock time of its decision, if the clock
+// was synchronized, and its age as of the save. Time spent powered off is
+// unbounded, and there's no wall clock at boot, so until the clock is
+// synchronized, restored entries expire no later than the (short) restored
+// lifetime after boot. Once it is, restored entries get their true age from
+// the saved wall clock time, and those past the cache lifetime are evicted.
+// The table itself is managed by acl_client_util.cpp.
+#define ACL_CLIENT_NVS_NAMESPACE "acl_client"
+// "cache" held records without the wall clock time.
+#define ACL_CLIENT_NVS_KEY_CACHE "cache2"
+#define ACL_CLIENT_CACHE_SAVE_DELAY_MS (5 * 1000)
+#define ACL_CLIENT_CACHE_SAVE_PERIOD_MS (15 * 60 * 1000)
+#define ACL_CLIENT_CACHE_CLOCK_POLL_MS 1000
+
+struct __attribute__((packed)) acl_client_cache_record {
+    uint32_t rfid;
+    // UTC milliseconds since the Unix epoch, or 0 if unknown.
+    int64_t time_ms;
+    uint32_t age_s;
+    uint8_t allowed;
+};
+
+// An entry loaded from NVS, while the clock isn't synchronized. Only applies
+// while the entry's rfid and time_us are unchanged.
+struct acl_client_cache_restored {
+    uint32_t rfid;
+    int64_t time_us;
+    int64_t time_ms;
+};
+
+static bool acl_client_cache_enabled;
+static portMUX_TYPE acl_client_cache_lock = portMUX_INITIALIZER_UNLOCKED;
+static acl_client_cache_entry acl_client_cache[ACL_CLIENT_CACHE_SIZE];
+static acl_client_cache_restored acl_client_cache_loaded[ACL_CLIENT_CACHE_SIZE];
+static acl_client_clock_func *acl_client_get_time_ms;
+// One-shot, started by a change; its activity is the "unsaved" flag.
+static StaticTimer_t acl_client_cache_save_timer_buf;
+static TimerHandle_t acl_client_cache_save_timer;
+static StaticTimer_t acl_client_cache_age_timer_buf;
+static TimerHandle_t acl_client_cache_age_timer;
+// Runs while there are restored entries and the clock isn't synchronized.
+static StaticTimer_t acl_client_cache_clock_timer_buf;
+static TimerHandle_t acl_client_cache_clock_timer;
+
+static int64_t acl_client_cache_max_age_us() {
+    return acl_client_cache_minutes * 60 * 1000000LL;
+}
+
+// Must be called with acl_client_cache_lock held.
+static bool acl_client_cache_is_restored(int i) {
+    const acl_client_cache_restored &restored = acl_client_cache_loaded[i];
+    return restored.rfid && restored.rfid == acl_client_cache[i].rfid &&
+        restored.time_us == acl_client_cache[i].time_us;
+}
+
+static void acl_client_cache_save() {
+    if (!acl_client_cache_minutes)
+        return;
+
+    acl_client_cache_record records[ACL_CLIENT_CACHE_SIZE];
+    int count = 0;
+    int64_t now_ms;
+    bool clock_ok = acl_client_get_time_ms(&now_ms);
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&acl_client_cache_lock);
+    for (int i = 0; i < ACL_CLIENT_CACHE_SIZE; i++) {
+        const acl_client_cache_entry &entry = acl_client_cache[i];
+        if (!entry.rfid)
+            continue;
+        int64_t age_us = now - entry.time_us;
+        acl_client_cache_record &record = records[count++];
+        record.rfid = entry.rfid;
+        if (clock_ok)
+            record.time_ms = now_ms - (age_us / 1000);
+        else if (acl_client_cache_is_restored(i))
+            record.time_ms = acl_client_cache_loaded[i].time_ms;
+        else
+            record.time_ms = 0;
+        record.age_s = (uint32_t)(age_us / 1000000);
+        record.allowed = entry.allowed;
+    }
+    portEXIT_CRITICAL(&acl_client_cache_lock);
+    if (!count)
+        return;
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(ACL_CLIENT_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open: %s", esp_err_to_name(err));
+        return;
+    }
+    err = nvs_set_blob(handle, ACL_CLIENT_NVS_KEY_CACHE, records,
+        count * sizeof(records[0]));
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+    if (err != ESP_OK)
+        ESP_LOGE(TAG, "cache save: %s", esp_err_to_name(err));
+}
+
+// Both run in the FreeRTOS timer service task.
+static void acl_client_cache_on_save_timer(TimerHandle_t timer) {
+    acl_client_cache_save();
+}
+
+static void acl_client_cache_on_age_timer(TimerHandle_t timer) {
+    if (!xTimerIsTimerActive(acl_client_cache_save_timer))
+        acl_client_cache_save();
+}
+
+// Once the clock is synchronized, give restored entries their true age.
+// Those saved without a wall clock time keep their restored lifetime.
+static void acl_client_cache_on_clock_timer(TimerHandle_t timer) {
+    int64_t now_ms;
+    if (!acl_client_get_time_ms(&now_ms))
+        return;
+    xTimerStop(acl_client_cache_clock_timer, 0);
+
+    int64_t max_age_us = acl_client_cache_max_age_us();
+    int64_t now = esp_timer_get_time();
+    int evicted = 0;
+    portENTER_CRITICAL(&acl_client_cache_lock);
+    for (int i = 0; i < ACL_CLIENT_CACHE_SIZE; i++) {
+        acl_client_cache_restored &restored = acl_client_cache_loaded[i];
+        if (acl_client_cache_is_restored(i) && restored.time_ms) {
+            acl_client_cache_entry &entry = acl_client_cache[i];
+            int64_t age_us = (now_ms - restored.time_ms) * 1000;
+            if (age_us >= max_age_us) {
+                entry = {};
+                evicted++;
+            } else {
+                entry.time_us = now - MAX(age_us, 0);
+            }
+        }
+        restored = {};
+    }
+    portEXIT_CRITICAL(&acl_client_cache_lock);
+    ESP_LOGI(TAG, "Clock synchronized; evicted %d stale cached decisions",
+        evicted);
+    if (evicted && !xTimerIsTimerActive(acl_client_cache_save_timer))
+        xTimerStart(acl_client_cache_save_timer, 0);
+}
+
+static void acl_client_cache_load() {
+    if (!acl_client_cache_minutes)
+        return;
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(ACL_CLIENT_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK)
+        return;
+    acl_client_cache_record records[ACL_CLIENT_CACHE_SIZE];
+    size_t size = sizeof(records);
+    err = nvs_get_blob(handle, ACL_CLIENT_NVS_KEY_CACHE, records, &size);
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        if (err != ESP_ERR_NVS_NOT_FOUND)
+            ESP_LOGE(TAG, "cache load: %s", esp_err_to_name(err));
+        return;
+    }
+
+    // Expire restored entries no later than the restored lifetime from now,
+    // by making them appear older.
+    uint32_t restored_minutes = acl_client_cache_restored_minutes ?
+        acl_client_cache_restored_minutes :
+        acl_client_default_cache_restored_minutes;
+    int64_t min_age_us =
+        acl_client_cache_max_age_us() - restored_minutes * 60 * 1000000LL;
+    int count = size / sizeof(records[0]);
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&acl_client_cache_lock);
+    for (int i = 0; i < count; i++) {
+        int64_t age_us = MAX(records[i].age_s * 1000000LL, min_age_us);
+        acl_client_cache[i].rfid = records[i].rfid;
+        acl_client_cache[i].allowed = records[i].allowed;
+        acl_client_cache[i].time_us = now - age_us;
+        acl_client_cache_loaded[i] = {
+            .rfid = records[i].rfid,
+            .time_us = acl_client_cache[i].time_us,
+            .time_ms = records[i].time_ms,
+        };
+    }
+    portEXIT_CRITICAL(&acl_client_cache_lock);
+    ESP_LOGI(TAG, "Loaded %d cached decisions", count);
+    if (count)
+        xTimerStart(acl_client_cache_clock_timer, 0);
+}
+
+static void acl_client_cache_clear() {
+    portENTER_CRITICAL(&acl_client_cache_lock);
+    memset(acl_client_cache, 0, sizeof(acl_client_cache));
+    memset(acl_client_cache_loaded, 0, sizeof(acl_client_cache_loaded));
+    portEXIT_CRITICAL(&acl_client_cache_lock);
+
+    nvs_handle_t handle;
+    if (nvs_open(ACL_CLIENT_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+        return;
+    if (nvs_erase_key(handle, ACL_CLIENT_NVS_KEY_CACHE) == ESP_OK)
+        nvs_commit(handle);
+    nvs_close(handle);
+}
+
+static void acl_client_cache_store(uint32_t rfid, bool allowed) {
+    if (!acl_client_cache_minutes || !rfid)
+        return;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&acl_client_cache_lock);
+    bool changed = acl_client_cache_table_store(acl_client_cache,
+        ACL_CLIENT_CACHE_SIZE, rfid, allowed, now);
+    portEXIT_CRITICAL(&acl_client_cache_lock);
+
+    // Not restarted if already running, so a steady stream of new cards
+    // can't postpone the save indefinitely.
+    if (changed && !xTimerIsTimerActive(acl_client_cache_save_timer))
+        xTimerStart(acl_client_cache_save_timer, 0);
+}
+
+bool acl_client_cache_lookup(uint32_t rfid, bool *allowed) {
+    if (!acl_client_cache_minutes || !rfid)
+        return false;
+    int64_t max_age_us = acl_client_cache_max_age_us();
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&acl_client_cache_lock);
+    bool found = acl_client_cache_table_find(acl_client_cache,
+        ACL_CLIENT_CACHE_SIZE, rfid, now, max_age_us, allowed);
+    portEXIT_CRITICAL(&acl_client_cache_lock);
+
+    portENTER_CRITICAL(&acl_client_stats_lock);
+    acl_client_cur_stats.cache_lookups++;
+    if (found)
+        acl_client_cur_stats.cache_hits++;
+    portEXIT_CRITICAL(&acl_client_stats_lock);
+
+    return found;
+}
+
+void acl_client_get_stats(acl_client_stats *stats) {
+    portENTER_CRITICAL(&acl_client_stats_lock);
+    *stats = acl_client_cur_stats;
+    portEXIT_CRITICAL(&acl_client_stats_lock);
+}
+
 void acl_client_register_conf() {
     cm_conf_register_page(&access_control_page_acc);
 }
 
+const cm_conf_page *acl_client_get_conf_page() {
+    return &access_control_page_acc;
+}
+
+void acl_client_reconfigure() {
+    // The server settings are read for each check, since each check uses a
+    // new connection, so only the cache needs any action.
+    bool enabled = acl_client_cache_minutes != 0;
+    if (enabled == acl_client_cache_enabled)
+        return;
+    acl_client_cache_enabled = enabled;
+    ESP_LOGI(TAG, "Decision cache %s", enabled ? "enabled" : "disabled");
+    if (enabled)
+        acl_client_cache_load();
+    else
+        acl_client_cache_clear();
+}
+
+static esp_err_t acl_client_request(uint32_t rfid, bool *allowed);
+
 esp_err_t acl_client_check_id(uint32_t rfid, bool *allowed) {
     if (acl_allow_any) {
         *allowed = true;
@@ -88,9 +393,32 @@ esp_err_t acl_client_check_id(uint32_t rfid, bool *allowed) {
         return ESP_ERR_INVALID_STATE;
     }
 
+    // Fail fast rather than waiting for a connection timeout, so the caller
+    // can fall back to a cached decision immediately, e.g. during boot.
+    if (!cm_net_get_sta_info().has_ip)
+        return ESP_ERR_INVALID_STATE;
+
+    trace(TRACE_ID_ACL_REQUEST, rfid);
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = acl_client_request(rfid, allowed);
+    int64_t latency = esp_timer_get_time() - start;
+
+    portENTER_CRITICAL(&acl_client_stats_lock);
+    acl_client_stats &stats = acl_client_cur_stats;
+    stats.requests++;
+    if (err != ESP_OK)
+        stats.errors++;
+    stats.latency_us_sum += latency;
+    if (latency > stats.latency_us_max)
+        stats.latency_us_max = latency;
+    portEXIT_CRITICAL(&acl_client_stats_lock);
+
+    return err;
+}
+
+static esp_err_t acl_client_request(uint32_t rfid, bool *allowed) {
     AutoFree<char> path;
-    asprintf(&path.val, "/api/check-access-0/%s/%lu",
-        acl_client_acl_name, rfid);
+    path.val = acl_client_format_path(acl_client_acl_name, rfid);
     if (path.val == NULL)
         return ESP_ERR_NO_MEM;
     esp_http_client_config_t config{};
@@ -125,8 +453,7 @@ esp_err_t acl_client_check_id(uint32_t rfid, bool *allowed) {
         ESP_LOGE(TAG, "content_length: %" PRId64, content_length);
         return ESP_ERR_INVALID_SIZE;
     }
-    // 8 is large enough for "True" or "False", plus NUL
-    char buf[8] = {0};
+    char buf[ACL_CLIENT_RESPONSE_BUF_SIZE] = {0};
     if (content_length >= sizeof(buf)) {
         ESP_LOGE(TAG, "content_length: %" PRId64, content_length);
         return ESP_ERR_INVALID_SIZE;
@@ -138,18 +465,48 @@ esp_err_t acl_client_check_id(uint32_t rfid, bool *allowed) {
         return ESP_ERR_INVALID_SIZE;
     }
     buf[data_read] = '\0';
-    ESP_LOGI(TAG, "HTTP GET Status = %d, content_length = %" PRId64,
-        esp_http_client_get_status_code(client),
-        content_length);
+    trace(TRACE_ID_ACL_RESPONSE, esp_http_client_get_status_code(client),
+        (uint32_t)content_length);
 
-    *allowed = !strcmp(buf, "True");
+    *allowed = acl_client_parse_response(buf);
+    acl_client_cache_store(rfid, *allowed);
     return ESP_OK;
 }
 
-void acl_client_init() {
+void acl_client_init(acl_client_clock_func *get_time_ms) {
     char *user_agent;
     asprintf(&user_agent, "%s FCCH ACL Client", cm_net_hostname);
     acl_client_user_agent = user_agent;
+    acl_client_get_time_ms = get_time_ms;
+
+    acl_client_cache_save_timer = xTimerCreateStatic(
+        "acl_cache_save",
+        ACL_CLIENT_CACHE_SAVE_DELAY_MS / portTICK_PERIOD_MS,
+        pdFALSE,
+        NULL,
+        acl_client_cache_on_save_timer,
+        &acl_client_cache_save_timer_buf);
+    assert(acl_client_cache_save_timer != NULL);
+    acl_client_cache_age_timer = xTimerCreateStatic(
+        "acl_cache_age",
+        ACL_CLIENT_CACHE_SAVE_PERIOD_MS / portTICK_PERIOD_MS,
+        pdTRUE,
+        NULL,
+        acl_client_cache_on_age_timer,
+        &acl_client_cache_age_timer_buf);
+    assert(acl_client_cache_age_timer != NULL);
+    assert(xTimerStart(acl_client_cache_age_timer, portMAX_DELAY) == pdPASS);
+    acl_client_cache_clock_timer = xTimerCreateStatic(
+        "acl_cache_clock",
+        ACL_CLIENT_CACHE_CLOCK_POLL_MS / portTICK_PERIOD_MS,
+        pdTRUE,
+        NULL,
+        acl_client_cache_on_clock_timer,
+        &acl_client_cache_clock_timer_buf);
+    assert(acl_client_cache_clock_timer != NULL);
+
+    acl_client_cache_enabled = acl_client_cache_minutes != 0;
+    acl_client_cache_load();
 
     cm_http_register_home_action(
         "acl-allow-any",
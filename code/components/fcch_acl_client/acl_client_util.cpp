@@ -0,0 +1,60 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <stdio.h>
+#include <string.h>
+
+#include "acl_client_util.h"
+
+char *acl_client_format_path(const char *acl_name, uint32_t rfid) {
+    char *path;
+    if (asprintf(&path, "/api/check-access-0/%s/%lu", acl_name, rfid) < 0)
+        return NULL;
+    return path;
+}
+
+bool acl_client_parse_response(const char *body) {
+    return !strcmp(body, "True");
+}
+
+bool acl_client_cache_table_find(
+    const acl_client_cache_entry *cache,
+    size_t count,
+    uint32_t rfid,
+    int64_t now_us,
+    int64_t max_age_us,
+    bool *allowed
+) {
+    for (size_t i = 0; i < count; i++) {
+        const acl_client_cache_entry &entry = cache[i];
+        if (entry.rfid == rfid && (now_us - entry.time_us) < max_age_us) {
+            *allowed = entry.allowed;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool acl_client_cache_table_store(
+    acl_client_cache_entry *cache,
+    size_t count,
+    uint32_t rfid,
+    bool allowed,
+    int64_t now_us
+) {
+    acl_client_cache_entry *slot = &cache[0];
+    for (size_t i = 0; i < count; i++) {
+        acl_client_cache_entry &entry = cache[i];
+        if (entry.rfid == rfid) {
+            slot = &entry;
+            break;
+        }
+        if (entry.time_us < slot->time_us)
+            slot = &entry;
+    }
+    bool changed = (slot->rfid != rfid) || (slot->allowed != allowed);
+    slot->rfid = rfid;
+    slot->allowed = allowed;
+    slot->time_us = now_us;
+    return changed;
+}
@@ -0,0 +1,48 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// The parts of the ACL client that run for every check: request path
+// formatting, response parsing and the decision cache table. This contains no
+// ESP-IDF or RTOS calls; time is passed in by the caller, which also provides
+// any locking. This allows host tools to exercise (and benchmark) them.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Large enough for "True" or "False", plus NUL
+#define ACL_CLIENT_RESPONSE_BUF_SIZE 8
+
+#define ACL_CLIENT_CACHE_SIZE 32
+
+struct acl_client_cache_entry {
+    uint32_t rfid;
+    bool allowed;
+    int64_t time_us;
+};
+
+// Returns a heap-allocated path, or NULL if out of memory.
+extern char *acl_client_format_path(const char *acl_name, uint32_t rfid);
+// body is the NUL-terminated response. Anything but "True" is a denial.
+extern bool acl_client_parse_response(const char *body);
+// Returns true, and sets *allowed, if rfid has an entry younger than
+// max_age_us.
+extern bool acl_client_cache_table_find(
+    const acl_client_cache_entry *cache,
+    size_t count,
+    uint32_t rfid,
+    int64_t now_us,
+    int64_t max_age_us,
+    bool *allowed
+);
+// Record a decision, replacing rfid's existing entry, or else the oldest.
+// Returns true if an entry was added or a decision changed; refreshing an
+// existing entry's time alone returns false.
+extern bool acl_client_cache_table_store(
+    acl_client_cache_entry *cache,
+    size_t count,
+    uint32_t rfid,
+    bool allowed,
+    int64_t now_us
+);
@@ -1,10 +1,38 @@
-// Copyright 2024-2025 Stephen Warren <swarren@wwwdotorg.org>
+// Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
 // SPDX-License-Identifier: MIT
 
 #pragma once
 
+#include <stdint.h>
+
 #include <esp_err.h>
 
+struct cm_conf_page;
+
+// UTC milliseconds since the Unix epoch. Returns false if the wall clock
+// hasn't been synchronized since boot.
+typedef bool acl_client_clock_func(int64_t *ms);
+
+// All monotonically increasing since boot.
+struct acl_client_stats {
+    uint32_t requests;      // HTTP requests made to the ACL server
+    uint32_t errors;        // Requests that failed
+    int64_t latency_us_sum; // Request round trip times
+    int64_t latency_us_max;
+    uint32_t cache_lookups; // Lookups with the cache enabled
+    uint32_t cache_hits;
+};
+
 extern void acl_client_register_conf();
-extern void acl_client_init();
+// For change notification. Call acl_client_reconfigure() after any change.
+extern const cm_conf_page *acl_client_get_conf_page();
+extern void acl_client_reconfigure();
+// Loads cached decisions persisted before the last reboot, so call this
+// before anything can query the cache. get_time_ms is used to age them.
+extern void acl_client_init(acl_client_clock_func *get_time_ms);
 extern esp_err_t acl_client_check_id(uint32_t rfid, bool *allowed);
+// Look up a recent decision from the ACL server. Returns false if there is no
+// cached decision, it has expired, or caching is disabled. Safe to call from
+// any task; never blocks.
+extern bool acl_client_cache_lookup(uint32_t rfid, bool *allowed);
+extern void acl_client_get_stats(acl_client_stats *stats);
@@ -1,14 +1,42 @@
-// Copyright 2024-2025 Stephen Warren <swarren@wwwdotorg.org>
+// Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
 // SPDX-License-Identifier: MIT
 
 #pragma once
 
 #include <stdint.h>
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Bytes. The present/absent callbacks run on this stack. Sized like the
+// stacks in main/tasks.cpp; 2871 used.
+#define RFID_TASK_STACK_SIZE 3584
+
 typedef void rfid_callback_present(uint32_t rfid);
 typedef void rfid_callback_absent();
 
-extern void rfid_init(
+// Reader health counters, all monotonically increasing since boot.
+struct rfid_stats {
+    uint32_t frames;         // Frames with a valid CRC
+    uint32_t crc_errors;     // Frames with an invalid CRC
+    uint32_t framing_errors; // Too many characters before ETX
+    uint32_t timeouts;       // Frame not completed in time after STX
+    uint32_t presentations;  // Distinct (non-fake) card presentations
+};
+
+// task_core is a core ID or tskNO_AFFINITY. The present callback runs in the
+// RFID task, so its priority and core bound fast grant latency. Returns the
+// RFID task.
+extern TaskHandle_t rfid_init(
     rfid_callback_present *cb_present,
-    rfid_callback_absent *cb_absent
+    rfid_callback_absent *cb_absent,
+    uint32_t task_priority,
+    int task_core
 );
+extern void rfid_get_stats(rfid_stats *stats);
+// esp_timer_get_time() when rfid_task received the UART data that triggered
+// the current callback. Only valid within the present/absent callbacks.
+extern int64_t rfid_get_rx_time();
+// Present rfid as if read by the reader, for dwell_ms, replacing any real card.
+// Presence and absence are reported through the normal callbacks.
+extern void rfid_inject(uint32_t rfid, uint32_t dwell_ms);
@@ -1,15 +1,22 @@
-// Copyright 2024-2025 Stephen Warren <swarren@wwwdotorg.org>
+// Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
 // SPDX-License-Identifier: MIT
 
+#include <stdlib.h>
 #include <string.h>
+#include <sys/param.h>
 
 #include <driver/uart.h>
 #include <driver/gpio.h>
+#include <esp_http_server.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 
 #include "fcch_connmgr/cm.h"
 #include "fcch_connmgr/cm_util.h"
 #include "fcch_rfid/rfid.h"
+#include "fcch_trace/trace.h"
+#include "rfid_capture.h"
+#include "rfid_decoder.h"
 
 static const char *TAG = "rfid";
 
@@ -19,11 +26,12 @@ static const int cm_rfid_pin_rxd = GPIO_NUM_13;
 static const int cm_rfid_pin_rts = UART_PIN_NO_CHANGE;
 static const int cm_rfid_pin_cts = UART_PIN_NO_CHANGE;
 static const uint32_t rfid_fake_id = 12345;
-static const TickType_t rfid_timeout_ticks = 2000 / portTICK_PERIOD_MS;
 static const TickType_t rfid_fake_time_ticks = 10000 / portTICK_PERIOD_MS;
+// 5 bytes per record; roughly 4 minutes of continuous card presence.
+static const uint32_t rfid_capture_records = 4096;
 
-static rfid_callback_present *rfid_cb_present;
-static rfid_callback_absent *rfid_cb_absent;
+static rfid_decoder rfid_dec;
+static int64_t rfid_rx_time;
 
 static void rfid_init_uart() {
     ESP_ERROR_CHECK(uart_driver_install(
@@ -47,16 +55,22 @@ static void rfid_init_uart() {
         cm_rfid_pin_txd, cm_rfid_pin_rxd, cm_rfid_pin_rts, cm_rfid_pin_cts));
 }
 
-static const int rfid_len = 12; // excluding STX, ETX
-
-static uint32_t rfid_last_id;
-static TickType_t rfid_last_id_time;
-static bool rfid_fake_present;
-static TickType_t rfid_fake_present_time;
+// An injected RFID replaces whatever the reader sees until it expires.
+static portMUX_TYPE rfid_inject_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t rfid_inject_id;
+static TickType_t rfid_inject_time;
+static TickType_t rfid_inject_ticks;
+
+void rfid_inject(uint32_t rfid, uint32_t dwell_ms) {
+    portENTER_CRITICAL(&rfid_inject_lock);
+    rfid_inject_id = rfid;
+    rfid_inject_time = xTaskGetTickCount();
+    rfid_inject_ticks = dwell_ms / portTICK_PERIOD_MS;
+    portEXIT_CRITICAL(&rfid_inject_lock);
+}
 
 static void rfid_http_action_present_fake_rfid() {
-    rfid_fake_present = true;
-    rfid_fake_present_time = xTaskGetTickCount();
+    rfid_inject(rfid_fake_id, rfid_fake_time_ticks * portTICK_PERIOD_MS);
 }
 
 static const char *rfid_http_action_present_fake_rfid_description() {
@@ -65,147 +79,194 @@ static const char *rfid_http_action_present_fake_rfid_description() {
     return "Present Fake RFID 12345 for 10s";
 }
 
-static void rfid_send_present(uint32_t rfid) {
-    rfid_last_id = rfid;
-    ESP_LOGD(TAG, "RFID present %lu", rfid);
-    rfid_cb_present(rfid);
+// The capture buffer is only allocated the first time capture is enabled, so
+// costs no RAM otherwise. It is retained after capture is disabled, so that it
+// can be downloaded.
+static portMUX_TYPE rfid_capture_lock = portMUX_INITIALIZER_UNLOCKED;
+static rfid_capture_record *rfid_capture_buf;
+static uint32_t rfid_capture_next;
+static uint32_t rfid_capture_count;
+static uint32_t rfid_capture_lost;
+static int64_t rfid_capture_last_us;
+static bool rfid_capture_enabled;
+static bool rfid_capture_downloading;
+
+static void rfid_capture_rx(const char *data, int len) {
+    if (!rfid_capture_enabled || !len)
+        return;
+    int64_t time_us = esp_timer_get_time();
+    portENTER_CRITICAL(&rfid_capture_lock);
+    if (!rfid_capture_downloading) {
+        uint32_t delta_us = (uint32_t)MIN(time_us - rfid_capture_last_us,
+            (int64_t)UINT32_MAX);
+        rfid_capture_last_us = time_us;
+        for (int i = 0; i < len; i++) {
+            rfid_capture_record &rec = rfid_capture_buf[rfid_capture_next];
+            rec.delta_us = i ? 0 : delta_us;
+            rec.data = (uint8_t)data[i];
+            rfid_capture_next = (rfid_capture_next + 1) % rfid_capture_records;
+            if (rfid_capture_count < rfid_capture_records)
+                rfid_capture_count++;
+            else
+                rfid_capture_lost++;
+        }
+    }
+    portEXIT_CRITICAL(&rfid_capture_lock);
 }
 
-static void rfid_send_removed() {
-    rfid_last_id = 0;
-    ESP_LOGD(TAG, "RFID removed");
-    rfid_cb_absent();
+static void rfid_http_action_capture_toggle() {
+    if (rfid_capture_buf == NULL) {
+        rfid_capture_buf = (rfid_capture_record *)calloc(
+            rfid_capture_records, sizeof(*rfid_capture_buf));
+        if (rfid_capture_buf == NULL) {
+            ESP_LOGE(TAG, "Can't allocate capture buffer");
+            return;
+        }
+    }
+    portENTER_CRITICAL(&rfid_capture_lock);
+    if (!rfid_capture_enabled) {
+        rfid_capture_next = 0;
+        rfid_capture_count = 0;
+        rfid_capture_lost = 0;
+        rfid_capture_last_us = esp_timer_get_time();
+    }
+    rfid_capture_enabled = !rfid_capture_enabled;
+    portEXIT_CRITICAL(&rfid_capture_lock);
 }
 
-static void rfid_handle(uint32_t rfid) {
-    if (rfid_fake_present)
-        rfid = rfid_fake_id;
-
-    if (rfid_last_id && rfid_last_id != rfid)
-        rfid_send_removed();
-
-    TickType_t now = xTaskGetTickCount();
-    rfid_last_id_time = now;
-
-    if (rfid == rfid_last_id)
-        return;
-
-    rfid_send_present(rfid);
+static const char *rfid_http_action_capture_toggle_description() {
+    if (rfid_capture_enabled) {
+        return "Toggle RFID UART Capture (Is On)";
+    } else {
+        return "Toggle RFID UART Capture (Is Off)";
+    }
 }
 
-static void rfid_check_timeout() {
-    bool clear_rfid = false;
-
-    TickType_t now = xTaskGetTickCount();
-
-    if (rfid_fake_present) {
-        TickType_t time_since_fake = now - rfid_fake_present_time;
-        if (time_since_fake > rfid_fake_time_ticks) {
-            rfid_fake_present = false;
-            clear_rfid = true;
-        }
+static esp_err_t rfid_http_handler_capture(httpd_req_t *req) {
+    if (rfid_capture_buf == NULL) {
+        httpd_resp_set_type(req, "text/plain");
+        return httpd_resp_sendstr(req, "No capture\n");
     }
 
-    if (rfid_last_id) {
-        TickType_t time_since_rfid = now - rfid_last_id_time;
-        TickType_t timeout = rfid_timeout_ticks;
-        clear_rfid |= (time_since_rfid >= timeout);
+    // Recording pauses while downloading, so the ring doesn't move underneath
+    // us; any bytes received meanwhile are not captured.
+    portENTER_CRITICAL(&rfid_capture_lock);
+    rfid_capture_downloading = true;
+    uint32_t count = rfid_capture_count;
+    uint32_t start =
+        (rfid_capture_next + rfid_capture_records - count) %
+        rfid_capture_records;
+    rfid_capture_header hdr{};
+    memcpy(hdr.magic, RFID_CAPTURE_MAGIC, sizeof(hdr.magic));
+    hdr.record_count = count;
+    hdr.records_lost = rfid_capture_lost;
+    portEXIT_CRITICAL(&rfid_capture_lock);
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition",
+        "attachment; filename=\"rfid-capture.bin\"");
+    esp_err_t err = httpd_resp_send_chunk(req,
+        (const char *)&hdr, sizeof(hdr));
+    while ((err == ESP_OK) && count) {
+        uint32_t n = MIN(count, rfid_capture_records - start);
+        err = httpd_resp_send_chunk(req,
+            (const char *)&rfid_capture_buf[start],
+            n * sizeof(*rfid_capture_buf));
+        start = (start + n) % rfid_capture_records;
+        count -= n;
     }
+    if (err == ESP_OK)
+        err = httpd_resp_send_chunk(req, NULL, 0);
 
-    if (!clear_rfid)
-        return;
+    portENTER_CRITICAL(&rfid_capture_lock);
+    rfid_capture_downloading = false;
+    portEXIT_CRITICAL(&rfid_capture_lock);
 
-    rfid_send_removed();
+    return err;
 }
 
-static void rfid_handle_raw(char *buf) {
-    uint8_t ibuf[rfid_len / 2];
-
-    // String to int
-    for (int i = 0; i < rfid_len; i += 2)
-        ibuf[i / 2] =
-            (cm_util_hex_char_to_uint(buf[i    ]) << 4) |
-            (cm_util_hex_char_to_uint(buf[i + 1]) << 0);
-
-    // CRC check
-    uint8_t crc = 0;
-    for (int i = 0; i < rfid_len / 2; i++) {
-        crc ^= ibuf[i];
-    }
-    if (crc) {
-        buf[rfid_len] = '\0';
-        ESP_LOGW(TAG, "RFID bad CRC (%s, %02x)", buf, (unsigned int)crc);
-        return;
-    }
+static const httpd_uri_t rfid_http_uri_capture = {
+    .uri = "/rfid/capture",
+    .method = HTTP_GET,
+    .handler = rfid_http_handler_capture,
+    .user_ctx = NULL,
+};
 
-    uint32_t rfid = 0;
-    for (int i = 1; i <= 4; i++)
-        rfid = (rfid << 8) | ibuf[i];
-    ESP_LOGD(TAG, "RFID present %lu", rfid);
-    rfid_handle(rfid);
+static uint32_t rfid_now_ms() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
 }
 
+static StackType_t rfid_task_stack[RFID_TASK_STACK_SIZE];
+static StaticTask_t rfid_task_tcb;
+
 static void rfid_task(void *pvParameters) {
-    char rfid_buf[rfid_len + 1]; // +1 is for NUL
-    int rfid_buf_len = 0;
-    TickType_t stx_time = 0;
     for (;;) {
-        char rx_buf[1 + rfid_len + 1 + 1]; // STX, rfid data, ETX, NUL
+        char rx_buf[1 + RFID_DECODER_FRAME_LEN + 1 + 1]; // STX, data, ETX, NUL
         int rx_buf_len = uart_read_bytes(cm_rfid_uart_num,
             rx_buf, sizeof(rx_buf) - 1, 100 / portTICK_PERIOD_MS);
-        if (rfid_fake_present)
-            rfid_handle(rfid_fake_id);
-        if (rx_buf_len) {
-            rx_buf[rx_buf_len] = '\0';
-            ESP_LOGD(TAG, "Raw TX (%s)", rx_buf);
-        }
-        for (int i = 0; i < rx_buf_len; i++) {
-            char ch = rx_buf[i];
-            if (ch == 0x02) {
-                ESP_LOGD(TAG, "RFID starts now");
-                rfid_buf_len = 0;
-                stx_time = xTaskGetTickCount();
-            } else if (ch == 0x03) {
-                rfid_buf[rfid_buf_len] = '\0';
-                ESP_LOGD(TAG, "RFID RX complete (%s)", rfid_buf);
-                rfid_handle_raw(rfid_buf);
-                rfid_buf_len = 0;
-            } else if (rfid_buf_len >= rfid_len) {
-                rfid_buf[rfid_buf_len] = '\0';
-                ESP_LOGW(TAG, "RFID too long and no ETX (%s)", rfid_buf);
-                rfid_buf_len = 0;
-            } else {
-                rfid_buf[rfid_buf_len++] = ch;
+        rfid_rx_time = esp_timer_get_time();
+        rfid_capture_rx(rx_buf, rx_buf_len);
+        uint32_t now_ms = rfid_now_ms();
+
+        portENTER_CRITICAL(&rfid_inject_lock);
+        uint32_t inject_id = rfid_inject_id;
+        bool inject_expired = false;
+        if (inject_id) {
+            TickType_t time_since_inject =
+                xTaskGetTickCount() - rfid_inject_time;
+            if (time_since_inject > rfid_inject_ticks) {
+                rfid_inject_id = 0;
+                inject_expired = true;
             }
         }
-        if (rfid_buf_len) {
-            TickType_t now = xTaskGetTickCount();
-            TickType_t time_since_stx = now - stx_time;
-            static const TickType_t max_rfid_recv_time =
-                200 / portTICK_PERIOD_MS;
-            if (time_since_stx >= max_rfid_recv_time) {
-                rfid_buf[rfid_buf_len] = '\0';
-                ESP_LOGW(TAG, "RFID RX timeout (%s)", rfid_buf);
-                rfid_buf_len = 0;
-            }
-        }
-        rfid_check_timeout();
+        portEXIT_CRITICAL(&rfid_inject_lock);
+
+        rfid_dec.override_id = inject_id;
+        if (inject_id)
+            rfid_decoder_handle(&rfid_dec, inject_id, now_ms);
+        if (rx_buf_len)
+            trace(TRACE_ID_RFID_RX, rx_buf_len, now_ms);
+        rfid_decoder_rx(&rfid_dec, rx_buf, rx_buf_len, now_ms);
+        if (inject_expired)
+            rfid_dec.override_id = 0;
+        rfid_decoder_check_timeout(&rfid_dec, now_ms, inject_expired);
     }
 }
 
-void rfid_init(
+int64_t rfid_get_rx_time() {
+    return rfid_rx_time;
+}
+
+void rfid_get_stats(rfid_stats *stats) {
+    // Only rfid_task writes these; readers tolerate a snapshot that straddles
+    // an update, so no locking is required.
+    *stats = rfid_dec.stats;
+}
+
+TaskHandle_t rfid_init(
     rfid_callback_present *cb_present,
-    rfid_callback_absent *cb_absent
+    rfid_callback_absent *cb_absent,
+    uint32_t task_priority,
+    int task_core
 ) {
     ESP_LOGI(TAG, "rfid_init: start");
-    rfid_cb_present = cb_present;
-    rfid_cb_absent = cb_absent;
+    rfid_decoder_init(&rfid_dec, cb_present, cb_absent);
     rfid_init_uart();
-    xTaskCreate(&rfid_task, "rfid", 4096, NULL, 5, NULL);
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(&rfid_task, "rfid",
+        RFID_TASK_STACK_SIZE, NULL, task_priority, rfid_task_stack,
+        &rfid_task_tcb, task_core);
+    assert(task != NULL);
     ESP_LOGI(TAG, "rfid_init: done");
     cm_http_register_home_action(
         "rfid-present-fake-rfid",
         rfid_http_action_present_fake_rfid_description,
         rfid_http_action_present_fake_rfid
     );
+    cm_http_register_home_action(
+        "rfid-capture",
+        rfid_http_action_capture_toggle_description,
+        rfid_http_action_capture_toggle
+    );
+    cm_http_register_uri_handler(&rfid_http_uri_capture);
+    return task;
 }
@@ -0,0 +1,29 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Raw RFID UART capture file format, as served by /rfid/capture and read by
+// host/rfid_replay. All fields are little-endian.
+
+#include <stdint.h>
+
+#define RFID_CAPTURE_MAGIC "FCCHRFC2"
+// The first format stored the low 32 bits of esp_timer_get_time() in each
+// record, which wrapped every 71.6 minutes. The host tools still read it.
+#define RFID_CAPTURE_MAGIC_V1 "FCCHRFC1"
+
+struct __attribute__((packed)) rfid_capture_header {
+    char magic[8];
+    uint32_t record_count;
+    // Records overwritten because the ring buffer wrapped.
+    uint32_t records_lost;
+};
+
+struct __attribute__((packed)) rfid_capture_record {
+    // Microseconds since the previous record was read, saturating at
+    // UINT32_MAX. Bytes returned by the same UART read after the first have 0.
+    // The first record's value is relative to a byte that is not in the file.
+    uint32_t delta_us;
+    uint8_t data;
+};
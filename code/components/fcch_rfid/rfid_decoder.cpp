@@ -0,0 +1,136 @@
+// Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <esp_log.h>
+
+#include "fcch_connmgr/cm_util.h"
+#include "rfid_decoder.h"
+
+static const char *TAG = "rfid";
+
+static const int rfid_len = RFID_DECODER_FRAME_LEN;
+
+void rfid_decoder_init(
+    rfid_decoder *d,
+    rfid_callback_present *cb_present,
+    rfid_callback_absent *cb_absent
+) {
+    *d = {};
+    d->cb_present = cb_present;
+    d->cb_absent = cb_absent;
+}
+
+static void rfid_decoder_send_present(rfid_decoder *d, uint32_t rfid) {
+    d->last_id = rfid;
+    if (!d->override_id)
+        d->stats.presentations++;
+    ESP_LOGD(TAG, "RFID present %lu", rfid);
+    d->cb_present(rfid);
+}
+
+static void rfid_decoder_send_removed(rfid_decoder *d) {
+    d->last_id = 0;
+    ESP_LOGD(TAG, "RFID removed");
+    d->cb_absent();
+}
+
+void rfid_decoder_handle(rfid_decoder *d, uint32_t rfid, uint32_t now_ms) {
+    if (d->override_id)
+        rfid = d->override_id;
+
+    if (d->last_id && d->last_id != rfid)
+        rfid_decoder_send_removed(d);
+
+    d->last_id_time_ms = now_ms;
+
+    if (rfid == d->last_id)
+        return;
+
+    rfid_decoder_send_present(d, rfid);
+}
+
+static void rfid_decoder_handle_raw(rfid_decoder *d, uint32_t now_ms) {
+    char *buf = d->buf;
+    uint8_t ibuf[rfid_len / 2];
+
+    // String to int
+    for (int i = 0; i < rfid_len; i += 2)
+        ibuf[i / 2] =
+            (cm_util_hex_char_to_uint(buf[i    ]) << 4) |
+            (cm_util_hex_char_to_uint(buf[i + 1]) << 0);
+
+    // CRC check
+    uint8_t crc = 0;
+    for (int i = 0; i < rfid_len / 2; i++) {
+        crc ^= ibuf[i];
+    }
+    if (crc) {
+        d->stats.crc_errors++;
+        buf[rfid_len] = '\0';
+        ESP_LOGW(TAG, "RFID bad CRC (%s, %02x)", buf, (unsigned int)crc);
+        return;
+    }
+
+    uint32_t rfid = 0;
+    for (int i = 1; i <= 4; i++)
+        rfid = (rfid << 8) | ibuf[i];
+    d->stats.frames++;
+    ESP_LOGD(TAG, "RFID present %lu", rfid);
+    rfid_decoder_handle(d, rfid, now_ms);
+}
+
+void rfid_decoder_rx(
+    rfid_decoder *d,
+    const char *data,
+    int len,
+    uint32_t now_ms
+) {
+    for (int i = 0; i < len; i++) {
+        char ch = data[i];
+        if (ch == 0x02) {
+            ESP_LOGD(TAG, "RFID starts now");
+            d->buf_len = 0;
+            d->stx_time_ms = now_ms;
+        } else if (ch == 0x03) {
+            d->buf[d->buf_len] = '\0';
+            ESP_LOGD(TAG, "RFID RX complete (%s)", d->buf);
+            rfid_decoder_handle_raw(d, now_ms);
+            d->buf_len = 0;
+        } else if (d->buf_len >= rfid_len) {
+            d->stats.framing_errors++;
+            d->buf[d->buf_len] = '\0';
+            ESP_LOGW(TAG, "RFID too long and no ETX (%s)", d->buf);
+            d->buf_len = 0;
+        } else {
+            d->buf[d->buf_len++] = ch;
+        }
+    }
+}
+
+void rfid_decoder_check_timeout(
+    rfid_decoder *d,
+    uint32_t now_ms,
+    bool force_clear
+) {
+    if (d->buf_len) {
+        uint32_t time_since_stx = now_ms - d->stx_time_ms;
+        if (time_since_stx >= RFID_DECODER_RX_TIMEOUT_MS) {
+            d->stats.timeouts++;
+            d->buf[d->buf_len] = '\0';
+            ESP_LOGW(TAG, "RFID RX timeout (%s)", d->buf);
+            d->buf_len = 0;
+        }
+    }
+
+    bool clear_rfid = force_clear;
+
+    if (d->last_id) {
+        uint32_t time_since_rfid = now_ms - d->last_id_time_ms;
+        clear_rfid |= (time_since_rfid >= RFID_DECODER_ABSENT_TIMEOUT_MS);
+    }
+
+    if (!clear_rfid)
+        return;
+
+    rfid_decoder_send_removed(d);
+}
@@ -0,0 +1,56 @@
+// Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// RDM6300 frame decoder and card presence tracker. This contains no ESP-IDF
+// driver or RTOS calls; time is passed in by the caller. This allows the exact
+// same logic to be driven by rfid_task on the device, or by host tools that
+// replay captured UART traffic.
+
+#include <stdint.h>
+
+#include "fcch_rfid/rfid.h"
+
+#define RFID_DECODER_FRAME_LEN 12 // excluding STX, ETX
+#define RFID_DECODER_RX_TIMEOUT_MS 200
+#define RFID_DECODER_ABSENT_TIMEOUT_MS 2000
+
+struct rfid_decoder {
+    rfid_callback_present *cb_present;
+    rfid_callback_absent *cb_absent;
+    // If non-zero, replaces every RFID that's presented (fake RFID support).
+    uint32_t override_id;
+    char buf[RFID_DECODER_FRAME_LEN + 1]; // +1 is for NUL
+    int buf_len;
+    uint32_t stx_time_ms;
+    uint32_t last_id;
+    uint32_t last_id_time_ms;
+    rfid_stats stats;
+};
+
+extern void rfid_decoder_init(
+    rfid_decoder *d,
+    rfid_callback_present *cb_present,
+    rfid_callback_absent *cb_absent
+);
+// Process a batch of raw UART bytes received at now_ms.
+extern void rfid_decoder_rx(
+    rfid_decoder *d,
+    const char *data,
+    int len,
+    uint32_t now_ms
+);
+// Process a decoded (or fake) RFID seen at now_ms.
+extern void rfid_decoder_handle(
+    rfid_decoder *d,
+    uint32_t rfid,
+    uint32_t now_ms
+);
+// Expire partial frames and absent cards. force_clear sends a removal even if
+// the card hasn't timed out.
+extern void rfid_decoder_check_timeout(
+    rfid_decoder *d,
+    uint32_t now_ms,
+    bool force_clear
+);
@@ -0,0 +1,37 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Binary trace of hot-path events, cheap enough to leave enabled in
+// production. Each trace() call stores a fixed-size record in a RAM ring
+// belonging to the current core; nothing is formatted or printed. The rings
+// are downloaded from /trace and decoded by host/trace_decode.
+
+#include <stdint.h>
+
+// X(name, arg0, arg1): the argument names are only used by the decoder.
+// Append new IDs at the end, so older dumps still decode correctly.
+#define TRACE_IDS(X) \
+    X(RFID_RX,                bytes,      now_ms) \
+    X(RFID_PRESENT,           rfid,       unused) \
+    X(RFID_ABSENT,            unused,     unused) \
+    X(DISPATCH_RUN,           event,      queue_us) \
+    X(DISPATCH_DROP,          event,      presence) \
+    X(MOMENTARY_EPOCH_STALE,  event_epoch, epoch) \
+    X(ACL_REQUEST,            rfid,       unused) \
+    X(ACL_RESPONSE,           http_status, content_length) \
+    X(ACL_DECISION,           rfid,       event) \
+    X(RELAY,                  level,      unused)
+
+enum trace_id : uint16_t {
+#define TRACE_ID_ENUM(name, arg0, arg1) TRACE_ID_##name,
+    TRACE_IDS(TRACE_ID_ENUM)
+#undef TRACE_ID_ENUM
+    TRACE_ID_NUM,
+};
+
+// Safe to call from any task or ISR, on either core, before trace_init().
+extern void trace(trace_id id, uint32_t arg0 = 0, uint32_t arg1 = 0);
+// Registers the /trace download.
+extern void trace_init();
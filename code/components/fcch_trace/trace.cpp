@@ -0,0 +1,83 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <string.h>
+
+#include <esp_http_server.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "fcch_connmgr/cm.h"
+#include "fcch_trace/trace.h"
+#include "trace_format.h"
+
+// 16 bytes per record; 8 KiB per core.
+#define TRACE_RECORDS_PER_CORE 512
+
+static_assert((TRACE_RECORDS_PER_CORE & (TRACE_RECORDS_PER_CORE - 1)) == 0,
+    "TRACE_RECORDS_PER_CORE must be a power of two");
+static_assert(TRACE_RECORDS_PER_CORE <= 65536,
+    "TRACE_RECORDS_PER_CORE must fit in trace_record.seq");
+
+// Writers only ever touch their own core's ring, and claim a slot with an
+// atomic increment, so a task preempted mid-record by another writer on the
+// same core (or an ISR) can't be handed the same slot. A record's seq is
+// written last; until then the slot reads as stale.
+static trace_record trace_ring[portNUM_PROCESSORS][TRACE_RECORDS_PER_CORE];
+static uint32_t trace_written[portNUM_PROCESSORS];
+
+void trace(trace_id id, uint32_t arg0, uint32_t arg1) {
+    uint32_t time_us = (uint32_t)esp_timer_get_time();
+    // If the task migrates after this, it merely writes into the other
+    // core's ring, which is still safe since slots are claimed atomically.
+    int core = xPortGetCoreID();
+    uint32_t n = __atomic_fetch_add(&trace_written[core], 1, __ATOMIC_RELAXED);
+    trace_record &rec = trace_ring[core][n % TRACE_RECORDS_PER_CORE];
+    __atomic_store_n(&rec.seq, (uint16_t)(n + 1), __ATOMIC_RELAXED);
+    rec.time_us = time_us;
+    rec.id = id;
+    rec.arg0 = arg0;
+    rec.arg1 = arg1;
+    __atomic_store_n(&rec.seq, (uint16_t)n, __ATOMIC_RELEASE);
+}
+
+// Tracing continues while downloading; the decoder discards any slot that
+// was rewritten while it was being sent.
+static esp_err_t trace_http_handler(httpd_req_t *req) {
+    trace_dump_header hdr{};
+    memcpy(hdr.magic, TRACE_DUMP_MAGIC, sizeof(hdr.magic));
+    hdr.time_us = esp_timer_get_time();
+    hdr.cores = portNUM_PROCESSORS;
+    hdr.records_per_core = TRACE_RECORDS_PER_CORE;
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition",
+        "attachment; filename=\"trace.bin\"");
+    esp_err_t err = httpd_resp_send_chunk(req,
+        (const char *)&hdr, sizeof(hdr));
+    for (int core = 0; (err == ESP_OK) && (core < portNUM_PROCESSORS);
+        core++) {
+        trace_dump_core core_hdr{};
+        core_hdr.written =
+            __atomic_load_n(&trace_written[core], __ATOMIC_ACQUIRE);
+        err = httpd_resp_send_chunk(req,
+            (const char *)&core_hdr, sizeof(core_hdr));
+        if (err == ESP_OK)
+            err = httpd_resp_send_chunk(req,
+                (const char *)trace_ring[core], sizeof(trace_ring[core]));
+    }
+    if (err == ESP_OK)
+        err = httpd_resp_send_chunk(req, NULL, 0);
+    return err;
+}
+
+static const httpd_uri_t trace_http_uri = {
+    .uri = "/trace",
+    .method = HTTP_GET,
+    .handler = trace_http_handler,
+    .user_ctx = NULL,
+};
+
+void trace_init() {
+    cm_http_register_uri_handler(&trace_http_uri);
+}
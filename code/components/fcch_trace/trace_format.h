@@ -0,0 +1,40 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Trace dump file format, as served by /trace and read by host/trace_decode.
+// All fields are little-endian. The header is followed, for each core, by a
+// trace_dump_core and then that core's entire ring of trace_records, in slot
+// order.
+
+#include <stdint.h>
+
+#define TRACE_DUMP_MAGIC "FCCHTRC1"
+
+struct __attribute__((packed)) trace_dump_header {
+    char magic[8];
+    // esp_timer_get_time() when the dump started; used to extend record
+    // timestamps to 64 bits.
+    uint64_t time_us;
+    uint32_t cores;
+    // A power of two.
+    uint32_t records_per_core;
+};
+
+struct __attribute__((packed)) trace_dump_core {
+    // Total records ever written to this core's ring; record n is in slot
+    // n % records_per_core.
+    uint32_t written;
+};
+
+struct __attribute__((packed)) trace_record {
+    // Low 32 bits of esp_timer_get_time().
+    uint32_t time_us;
+    uint16_t id;
+    // Low 16 bits of the record's number n. A slot whose seq doesn't match
+    // the n expected for it was being (over)written during the dump.
+    uint16_t seq;
+    uint32_t arg0;
+    uint32_t arg1;
+};
@@ -0,0 +1,379 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// Microbenchmarks of the firmware code that runs for every swipe or tick:
+// RFID frame decoding, ACL request path formatting, response parsing and
+// decision cache lookups, MQTT status formatting, and LCD page text assembly.
+// These are the firmware's own sources, built for the host, so absolute times
+// don't match the device; compare runs on the same host.
+//
+// Each benchmark is calibrated to run for at least bench_min_ns, then
+// repeated bench_reps times. One JSON object per benchmark is written to
+// stdout, e.g.:
+//   {"bench":"rfid_frame_same_card","iters":1048576,"ns_per_op":21.3,
+//   "min_ns_per_op":21.1}
+// ns_per_op is the median of the repetitions. Given --baseline, with the
+// output of a previous run, each result also includes the baseline's
+// ns_per_op and the percentage change from it.
+//
+// Usage: bench_hotpaths [--baseline FILE] [FILTER]
+// Only benchmarks whose names contain FILTER are run.
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "acl_client_util.h"
+#include "lcd_band.h"
+#include "lcd_text.h"
+#include "mqtt_format.h"
+#include "rfid_decoder.h"
+
+static const double bench_min_ns = 50e6;
+static const int bench_reps = 5;
+
+// Results are accumulated here so the compiler can't discard the work.
+static volatile uint64_t bench_sink;
+
+// Runs the operation iters times, and returns a value derived from the results.
+typedef uint64_t bench_func(uint64_t iters);
+
+struct bench {
+    const char *name;
+    bench_func *func;
+};
+
+// RFID frame decode
+
+static uint32_t bench_presentations;
+
+static void bench_rfid_present(uint32_t rfid) {
+    bench_presentations++;
+}
+
+static void bench_rfid_absent() {
+}
+
+// A complete RDM6300 frame: STX, version byte, 4 ID bytes and XOR checksum as
+// hex digits, ETX.
+static void bench_rfid_frame(char *frame, uint32_t rfid) {
+    uint8_t bytes[6] = {
+        0x0a,
+        uint8_t(rfid >> 24),
+        uint8_t(rfid >> 16),
+        uint8_t(rfid >> 8),
+        uint8_t(rfid >> 0),
+        0,
+    };
+    for (int i = 0; i < 5; i++)
+        bytes[5] ^= bytes[i];
+    frame[0] = 0x02;
+    for (int i = 0; i < 6; i++)
+        sprintf(&frame[1 + i * 2], "%02X", (unsigned int)bytes[i]);
+    frame[RFID_DECODER_FRAME_LEN + 1] = 0x03;
+}
+
+// The reader repeats the frame while a card is held, so this is the common
+// case: a valid frame for the card that's already present.
+static uint64_t bench_rfid_frame_same_card(uint64_t iters) {
+    char frame[RFID_DECODER_FRAME_LEN + 2];
+    bench_rfid_frame(frame, 0x00bc614e);
+    rfid_decoder d;
+    rfid_decoder_init(&d, bench_rfid_present, bench_rfid_absent);
+    for (uint64_t i = 0; i < iters; i++)
+        rfid_decoder_rx(&d, frame, sizeof(frame), (uint32_t)i);
+    return d.stats.frames;
+}
+
+// Alternating cards, so each frame is a removal plus a new presentation.
+static uint64_t bench_rfid_frame_new_card(uint64_t iters) {
+    char frames[2][RFID_DECODER_FRAME_LEN + 2];
+    bench_rfid_frame(frames[0], 0x00bc614e);
+    bench_rfid_frame(frames[1], 0x0001e240);
+    rfid_decoder d;
+    rfid_decoder_init(&d, bench_rfid_present, bench_rfid_absent);
+    for (uint64_t i = 0; i < iters; i++)
+        rfid_decoder_rx(&d, frames[i & 1], sizeof(frames[0]), (uint32_t)i);
+    return d.stats.presentations;
+}
+
+// ACL client
+
+static uint64_t bench_acl_format_path(uint64_t iters) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        char *path = acl_client_format_path("woodshop", 12345678 + (i & 0xff));
+        if (path == NULL)
+            abort();
+        sum += (uint8_t)path[20];
+        free(path);
+    }
+    return sum;
+}
+
+static uint64_t bench_acl_parse_response(uint64_t iters) {
+    static const char *const bodies[] = {"True", "False"};
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        sum += acl_client_parse_response(bodies[i & 1]);
+    return sum;
+}
+
+static const int64_t bench_acl_max_age_us = 60 * 60 * 1000000LL;
+
+// A full cache, as after a busy day.
+static void bench_acl_cache_fill(acl_client_cache_entry *cache) {
+    for (int i = 0; i < ACL_CLIENT_CACHE_SIZE; i++) {
+        acl_client_cache_table_store(cache, ACL_CLIENT_CACHE_SIZE,
+            1000 + i, i & 1, i);
+    }
+}
+
+// The worst hit: the last entry scanned.
+static uint64_t bench_acl_cache_hit(uint64_t iters) {
+    acl_client_cache_entry cache[ACL_CLIENT_CACHE_SIZE] = {};
+    bench_acl_cache_fill(cache);
+    uint32_t rfid = cache[ACL_CLIENT_CACHE_SIZE - 1].rfid;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        bool allowed;
+        sum += acl_client_cache_table_find(cache, ACL_CLIENT_CACHE_SIZE,
+            rfid, 1000, bench_acl_max_age_us, &allowed);
+    }
+    return sum;
+}
+
+static uint64_t bench_acl_cache_miss(uint64_t iters) {
+    acl_client_cache_entry cache[ACL_CLIENT_CACHE_SIZE] = {};
+    bench_acl_cache_fill(cache);
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        bool allowed;
+        sum += !acl_client_cache_table_find(cache, ACL_CLIENT_CACHE_SIZE,
+            1, 1000, bench_acl_max_age_us, &allowed);
+    }
+    return sum;
+}
+
+// Each store evicts the oldest entry.
+static uint64_t bench_acl_cache_store(uint64_t iters) {
+    acl_client_cache_entry cache[ACL_CLIENT_CACHE_SIZE] = {};
+    bench_acl_cache_fill(cache);
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        sum += acl_client_cache_table_store(cache, ACL_CLIENT_CACHE_SIZE,
+            2000 + (uint32_t)i, true, ACL_CLIENT_CACHE_SIZE + (int64_t)i);
+    }
+    return sum;
+}
+
+// MQTT
+
+static uint64_t bench_mqtt_format_status(uint64_t iters) {
+    mqtt_state state{
+        .rfid_status = MQTT_RFID_STATUS_GRANT,
+        .rfid = 12345678,
+        .boot = 17,
+        .seq = 0,
+        .time_ms = 1792310400123LL,
+        .decision_us = 1234,
+    };
+    char buf[MQTT_STATUS_BUF_SIZE];
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        state.seq = (uint32_t)i;
+        sum += mqtt_format_status(buf, state);
+    }
+    return sum;
+}
+
+static uint64_t bench_mqtt_format_heartbeat(uint64_t iters) {
+    char buf[MQTT_STATUS_BUF_SIZE];
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        sum += mqtt_format_heartbeat(buf, 17, (uint32_t)i);
+    return sum;
+}
+
+// LCD
+
+static uint64_t bench_lcd_stpcat_trunc(uint64_t iters) {
+    static const char *const strs[] = {
+        "fcch-rfid",
+        "fcch-rfid-woodshop-tablesaw",
+    };
+    char buf[LCD_TEXT_BUF_SIZE];
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        char *p = stpcat_trunc(buf, strs[i & 1], 16);
+        sum += p - buf;
+    }
+    return sum;
+}
+
+static uint64_t bench_lcd_text_ident(uint64_t iters) {
+    char buf[LCD_TEXT_BUF_SIZE];
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        lcd_text_ident(buf, "fcch-rfid-woodshop", i & 1);
+        sum += (uint8_t)buf[5];
+    }
+    return sum;
+}
+
+static uint64_t bench_lcd_text_sta(uint64_t iters) {
+    char buf[LCD_TEXT_BUF_SIZE];
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        lcd_text_sta(buf, true, "fcch-members", true, 0x6401a8c0);
+        sum += (uint8_t)buf[30];
+    }
+    return sum;
+}
+
+static uint64_t bench_lcd_text_mqtt(uint64_t iters) {
+    char buf[LCD_TEXT_BUF_SIZE];
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        lcd_text_mqtt(buf, i & 1, "fcch-rfid-woodshop");
+        sum += (uint8_t)buf[6];
+    }
+    return sum;
+}
+
+static uint64_t bench_lcd_text_rfid(uint64_t iters) {
+    char buf[LCD_TEXT_BUF_SIZE];
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        lcd_text_rfid(buf, DISPATCH_EVENT_RFID_OK, 12345678 + (i & 0xff),
+            true);
+        sum += (uint8_t)buf[15];
+    }
+    return sum;
+}
+
+// One band of the 1.14" panel's page text, where only the last pixel
+// differs between consecutive frames.
+static uint64_t bench_lcd_bands_update(uint64_t iters) {
+    const size_t count = 240 * LCD_BAND_HEIGHT;
+    static uint16_t pixels[count];
+    lcd_bands bands;
+    lcd_bands_invalidate(&bands);
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        pixels[count - 1] = i & 1;
+        sum += lcd_bands_update(&bands, 0, pixels, count);
+    }
+    return sum;
+}
+
+static const bench benches[] = {
+    {"rfid_frame_same_card", bench_rfid_frame_same_card},
+    {"rfid_frame_new_card", bench_rfid_frame_new_card},
+    {"acl_format_path", bench_acl_format_path},
+    {"acl_parse_response", bench_acl_parse_response},
+    {"acl_cache_hit", bench_acl_cache_hit},
+    {"acl_cache_miss", bench_acl_cache_miss},
+    {"acl_cache_store", bench_acl_cache_store},
+    {"mqtt_format_status", bench_mqtt_format_status},
+    {"mqtt_format_heartbeat", bench_mqtt_format_heartbeat},
+    {"lcd_stpcat_trunc", bench_lcd_stpcat_trunc},
+    {"lcd_text_ident", bench_lcd_text_ident},
+    {"lcd_text_sta", bench_lcd_text_sta},
+    {"lcd_text_mqtt", bench_lcd_text_mqtt},
+    {"lcd_text_rfid", bench_lcd_text_rfid},
+    {"lcd_bands_update", bench_lcd_bands_update},
+};
+
+static double bench_time_ns(bench_func *func, uint64_t iters) {
+    auto start = std::chrono::steady_clock::now();
+    bench_sink += func(iters);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static void bench_run(const bench &b, uint64_t *iters, double *median_ns,
+    double *min_ns
+) {
+    uint64_t n = 1;
+    while (bench_time_ns(b.func, n) < bench_min_ns)
+        n *= 2;
+
+    std::vector<double> ns_per_op;
+    for (int rep = 0; rep < bench_reps; rep++)
+        ns_per_op.push_back(bench_time_ns(b.func, n) / n);
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+
+    *iters = n;
+    *median_ns = ns_per_op[bench_reps / 2];
+    *min_ns = ns_per_op[0];
+}
+
+// Reads the ns_per_op of each benchmark from a previous run's output.
+static bool bench_load_baseline(const char *fn,
+    std::map<std::string, double> *baseline
+) {
+    FILE *f = fopen(fn, "r");
+    if (!f)
+        return false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char name[64];
+        double ns;
+        if (sscanf(line, "{\"bench\":\"%63[^\"]\",\"iters\":%*u,"
+                "\"ns_per_op\":%lf", name, &ns) == 2)
+            (*baseline)[name] = ns;
+    }
+    fclose(f);
+    return true;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--baseline FILE] [FILTER]\n", argv0);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    const char *baseline_fn = nullptr;
+    const char *filter = "";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--baseline") && i + 1 < argc)
+            baseline_fn = argv[++i];
+        else if (argv[i][0] == '-')
+            usage(argv[0]);
+        else
+            filter = argv[i];
+    }
+
+    std::map<std::string, double> baseline;
+    if (baseline_fn && !bench_load_baseline(baseline_fn, &baseline)) {
+        perror(baseline_fn);
+        return 1;
+    }
+
+    for (const bench &b : benches) {
+        if (!strstr(b.name, filter))
+            continue;
+        uint64_t iters;
+        double median_ns, min_ns;
+        bench_run(b, &iters, &median_ns, &min_ns);
+        printf("{\"bench\":\"%s\",\"iters\":%llu,\"ns_per_op\":%.1f,"
+            "\"min_ns_per_op\":%.1f", b.name, (unsigned long long)iters,
+            median_ns, min_ns);
+        auto base = baseline.find(b.name);
+        if (base != baseline.end() && base->second > 0) {
+            printf(",\"baseline_ns_per_op\":%.1f,\"change_pct\":%.1f",
+                base->second,
+                (median_ns - base->second) * 100 / base->second);
+        }
+        printf("}\n");
+        fflush(stdout);
+    }
+    return 0;
+}
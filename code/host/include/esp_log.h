@@ -0,0 +1,18 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Host stand-in for ESP-IDF's logging API. Warnings and errors go to stderr;
+// info and debug output is compiled out so it doesn't perturb tool output.
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#define ESP_LOGE(tag, fmt, ...) \
+    fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) \
+    fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) do { (void)(tag); } while (0)
+#define ESP_LOGD(tag, fmt, ...) do { (void)(tag); } while (0)
+#define ESP_LOGV(tag, fmt, ...) do { (void)(tag); } while (0)
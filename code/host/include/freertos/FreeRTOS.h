@@ -0,0 +1,7 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Host stand-in for FreeRTOS. Host tools only use the pure code behind
+// component headers, so just the types those headers mention are declared.
@@ -0,0 +1,390 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// Validates Prometheus text exposition format (version 0.0.4), as served by
+// the firmware's /metrics endpoint. Checks that every sample belongs to a
+// family announced by a preceding # TYPE line, that names, labels and values
+// are well formed, and that each histogram's buckets are cumulative and end
+// with a +Inf bucket equal to its _count.
+//
+// Usage: metrics_check < metrics.txt
+//        curl -s http://device/metrics | metrics_check
+//        metrics_check --self-test
+//   --self-test runs the firmware's metrics writer over sample data, through
+//   a deliberately tiny chunk buffer, and validates what it produces.
+
+#include <ctype.h>
+#include <map>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "metrics_writer.h"
+
+static int check_line_num;
+static int check_errors;
+
+__attribute__((format(printf, 1, 2)))
+static void check_error(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "line %d: ", check_line_num);
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+    va_end(ap);
+    check_errors++;
+}
+
+static bool check_name_start(char c) {
+    return isalpha((unsigned char)c) || c == '_' || c == ':';
+}
+
+static bool check_name_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == ':';
+}
+
+// Parse a metric or label name at *p, advancing past it.
+static bool check_parse_name(const char **p, std::string *name, bool label) {
+    const char *s = *p;
+    if (!check_name_start(*s) || (label && *s == ':'))
+        return false;
+    while (check_name_char(*s) && !(label && *s == ':'))
+        s++;
+    name->assign(*p, s - *p);
+    *p = s;
+    return true;
+}
+
+static bool check_parse_value(const char *s, double *value) {
+    if (!strcmp(s, "+Inf") || !strcmp(s, "-Inf") || !strcmp(s, "NaN")) {
+        *value = strcmp(s, "NaN") ? (s[0] == '+' ? 1e308 : -1e308) : 0;
+        return true;
+    }
+    char *end;
+    *value = strtod(s, &end);
+    return end != s && *end == '\0';
+}
+
+struct check_family {
+    std::string type;
+    bool help;
+    bool samples;
+};
+
+// Per-series histogram state, keyed by metric name plus labels excluding le.
+struct check_histogram {
+    bool buckets;
+    double last_le;
+    double last_count;
+    bool inf_seen;
+    double inf_count;
+};
+
+static std::map<std::string, check_family> check_families;
+static std::map<std::string, check_histogram> check_histograms;
+static std::string check_cur_family;
+
+// The family a sample name belongs to: histogram samples have a _bucket, _sum
+// or _count suffix on the family name.
+static std::string check_family_of(const std::string &name,
+    std::string *suffix) {
+    static const char *suffixes[] = {"_bucket", "_sum", "_count"};
+    for (const char *sfx : suffixes) {
+        size_t n = strlen(sfx);
+        if (name.size() > n && !name.compare(name.size() - n, n, sfx)) {
+            std::string base = name.substr(0, name.size() - n);
+            auto it = check_families.find(base);
+            if (it != check_families.end() && it->second.type == "histogram") {
+                *suffix = sfx;
+                return base;
+            }
+        }
+    }
+    suffix->clear();
+    return name;
+}
+
+static void check_comment(const char *line) {
+    const char *p = line + 1;
+    while (*p == ' ')
+        p++;
+    bool help = !strncmp(p, "HELP ", 5);
+    bool type = !strncmp(p, "TYPE ", 5);
+    if (!help && !type)
+        return;
+    p += 5;
+    std::string name;
+    if (!check_parse_name(&p, &name, false) || (*p != ' ' && *p != '\0')) {
+        check_error("bad metric name in %s", help ? "HELP" : "TYPE");
+        return;
+    }
+    check_family &fam = check_families[name];
+    if (fam.samples)
+        check_error("%s for %s after its samples", help ? "HELP" : "TYPE",
+            name.c_str());
+    if (name != check_cur_family && (fam.help || !fam.type.empty()))
+        check_error("%s for %s is not grouped with its family",
+            help ? "HELP" : "TYPE", name.c_str());
+    check_cur_family = name;
+    if (help) {
+        if (fam.help)
+            check_error("duplicate HELP for %s", name.c_str());
+        fam.help = true;
+        return;
+    }
+    if (!fam.type.empty())
+        check_error("duplicate TYPE for %s", name.c_str());
+    while (*p == ' ')
+        p++;
+    fam.type = p;
+    if (fam.type != "counter" && fam.type != "gauge" &&
+        fam.type != "histogram" && fam.type != "summary" &&
+        fam.type != "untyped")
+        check_error("unknown TYPE %s", p);
+}
+
+static void check_histogram_sample(const std::string &family,
+    const std::string &suffix, const std::string &series, const char *le,
+    double value) {
+    check_histogram &h = check_histograms[family + "{" + series + "}"];
+    if (suffix == "_bucket") {
+        if (!le) {
+            check_error("%s_bucket without le label", family.c_str());
+            return;
+        }
+        double bound;
+        if (!check_parse_value(le, &bound)) {
+            check_error("bad le value %s", le);
+            return;
+        }
+        if (h.inf_seen)
+            check_error("%s bucket after +Inf", family.c_str());
+        if (h.buckets && bound <= h.last_le)
+            check_error("%s buckets not in increasing le order",
+                family.c_str());
+        if (value < h.last_count)
+            check_error("%s buckets not cumulative", family.c_str());
+        h.buckets = true;
+        h.last_le = bound;
+        h.last_count = value;
+        if (!strcmp(le, "+Inf")) {
+            h.inf_seen = true;
+            h.inf_count = value;
+        }
+    } else if (suffix == "_count") {
+        if (!h.inf_seen)
+            check_error("%s has no +Inf bucket", family.c_str());
+        else if (value != h.inf_count)
+            check_error("%s_count %g != +Inf bucket %g", family.c_str(),
+                value, h.inf_count);
+    } else if (le) {
+        check_error("le label on %s%s", family.c_str(), suffix.c_str());
+    }
+}
+
+static void check_sample(const char *line) {
+    const char *p = line;
+    std::string name;
+    if (!check_parse_name(&p, &name, false)) {
+        check_error("bad metric name");
+        return;
+    }
+
+    // Labels, other than a histogram's le, identify the series.
+    std::string series;
+    std::string le_val;
+    bool has_le = false;
+    if (*p == '{') {
+        p++;
+        while (*p != '}') {
+            std::string label;
+            if (!check_parse_name(&p, &label, true) || *p != '=' ||
+                p[1] != '"') {
+                check_error("bad label in %s", name.c_str());
+                return;
+            }
+            p += 2;
+            std::string val;
+            while (*p && *p != '"') {
+                if (*p == '\\') {
+                    p++;
+                    if (*p != '\\' && *p != '"' && *p != 'n') {
+                        check_error("bad escape in label %s", label.c_str());
+                        return;
+                    }
+                }
+                val += *p++;
+            }
+            if (*p != '"') {
+                check_error("unterminated label value in %s", name.c_str());
+                return;
+            }
+            p++;
+            if (label == "le") {
+                has_le = true;
+                le_val = val;
+            } else {
+                series += label + "=\"" + val + "\",";
+            }
+            if (*p == ',')
+                p++;
+            else if (*p != '}') {
+                check_error("bad label list in %s", name.c_str());
+                return;
+            }
+        }
+        p++;
+    }
+    if (*p != ' ') {
+        check_error("missing value for %s", name.c_str());
+        return;
+    }
+    while (*p == ' ')
+        p++;
+    // An optional integer timestamp may follow the value.
+    std::string value_str(p, strcspn(p, " "));
+    p += value_str.size();
+    while (*p == ' ')
+        p++;
+    double value;
+    if (!check_parse_value(value_str.c_str(), &value)) {
+        check_error("bad value %s for %s", value_str.c_str(), name.c_str());
+        return;
+    }
+    if (*p) {
+        char *end;
+        strtoll(p, &end, 10);
+        if (end == p || *end)
+            check_error("bad timestamp for %s", name.c_str());
+    }
+
+    std::string suffix;
+    std::string family = check_family_of(name, &suffix);
+    auto it = check_families.find(family);
+    if (it == check_families.end() || it->second.type.empty()) {
+        check_error("sample %s has no preceding TYPE", name.c_str());
+        return;
+    }
+    check_family &fam = it->second;
+    if (family != check_cur_family)
+        check_error("sample %s is not grouped with its family",
+            name.c_str());
+    fam.samples = true;
+    if (fam.type == "counter" && value < 0)
+        check_error("counter %s is negative", name.c_str());
+    if (fam.type == "histogram") {
+        if (suffix.empty())
+            check_error("histogram sample %s lacks a suffix", name.c_str());
+        else
+            check_histogram_sample(family, suffix, series,
+                has_le ? le_val.c_str() : nullptr, value);
+    } else if (has_le && fam.type != "untyped") {
+        check_error("le label on %s %s", fam.type.c_str(), name.c_str());
+    }
+}
+
+static void check_line(const char *line) {
+    check_line_num++;
+    if (!*line)
+        return;
+    if (line[0] == '#')
+        check_comment(line);
+    else
+        check_sample(line);
+}
+
+static int check_finish() {
+    for (auto &it : check_histograms) {
+        if (!it.second.inf_seen)
+            fprintf(stderr, "%s: no +Inf bucket\n", it.first.c_str());
+        check_errors += !it.second.inf_seen;
+    }
+    if (!check_families.size()) {
+        fprintf(stderr, "no metrics\n");
+        check_errors++;
+    }
+    if (check_errors) {
+        fprintf(stderr, "%d error(s)\n", check_errors);
+        return 1;
+    }
+    printf("OK: %d lines, %zu families\n", check_line_num,
+        check_families.size());
+    return 0;
+}
+
+// --self-test: writer output is captured here, chunk by chunk.
+static std::string self_test_out;
+static int self_test_chunks;
+
+static bool self_test_flush(void *ctx, const char *buf, size_t len) {
+    self_test_out.append(buf, len);
+    self_test_chunks++;
+    return true;
+}
+
+static int self_test() {
+    // Small enough to force many flushes, but large enough for any one line.
+    static char buf[96];
+    static const uint32_t bounds_us[] = {100, 1000, 10000, 100000, 1000000};
+    static const uint32_t buckets[] = {0, 3, 10, 2, 0, 1};
+
+    metrics_writer w;
+    metrics_writer_init(&w, buf, sizeof(buf), self_test_flush, nullptr);
+    metrics_header(&w, "fcch_uptime_seconds", "gauge", "Time since boot.");
+    metrics_sample_us(&w, "fcch_uptime_seconds", nullptr, 12345678901ULL);
+    metrics_header(&w, "fcch_decisions_total", "counter", "Decisions.");
+    metrics_sample(&w, "fcch_decisions_total", "result=\"grant\"", 42);
+    metrics_sample(&w, "fcch_decisions_total", "result=\"deny\"", 0);
+    metrics_header(&w, "fcch_latency_seconds", "histogram", "Latency.");
+    metrics_histogram_us(&w, "fcch_latency_seconds", "stage=\"acl\"",
+        bounds_us, 5, buckets, 7654321);
+    metrics_histogram_us(&w, "fcch_latency_seconds", "stage=\"total\"",
+        bounds_us, 5, buckets, 0);
+    metrics_header(&w, "fcch_unlabelled_seconds", "histogram", "Latency.");
+    metrics_histogram_us(&w, "fcch_unlabelled_seconds", nullptr,
+        bounds_us, 5, buckets, 1);
+    if (!metrics_writer_finish(&w)) {
+        fprintf(stderr, "writer failed\n");
+        return 1;
+    }
+
+    fputs(self_test_out.c_str(), stdout);
+    printf("# %d chunks\n", self_test_chunks);
+    size_t pos = 0;
+    while (pos < self_test_out.size()) {
+        size_t nl = self_test_out.find('\n', pos);
+        if (nl == std::string::npos) {
+            check_line_num++;
+            check_error("missing final newline");
+            break;
+        }
+        check_line(self_test_out.substr(pos, nl - pos).c_str());
+        pos = nl + 1;
+    }
+    return check_finish();
+}
+
+int main(int argc, char **argv) {
+    if (argc == 2 && !strcmp(argv[1], "--self-test"))
+        return self_test();
+    if (argc != 1) {
+        fprintf(stderr, "usage: %s [--self-test] < metrics.txt\n", argv[0]);
+        return 1;
+    }
+
+    static char line[4096];
+    while (fgets(line, sizeof(line), stdin)) {
+        size_t len = strlen(line);
+        if (len && line[len - 1] == '\n')
+            line[--len] = '\0';
+        else if (!feof(stdin)) {
+            check_line_num++;
+            check_error("line too long");
+            return check_finish();
+        }
+        check_line(line);
+    }
+    return check_finish();
+}
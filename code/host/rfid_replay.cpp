@@ -0,0 +1,194 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// Replays a raw RFID UART capture (downloaded from /rfid/capture) through the
+// firmware's RFID decoder and presence logic, printing each presence event
+// with its timestamp relative to the first captured byte.
+//
+// Usage: rfid_replay [--speed N] [--expect FILE] capture.bin
+//   --speed 0 (default) replays as fast as possible; --speed 1 replays with
+//   the original timing; --speed N replays N times faster than real time.
+//   --expect FILE prints nothing and exits 0 if the output matches FILE,
+//   otherwise prints the output and exits 1, for regression tests.
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "rfid_capture.h"
+#include "rfid_decoder.h"
+
+// Matches rfid_task's uart_read_bytes() timeout.
+static const uint32_t replay_poll_ms = 100;
+
+static rfid_decoder replay_dec;
+static FILE *replay_out;
+// Kept in 64 bits so that long captures replay correctly; the decoder sees
+// the low 32 bits, like the firmware's millisecond clock.
+static int64_t replay_now_ms;
+
+static void replay_present(uint32_t rfid) {
+    fprintf(replay_out, "%10.3f PRESENT %lu\n", replay_now_ms / 1000.0,
+        (unsigned long)rfid);
+}
+
+static void replay_absent() {
+    fprintf(replay_out, "%10.3f ABSENT\n", replay_now_ms / 1000.0);
+}
+
+static double replay_speed;
+static std::chrono::steady_clock::time_point replay_start;
+
+// Advance the simulated clock, sleeping to match the requested speed.
+static void replay_advance(int64_t t_ms) {
+    replay_now_ms = t_ms;
+    if (replay_speed <= 0)
+        return;
+    auto target = replay_start + std::chrono::microseconds(
+        (int64_t)(t_ms * 1000.0 / replay_speed));
+    std::this_thread::sleep_until(target);
+}
+
+// Run the periodic timeout checks rfid_task would have made while idle.
+static void replay_poll_until(int64_t t_ms) {
+    while (t_ms - replay_now_ms > replay_poll_ms) {
+        replay_advance(replay_now_ms + replay_poll_ms);
+        rfid_decoder_check_timeout(&replay_dec, (uint32_t)replay_now_ms,
+            false);
+    }
+}
+
+// Returns the time between each record and the previous one. Version 1
+// captures hold 32-bit absolute times, so a gap longer than 71.6 minutes
+// between two bytes can't be recovered; unsigned subtraction unwraps the rest.
+static std::vector<uint32_t> replay_deltas(
+    const std::vector<rfid_capture_record> &recs, bool v1
+) {
+    std::vector<uint32_t> deltas(recs.size());
+    for (size_t i = 1; i < recs.size(); i++) {
+        if (v1)
+            deltas[i] = recs[i].delta_us - recs[i - 1].delta_us;
+        else
+            deltas[i] = recs[i].delta_us;
+    }
+    return deltas;
+}
+
+static bool replay_matches(const char *expect_path, const char *out,
+    size_t out_len
+) {
+    FILE *f = fopen(expect_path, "rb");
+    if (!f) {
+        perror(expect_path);
+        return false;
+    }
+    std::vector<char> expected;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        expected.insert(expected.end(), buf, buf + n);
+    fclose(f);
+    return expected.size() == out_len &&
+        !memcmp(expected.data(), out, out_len);
+}
+
+static int usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--speed N] [--expect FILE] capture.bin\n",
+        argv0);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *expect_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--speed") && (i + 1 < argc))
+            replay_speed = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--expect") && (i + 1 < argc))
+            expect_path = argv[++i];
+        else if (!path)
+            path = argv[i];
+        else
+            return usage(argv[0]);
+    }
+    if (!path)
+        return usage(argv[0]);
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    rfid_capture_header hdr;
+    bool read_ok = fread(&hdr, sizeof(hdr), 1, f) == 1;
+    bool v1 = read_ok &&
+        !memcmp(hdr.magic, RFID_CAPTURE_MAGIC_V1, sizeof(hdr.magic));
+    if (!read_ok ||
+        (!v1 && memcmp(hdr.magic, RFID_CAPTURE_MAGIC, sizeof(hdr.magic)))
+    ) {
+        fprintf(stderr, "%s: not an RFID capture\n", path);
+        return 1;
+    }
+    std::vector<rfid_capture_record> recs(hdr.record_count);
+    if (fread(recs.data(), sizeof(recs[0]), recs.size(), f) != recs.size()) {
+        fprintf(stderr, "%s: truncated capture\n", path);
+        return 1;
+    }
+    fclose(f);
+    if (hdr.records_lost)
+        fprintf(stderr, "note: %lu records lost before capture start\n",
+            (unsigned long)hdr.records_lost);
+
+    std::vector<uint32_t> deltas = replay_deltas(recs, v1);
+
+    char *out = NULL;
+    size_t out_len = 0;
+    replay_out = expect_path ? open_memstream(&out, &out_len) : stdout;
+    rfid_decoder_init(&replay_dec, replay_present, replay_absent);
+    replay_start = std::chrono::steady_clock::now();
+
+    // Bytes after the first with a zero delta were returned by the same
+    // uart_read_bytes() call, so are replayed as one batch.
+    int64_t time_us = 0;
+    size_t i = 0;
+    while (i < recs.size()) {
+        time_us += deltas[i];
+        char batch[64];
+        int batch_len = 0;
+        do {
+            batch[batch_len++] = (char)recs[i++].data;
+        } while (i < recs.size() && !deltas[i] &&
+            batch_len < (int)sizeof(batch));
+        int64_t t_ms = time_us / 1000;
+        replay_poll_until(t_ms);
+        replay_advance(t_ms);
+        rfid_decoder_rx(&replay_dec, batch, batch_len,
+            (uint32_t)replay_now_ms);
+        rfid_decoder_check_timeout(&replay_dec, (uint32_t)replay_now_ms,
+            false);
+    }
+    // Let any card still present time out.
+    replay_poll_until(replay_now_ms + RFID_DECODER_ABSENT_TIMEOUT_MS +
+        2 * replay_poll_ms);
+
+    const rfid_stats &s = replay_dec.stats;
+    fprintf(replay_out, "stats frames=%lu crc_errors=%lu framing_errors=%lu "
+        "timeouts=%lu presentations=%lu\n",
+        (unsigned long)s.frames, (unsigned long)s.crc_errors,
+        (unsigned long)s.framing_errors, (unsigned long)s.timeouts,
+        (unsigned long)s.presentations);
+    if (!expect_path)
+        return 0;
+
+    fclose(replay_out);
+    bool match = replay_matches(expect_path, out, out_len);
+    if (!match) {
+        fprintf(stderr, "%s: output differs from %s:\n", path, expect_path);
+        fwrite(out, 1, out_len, stdout);
+    }
+    free(out);
+    return match ? 0 : 1;
+}
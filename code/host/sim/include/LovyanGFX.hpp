@@ -0,0 +1,167 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Headless stand-in for the parts of LovyanGFX that lcd.cpp uses. Drawing
+// goes to an RGB565 framebuffer of the panel's size, via sprites. Text isn't
+// rendered legibly; what was printed is recorded as the screen's text
+// instead, which is what scenarios check. See sim.h for access to both.
+
+// The real header pulls in the C string and stdio functions; lcd.cpp relies
+// on that.
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define TFT_BLACK 0x0000
+#define TFT_WHITE 0xffff
+#define SPI2_HOST 1
+#define SPI_DMA_CH_AUTO 3
+
+namespace lgfx {
+
+class Bus_SPI {
+public:
+    struct config_t {
+        int spi_host;
+        uint8_t spi_mode;
+        uint32_t freq_write;
+        uint32_t freq_read;
+        bool spi_3wire;
+        bool use_lock;
+        int dma_channel;
+        int pin_sclk;
+        int pin_mosi;
+        int pin_miso;
+        int pin_dc;
+    };
+
+    config_t config() const { return m_cfg; }
+    void config(const config_t &cfg) { m_cfg = cfg; }
+
+private:
+    config_t m_cfg{};
+};
+
+class Light_PWM {
+public:
+    struct config_t {
+        int pin_bl;
+        bool invert;
+        uint32_t freq;
+        int pwm_channel;
+    };
+
+    config_t config() const { return m_cfg; }
+    void config(const config_t &cfg) { m_cfg = cfg; }
+
+private:
+    config_t m_cfg{};
+};
+
+class Panel_ST7735S {
+public:
+    struct config_t {
+        int pin_cs;
+        int pin_rst;
+        int pin_busy;
+        uint16_t panel_width;
+        uint16_t panel_height;
+        int16_t offset_x;
+        int16_t offset_y;
+        uint8_t offset_rotation;
+        uint8_t dummy_read_pixel;
+        uint8_t dummy_read_bits;
+        bool readable;
+        bool invert;
+        bool rgb_order;
+        bool dlen_16bit;
+        bool bus_shared;
+    };
+
+    config_t config() const { return m_cfg; }
+    void config(const config_t &cfg) { m_cfg = cfg; }
+    void setBus(Bus_SPI *bus) {}
+    void setLight(Light_PWM *light) {}
+
+private:
+    config_t m_cfg{};
+};
+
+// Drawing surface, as the base of LGFX_Device and LGFX_Sprite. Text is drawn
+// as a block per character, the character code's bits setting its rows, so
+// that changed text changes pixels, as it would on the device.
+class LovyanGFX {
+public:
+    int32_t width() const { return m_width; }
+    int32_t height() const { return m_height; }
+
+    void clear(uint16_t color);
+    void setColor(uint16_t color) { m_color = color; }
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h);
+    void setCursor(int32_t x, int32_t y) {
+        m_cursor_x = x;
+        m_cursor_y = y;
+    }
+    void setTextSize(float size) { m_text_size = size; }
+    void setTextColor(uint16_t color) { m_text_color = color; }
+    size_t println(const char *s);
+
+protected:
+    friend class LGFX_Sprite;
+
+    void resize(int32_t width, int32_t height);
+    void fill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+    // Copy pixels to (x, y), clipped; returns the number copied.
+    virtual size_t pushImage(int32_t x, int32_t y, int32_t w, int32_t h,
+        const uint16_t *data);
+
+    int32_t m_width = 0;
+    int32_t m_height = 0;
+    uint16_t m_color = 0;
+    int32_t m_cursor_x = 0;
+    int32_t m_cursor_y = 0;
+    int32_t m_text_size = 1;
+    uint16_t m_text_color = TFT_WHITE;
+    std::vector<uint16_t> m_fb;
+    // Everything printed since the last clear()
+    std::string m_text;
+};
+
+// A completed frame is published at endWrite(), if anything was sent.
+class LGFX_Device : public LovyanGFX {
+public:
+    void setPanel(Panel_ST7735S *panel) { m_panel = panel; }
+    bool init();
+    void setBrightness(uint8_t brightness);
+    void sleep() {}
+    void wakeup() {}
+    void startWrite() { m_pushed = false; }
+    void endWrite();
+    // Sprites are copied synchronously, so there's never anything to wait for.
+    void waitDMA() {}
+
+protected:
+    size_t pushImage(int32_t x, int32_t y, int32_t w, int32_t h,
+        const uint16_t *data) override;
+
+private:
+    Panel_ST7735S *m_panel = nullptr;
+    bool m_pushed = false;
+};
+
+class LGFX_Sprite : public LovyanGFX {
+public:
+    LGFX_Sprite(LovyanGFX *parent = nullptr) {}
+    void setColorDepth(int bits) {}
+    void *createSprite(int32_t w, int32_t h);
+    void deleteSprite() { resize(0, 0); }
+    void *getBuffer() { return m_fb.empty() ? nullptr : m_fb.data(); }
+    // The destination's text becomes this sprite's.
+    void pushSprite(LovyanGFX *dst, int32_t x, int32_t y);
+};
+}
@@ -0,0 +1,70 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// A virtual UART receiver. Bytes are queued by the simulator (see sim.h) and
+// become readable at the configured baud rate, as if arriving on the wire.
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef int uart_port_t;
+typedef void *QueueHandle_t;
+
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+#define UART_NUM_2 2
+#define UART_PIN_NO_CHANGE -1
+
+typedef enum {
+    UART_DATA_5_BITS,
+    UART_DATA_6_BITS,
+    UART_DATA_7_BITS,
+    UART_DATA_8_BITS,
+} uart_word_length_t;
+
+typedef enum {
+    UART_PARITY_DISABLE,
+    UART_PARITY_EVEN = 2,
+    UART_PARITY_ODD,
+} uart_parity_t;
+
+typedef enum {
+    UART_STOP_BITS_1 = 1,
+    UART_STOP_BITS_1_5,
+    UART_STOP_BITS_2,
+} uart_stop_bits_t;
+
+typedef enum {
+    UART_HW_FLOWCTRL_DISABLE,
+} uart_hw_flowcontrol_t;
+
+typedef enum {
+    UART_SCLK_DEFAULT,
+} uart_sclk_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+    uart_sclk_t source_clk;
+} uart_config_t;
+
+extern esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size,
+    int tx_buffer_size, int queue_size, QueueHandle_t *queue,
+    int intr_alloc_flags);
+extern esp_err_t uart_param_config(uart_port_t port,
+    const uart_config_t *config);
+extern esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts,
+    int cts);
+// Waits until length bytes are available or ticks expire, then returns what
+// is available.
+extern int uart_read_bytes(uart_port_t port, void *buf, uint32_t length,
+    TickType_t ticks);
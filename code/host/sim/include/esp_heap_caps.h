@@ -0,0 +1,17 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// The host heap isn't comparable to the device's, so these report fixed
+// values (see sim_esp.cpp).
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+extern size_t heap_caps_get_free_size(uint32_t caps);
+extern size_t heap_caps_get_minimum_free_size(uint32_t caps);
+extern size_t heap_caps_get_largest_free_block(uint32_t caps);
@@ -0,0 +1,39 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// A blocking HTTP/1.1 client over host sockets, covering the calls that
+// acl_client makes. Only Content-Length responses are supported.
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef enum {
+    HTTP_METHOD_GET,
+} esp_http_client_method_t;
+
+typedef struct {
+    const char *url;
+    const char *host;
+    int port;
+    const char *path;
+    const char *user_agent;
+    esp_http_client_method_t method;
+    int timeout_ms;
+} esp_http_client_config_t;
+
+struct sim_http_client;
+typedef sim_http_client *esp_http_client_handle_t;
+
+extern esp_http_client_handle_t esp_http_client_init(
+    const esp_http_client_config_t *config);
+extern esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
+extern esp_err_t esp_http_client_open(esp_http_client_handle_t client,
+    int write_len);
+extern esp_err_t esp_http_client_close(esp_http_client_handle_t client);
+extern int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client);
+extern int esp_http_client_read_response(esp_http_client_handle_t client,
+    char *buf, int len);
+extern int esp_http_client_get_status_code(esp_http_client_handle_t client);
@@ -0,0 +1,50 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Handlers registered through cm_http_register_uri_handler() are served by the
+// simulator's own minimal HTTP server (--http-port), and can be invoked
+// directly by scenarios.
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "esp_err.h"
+
+typedef void *httpd_handle_t;
+
+typedef enum {
+    HTTP_GET = 1,
+    HTTP_POST = 3,
+} httpd_method_t;
+
+struct sim_http_response;
+
+typedef struct httpd_req {
+    httpd_handle_t handle;
+    int method;
+    char uri[513];
+    size_t content_len;
+    void *user_ctx;
+    sim_http_response *sim;
+} httpd_req_t;
+
+typedef struct httpd_uri {
+    const char *uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *req);
+    void *user_ctx;
+} httpd_uri_t;
+
+#define HTTPD_RESP_USE_STRLEN -1
+
+extern esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type);
+extern esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field,
+    const char *value);
+extern esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf,
+    ssize_t len);
+extern esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf,
+    ssize_t len);
+extern esp_err_t httpd_resp_sendstr(httpd_req_t *req, const char *str);
+extern esp_err_t httpd_resp_sendstr_chunk(httpd_req_t *req, const char *str);
@@ -0,0 +1,44 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Log lines are formatted as on the device ("I (1234) tag: message") and
+// passed through the function set by esp_log_set_vprintf(), so the firmware's
+// log sink sees the same input. The level is set by the simulator's
+// --log-level option.
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "esp_err.h"
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+typedef int (*vprintf_like_t)(const char *format, va_list args);
+
+extern void esp_log_write(esp_log_level_t level, const char *tag,
+    const char *format, ...) __attribute__((format(printf, 3, 4)));
+extern vprintf_like_t esp_log_set_vprintf(vprintf_like_t func);
+extern uint32_t esp_log_timestamp();
+extern void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+#define ESP_LOGE(tag, format, ...) \
+    esp_log_write(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) \
+    esp_log_write(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) \
+    esp_log_write(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) \
+    esp_log_write(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) \
+    esp_log_write(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
@@ -0,0 +1,24 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// The host clock is assumed to be synchronized already, so "synchronization"
+// completes shortly after esp_sntp_init(), without any network traffic.
+
+#include <stdint.h>
+#include <sys/time.h>
+
+typedef enum {
+    ESP_SNTP_OPMODE_POLL,
+    ESP_SNTP_OPMODE_LISTENONLY,
+} esp_sntp_operatingmode_t;
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval *tv);
+
+extern void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t mode);
+extern void esp_sntp_setservername(uint8_t idx, const char *server);
+extern void esp_sntp_init();
+extern void esp_sntp_stop();
+extern bool esp_sntp_enabled();
+extern void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t cb);
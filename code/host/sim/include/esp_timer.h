@@ -0,0 +1,35 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+struct sim_timer;
+typedef sim_timer *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef enum {
+    ESP_TIMER_TASK,
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+// Microseconds since the simulation started.
+extern int64_t esp_timer_get_time();
+// Callbacks run in a single esp_timer thread, as on the device.
+extern esp_err_t esp_timer_create(const esp_timer_create_args_t *args,
+    esp_timer_handle_t *handle);
+extern esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer,
+    uint64_t period_us);
+extern esp_err_t esp_timer_start_once(esp_timer_handle_t timer,
+    uint64_t timeout_us);
+extern esp_err_t esp_timer_stop(esp_timer_handle_t timer);
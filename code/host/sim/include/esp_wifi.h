@@ -0,0 +1,16 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef struct {
+    uint8_t ssid[33];
+    int8_t rssi;
+} wifi_ap_record_t;
+
+// Fails while the simulated network is down.
+extern esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap);
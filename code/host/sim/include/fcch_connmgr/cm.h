@@ -0,0 +1,21 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Host stand-in for the fcch_connmgr component: configuration comes from the
+// simulator's command line and scenario, HTTP handlers are kept in a table,
+// and MQTT messages are recorded rather than sent.
+
+#include <esp_http_server.h>
+
+typedef const char *cm_http_home_action_description_t();
+typedef void cm_http_home_action_t();
+
+extern void cm_register_conf();
+extern void cm_init();
+extern bool cm_admin_is_protected();
+extern void cm_http_register_home_action(const char *slug,
+    cm_http_home_action_description_t *description,
+    cm_http_home_action_t *action);
+extern void cm_http_register_uri_handler(const httpd_uri_t *uri);
@@ -0,0 +1,42 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum cm_conf_item_type {
+    CM_CONF_ITEM_TYPE_U16,
+    CM_CONF_ITEM_TYPE_STR,
+};
+
+union cm_conf_p_val {
+    uint16_t *u16;
+    const char **str;
+};
+
+struct cm_conf_item;
+typedef void cm_conf_default_func(cm_conf_item *item, cm_conf_p_val p_val);
+typedef void cm_conf_replace_invalid_value_func(cm_conf_item *item,
+    cm_conf_p_val p_val);
+
+struct cm_conf_item {
+    const char *slug_name;
+    const char *text_name;
+    cm_conf_item_type type;
+    cm_conf_p_val p_val;
+    cm_conf_default_func *default_func;
+    cm_conf_replace_invalid_value_func *replace_invalid_value;
+};
+
+struct cm_conf_page {
+    const char *slug_name;
+    const char *text_name;
+    cm_conf_item **items;
+    size_t items_count;
+};
+
+extern void cm_conf_register_page(cm_conf_page *page);
+extern cm_conf_default_func cm_conf_default_u16_0;
+extern cm_conf_default_func cm_conf_default_str_empty;
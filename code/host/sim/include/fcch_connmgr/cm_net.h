@@ -0,0 +1,24 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+struct cm_net_ap_info {
+    bool enabled;
+    const char *network;
+    uint32_t ip;
+};
+
+struct cm_net_sta_info {
+    bool connected;
+    const char *network;
+    bool has_ip;
+    uint32_t ip;
+};
+
+extern const char *cm_net_hostname;
+
+extern cm_net_ap_info cm_net_get_ap_info();
+extern cm_net_sta_info cm_net_get_sta_info();
@@ -0,0 +1,39 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+static inline uint8_t cm_util_hex_char_to_uint(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return 0;
+}
+
+template<typename T>
+struct AutoFree {
+    T *val = nullptr;
+
+    ~AutoFree() {
+        free(val);
+    }
+};
+
+template<typename T>
+struct AutoCleanup {
+    std::function<void(T)> cleanup;
+    T val;
+
+    ~AutoCleanup() {
+        cleanup(val);
+    }
+};
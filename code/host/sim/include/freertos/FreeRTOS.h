@@ -0,0 +1,58 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Host simulation of the subset of ESP-IDF FreeRTOS that the firmware uses.
+// Tasks are pthreads and ticks are derived from the host's monotonic clock.
+// Priorities and core affinity are recorded but not enforced; the host
+// scheduler decides what runs.
+
+#include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+#define configTICK_RATE_HZ 100
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) \
+    ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portNUM_PROCESSORS 2
+#define tskNO_AFFINITY 0x7fffffff
+
+// Critical sections are recursive, as on the ESP32.
+typedef struct {
+    pthread_mutex_t mutex;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP }
+#define portENTER_CRITICAL(mux) pthread_mutex_lock(&(mux)->mutex)
+#define portEXIT_CRITICAL(mux) pthread_mutex_unlock(&(mux)->mutex)
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux) portEXIT_CRITICAL(mux)
+
+struct sim_task;
+typedef sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+// Static storage is accepted for API compatibility; the simulation allocates
+// its own.
+typedef struct {
+    uint8_t dummy;
+} StaticTask_t;
+
+extern BaseType_t xPortGetCoreID();
+
+// The firmware relies on ESP-IDF headers pulling these in indirectly.
+#include "freertos/task.h"
+#include "freertos/timers.h"
@@ -0,0 +1,29 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+struct sim_ringbuf;
+typedef sim_ringbuf *RingbufHandle_t;
+
+typedef enum {
+    RINGBUF_TYPE_NOSPLIT,
+    RINGBUF_TYPE_ALLOWSPLIT,
+    RINGBUF_TYPE_BYTEBUF,
+} RingbufferType_t;
+
+typedef struct {
+    uint8_t dummy;
+} StaticRingbuffer_t;
+
+// Only RINGBUF_TYPE_NOSPLIT is simulated. Capacity accounting includes the
+// device's 8 byte item header and 4 byte alignment, so the same items fit.
+extern RingbufHandle_t xRingbufferCreateStatic(size_t size,
+    RingbufferType_t type, uint8_t *storage, StaticRingbuffer_t *buf);
+extern BaseType_t xRingbufferSend(RingbufHandle_t ring, const void *item,
+    size_t size, TickType_t ticks);
+extern void *xRingbufferReceive(RingbufHandle_t ring, size_t *size,
+    TickType_t ticks);
+extern void vRingbufferReturnItem(RingbufHandle_t ring, void *item);
@@ -0,0 +1,48 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+    eRunning,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid,
+} eTaskState;
+
+typedef struct {
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    // Thread CPU time in microseconds
+    uint32_t ulRunTimeCounter;
+    StackType_t *pxStackBase;
+    uint32_t usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+extern BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+    uint32_t stack_size, void *arg, UBaseType_t priority,
+    TaskHandle_t *handle, BaseType_t core);
+extern TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn,
+    const char *name, uint32_t stack_size, void *arg, UBaseType_t priority,
+    StackType_t *stack, StaticTask_t *tcb, BaseType_t core);
+extern void vTaskDelete(TaskHandle_t handle);
+extern void vTaskDelay(TickType_t ticks);
+extern TickType_t xTaskGetTickCount();
+extern TaskHandle_t xTaskGetHandle(const char *name);
+extern TaskHandle_t xTaskGetCurrentTaskHandle();
+// Host threads have no fixed stack to measure; this returns the configured
+// stack size.
+extern UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t handle);
+extern UBaseType_t uxTaskGetSystemState(TaskStatus_t *status,
+    UBaseType_t status_count, uint32_t *total_run_time);
+extern uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+extern BaseType_t xTaskNotifyGive(TaskHandle_t handle);
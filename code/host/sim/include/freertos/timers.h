@@ -0,0 +1,26 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+struct sim_timer;
+typedef sim_timer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+typedef struct {
+    uint8_t dummy;
+} StaticTimer_t;
+
+// Callbacks run in a single timer service thread, as on the device.
+extern TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period,
+    UBaseType_t auto_reload, void *id, TimerCallbackFunction_t cb,
+    StaticTimer_t *buf);
+extern BaseType_t xTimerStart(TimerHandle_t timer, TickType_t block);
+extern BaseType_t xTimerStop(TimerHandle_t timer, TickType_t block);
+extern BaseType_t xTimerReset(TimerHandle_t timer, TickType_t block);
+extern BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period,
+    TickType_t block);
+extern BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+extern void *pvTimerGetTimerID(TimerHandle_t timer);
@@ -0,0 +1,37 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// In-memory NVS. If the simulator's --nvs option names a file, it's loaded at
+// startup and rewritten on each commit, so state survives a "reboot".
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE,
+} nvs_open_mode_t;
+
+#define ESP_ERR_NVS_BASE 0x1100
+#define ESP_ERR_NVS_NOT_FOUND (ESP_ERR_NVS_BASE + 0x02)
+#define ESP_ERR_NVS_INVALID_LENGTH (ESP_ERR_NVS_BASE + 0x0c)
+
+extern esp_err_t nvs_open(const char *name, nvs_open_mode_t mode,
+    nvs_handle_t *handle);
+extern void nvs_close(nvs_handle_t handle);
+extern esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key,
+    void *value, size_t *length);
+extern esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key,
+    const void *value, size_t length);
+extern esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key,
+    uint32_t *value);
+extern esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key,
+    uint32_t value);
+extern esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key);
+extern esp_err_t nvs_commit(nvs_handle_t handle);
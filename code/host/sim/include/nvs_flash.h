@@ -0,0 +1,8 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "nvs.h"
+
+extern esp_err_t nvs_flash_init();
@@ -0,0 +1,19 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Kconfig defaults from main/Kconfig.projbuild.
+
+#define CONFIG_FCCH_TASK_RFID_CORE 1
+#define CONFIG_FCCH_TASK_RFID_PRIORITY 10
+#define CONFIG_FCCH_TASK_DISPATCH_CORE 1
+#define CONFIG_FCCH_TASK_DISPATCH_PRIORITY 8
+#define CONFIG_FCCH_TASK_MQTT_CORE 0
+#define CONFIG_FCCH_TASK_MQTT_PRIORITY 5
+#define CONFIG_FCCH_TASK_LCD_CORE 0
+#define CONFIG_FCCH_TASK_LCD_PRIORITY 4
+#define CONFIG_FCCH_TASK_LOADGEN_CORE 0
+#define CONFIG_FCCH_TASK_LOADGEN_PRIORITY 3
+#define CONFIG_FCCH_TASK_LOG_CORE 0
+#define CONFIG_FCCH_TASK_LOG_PRIORITY 2
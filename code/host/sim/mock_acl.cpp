@@ -0,0 +1,130 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <assert.h>
+#include <errno.h>
+#include <map>
+#include <mutex>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "mock_acl.h"
+
+static std::mutex mock_acl_lock;
+static std::map<uint32_t, bool> mock_acl_rfids;
+static uint32_t mock_acl_delay_ms;
+static bool mock_acl_up = true;
+static uint32_t mock_acl_requests;
+
+void mock_acl_set(uint32_t rfid, bool allowed) {
+    std::lock_guard<std::mutex> guard(mock_acl_lock);
+    mock_acl_rfids[rfid] = allowed;
+}
+
+void mock_acl_set_delay_ms(uint32_t delay_ms) {
+    std::lock_guard<std::mutex> guard(mock_acl_lock);
+    mock_acl_delay_ms = delay_ms;
+}
+
+void mock_acl_set_up(bool up) {
+    std::lock_guard<std::mutex> guard(mock_acl_lock);
+    mock_acl_up = up;
+}
+
+uint32_t mock_acl_get_requests() {
+    std::lock_guard<std::mutex> guard(mock_acl_lock);
+    return mock_acl_requests;
+}
+
+static void mock_acl_respond(int fd, const char *status, const char *body) {
+    char resp[256];
+    int len = snprintf(resp, sizeof(resp),
+        "HTTP/1.1 %s\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: close\r\n"
+        "\r\n"
+        "%s", status, strlen(body), body);
+    send(fd, resp, len, MSG_NOSIGNAL);
+}
+
+static void mock_acl_handle(int fd) {
+    std::string request;
+    char buf[512];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+        ssize_t ret = recv(fd, buf, sizeof(buf), 0);
+        if (ret <= 0 || request.size() > 4096)
+            return;
+        request.append(buf, ret);
+    }
+
+    bool up;
+    uint32_t delay_ms;
+    {
+        std::lock_guard<std::mutex> guard(mock_acl_lock);
+        mock_acl_requests++;
+        up = mock_acl_up;
+        delay_ms = mock_acl_delay_ms;
+    }
+    if (delay_ms)
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    if (!up) {
+        printf("mock_acl: down, dropping request\n");
+        return;
+    }
+
+    char acl[64];
+    unsigned long rfid;
+    if (sscanf(request.c_str(), "GET /api/check-access-0/%63[^/]/%lu ",
+        acl, &rfid) != 2
+    ) {
+        mock_acl_respond(fd, "404 Not Found", "");
+        return;
+    }
+    bool allowed = false;
+    {
+        std::lock_guard<std::mutex> guard(mock_acl_lock);
+        auto it = mock_acl_rfids.find(rfid);
+        if (it != mock_acl_rfids.end())
+            allowed = it->second;
+    }
+    const char *body = allowed ? "True" : "False";
+    printf("mock_acl: %s %lu: %s\n", acl, rfid, body);
+    fflush(stdout);
+    mock_acl_respond(fd, "200 OK", body);
+}
+
+int mock_acl_start(int port, bool public_bind) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(public_bind ? INADDR_ANY : INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) || listen(fd, 8)) {
+        fprintf(stderr, "mock_acl: port %d: %s\n", port, strerror(errno));
+        exit(1);
+    }
+    socklen_t addr_len = sizeof(addr);
+    getsockname(fd, (sockaddr *)&addr, &addr_len);
+    std::thread([fd] {
+        for (;;) {
+            int conn = accept(fd, NULL, NULL);
+            if (conn < 0)
+                continue;
+            std::thread([conn] {
+                mock_acl_handle(conn);
+                close(conn);
+            }).detach();
+        }
+    }).detach();
+    return ntohs(addr.sin_port);
+}
@@ -0,0 +1,21 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// A minimal ACL server implementing the API that acl_client uses:
+//   GET /api/check-access-0/<acl>/<rfid> -> "True" or "False"
+// Unknown RFIDs are denied. Used in-process by fw_sim, and standalone (for
+// pointing a real device at) by mock_acl_server.
+
+#include <stdint.h>
+
+// Listen on 127.0.0.1:port (0 for any, or all interfaces if public). Returns
+// the port.
+extern int mock_acl_start(int port, bool public_bind);
+extern void mock_acl_set(uint32_t rfid, bool allowed);
+// Delay before each response is sent.
+extern void mock_acl_set_delay_ms(uint32_t delay_ms);
+// While down, connections are closed without a response.
+extern void mock_acl_set_up(bool up);
+extern uint32_t mock_acl_get_requests();
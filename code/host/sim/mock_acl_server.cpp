@@ -0,0 +1,43 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// Standalone mock ACL server, e.g. to point a real device at:
+//   mock_acl_server --port 8080 --allow 1234 --deny 5678
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mock_acl.h"
+
+static int usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--port N] [--delay-ms N] [--allow RFID]... "
+        "[--deny RFID]...\n", argv0);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    int port = 8080;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc)
+            return usage(argv[0]);
+        const char *arg = argv[i];
+        const char *val = argv[++i];
+        if (!strcmp(arg, "--port"))
+            port = atoi(val);
+        else if (!strcmp(arg, "--delay-ms"))
+            mock_acl_set_delay_ms(strtoul(val, NULL, 0));
+        else if (!strcmp(arg, "--allow"))
+            mock_acl_set(strtoul(val, NULL, 0), true);
+        else if (!strcmp(arg, "--deny"))
+            mock_acl_set(strtoul(val, NULL, 0), false);
+        else
+            return usage(argv[0]);
+    }
+    port = mock_acl_start(port, true);
+    printf("mock_acl: listening on port %d\n", port);
+    fflush(stdout);
+    for (;;)
+        pause();
+}
@@ -0,0 +1,78 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Simulator-side interface to the virtual peripherals and connmgr stand-in,
+// used by sim_main.cpp. The firmware only sees the ESP-IDF style APIs in
+// include/.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <esp_log.h>
+
+// Everything observable that the firmware does, in time order. Times are
+// esp_timer_get_time().
+enum sim_event_type {
+    // A GPIO output changed level
+    SIM_EVENT_GPIO,
+    // An MQTT message was published
+    SIM_EVENT_MQTT,
+    // The LCD was redrawn; text is what was printed
+    SIM_EVENT_LCD,
+};
+
+struct sim_event {
+    int64_t time_us;
+    sim_event_type type;
+    int pin;
+    int level;
+    std::string text;
+};
+
+extern void sim_event_record(sim_event_type type, int pin, int level,
+    const char *text);
+// Events recorded at or after since_us.
+extern std::vector<sim_event> sim_events_since(int64_t since_us);
+extern const char *sim_event_type_name(sim_event_type type);
+
+// Sets the name of the calling (non-firmware) thread, as shown by /tasks.
+extern void sim_thread_set_name(const char *name);
+
+// 0 delivers bytes instantly; otherwise each byte takes 10 bit times.
+extern void sim_uart_set_baud(uint32_t baud);
+// Queue bytes for the firmware's UART. Bytes start arriving once any already
+// queued bytes have, or now if there are none. Returns the time at which the
+// last byte will have arrived.
+extern int64_t sim_uart_feed(const void *data, size_t len);
+// As sim_uart_feed(), but the first byte arrives no earlier than at_us.
+extern int64_t sim_uart_feed_at(int64_t at_us, const void *data, size_t len);
+
+extern void sim_log_set_level(esp_log_level_t level);
+// Persist NVS to this file; it's loaded immediately if it exists.
+extern void sim_nvs_set_file(const char *path);
+
+// Set a configuration item, given as "<page>.<item>=<value>" using slug
+// names, e.g. "acl.h=127.0.0.1". Before cm_init() the value is saved and
+// applied then, as if it had been stored in flash; afterwards it takes effect
+// immediately, as if saved from the web UI.
+extern bool sim_conf_set(const char *assignment);
+extern void sim_net_set_up(bool up);
+extern bool sim_net_is_up();
+extern void sim_mqtt_set_connected(bool connected);
+// Run a home page action by slug name.
+extern bool sim_action_run(const char *slug);
+
+// Invoke the handler for a registered URI, as if fetched with GET.
+extern bool sim_http_get(const char *uri, std::string *body,
+    std::string *content_type);
+// Serve registered URIs on 127.0.0.1:port (0 for any). Returns the port.
+extern int sim_http_serve(int port);
+
+// Most recent text printed to the LCD.
+extern std::string sim_lcd_text();
+// Write the framebuffer as a binary PPM.
+extern bool sim_lcd_write_ppm(const char *path);
@@ -0,0 +1,221 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// Stand-in for fcch_connmgr: configuration pages, home page actions, network
+// state and MQTT publishing. (HTTP URI handlers live in sim_http.cpp.)
+
+#include <mutex>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <esp_log.h>
+
+#include "fcch_connmgr/cm.h"
+#include "fcch_connmgr/cm_conf.h"
+#include "fcch_connmgr/cm_mqtt.h"
+#include "fcch_connmgr/cm_net.h"
+#include "fcch_connmgr/cm_util.h"
+#include "sim.h"
+
+static const char *TAG = "cm";
+
+// Configuration
+
+static std::vector<cm_conf_page *> sim_conf_pages;
+static std::vector<std::string> sim_conf_pending;
+static bool sim_conf_initialized;
+
+void cm_conf_default_u16_0(cm_conf_item *item, cm_conf_p_val p_val) {
+    *p_val.u16 = 0;
+}
+
+void cm_conf_default_str_empty(cm_conf_item *item, cm_conf_p_val p_val) {
+    *p_val.str = "";
+}
+
+void cm_conf_register_page(cm_conf_page *page) {
+    sim_conf_pages.push_back(page);
+}
+
+static cm_conf_item *sim_conf_find(const std::string &page_slug,
+    const std::string &item_slug
+) {
+    for (cm_conf_page *page : sim_conf_pages) {
+        if (page_slug != page->slug_name)
+            continue;
+        for (size_t i = 0; i < page->items_count; i++) {
+            if (item_slug == page->items[i]->slug_name)
+                return page->items[i];
+        }
+    }
+    return nullptr;
+}
+
+// Values are never freed, since the firmware may still hold (and conf_watch
+// compares) the old pointer.
+static bool sim_conf_apply(const std::string &assignment) {
+    size_t dot = assignment.find('.');
+    size_t eq = assignment.find('=');
+    if (dot == std::string::npos || eq == std::string::npos || eq < dot)
+        return false;
+    cm_conf_item *item = sim_conf_find(assignment.substr(0, dot),
+        assignment.substr(dot + 1, eq - dot - 1));
+    if (!item)
+        return false;
+    std::string value = assignment.substr(eq + 1);
+    switch (item->type) {
+    case CM_CONF_ITEM_TYPE_U16:
+        *item->p_val.u16 = (uint16_t)strtoul(value.c_str(), NULL, 0);
+        break;
+    case CM_CONF_ITEM_TYPE_STR:
+        *item->p_val.str = strdup(value.c_str());
+        break;
+    default:
+        return false;
+    }
+    if (item->replace_invalid_value)
+        item->replace_invalid_value(item, item->p_val);
+    return true;
+}
+
+bool sim_conf_set(const char *assignment) {
+    if (!sim_conf_initialized) {
+        sim_conf_pending.push_back(assignment);
+        return true;
+    }
+    return sim_conf_apply(assignment);
+}
+
+static void sim_conf_default_status_period(cm_conf_item *item,
+    cm_conf_p_val p_val
+) {
+    *p_val.u16 = 60;
+}
+
+uint16_t cm_mqtt_status_period;
+static cm_conf_item sim_mqtt_item_status_period = {
+    .slug_name = "sp", // Status Period
+    .text_name = "Status Publish Period (Seconds)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &cm_mqtt_status_period },
+    .default_func = &sim_conf_default_status_period,
+};
+
+static cm_conf_item *sim_mqtt_items[] = {
+    &sim_mqtt_item_status_period,
+};
+
+static cm_conf_page sim_mqtt_page = {
+    .slug_name = "mq", // MQtt
+    .text_name = "MQTT",
+    .items = sim_mqtt_items,
+    .items_count = ARRAY_SIZE(sim_mqtt_items),
+};
+
+void cm_register_conf() {
+    cm_conf_register_page(&sim_mqtt_page);
+}
+
+void cm_init() {
+    for (cm_conf_page *page : sim_conf_pages) {
+        for (size_t i = 0; i < page->items_count; i++) {
+            cm_conf_item *item = page->items[i];
+            item->default_func(item, item->p_val);
+        }
+    }
+    for (const std::string &assignment : sim_conf_pending) {
+        if (!sim_conf_apply(assignment)) {
+            fprintf(stderr, "sim: unknown conf item: %s\n",
+                assignment.c_str());
+            exit(1);
+        }
+    }
+    sim_conf_initialized = true;
+}
+
+// Home page actions
+
+struct sim_action {
+    const char *slug;
+    cm_http_home_action_description_t *description;
+    cm_http_home_action_t *action;
+};
+
+static std::vector<sim_action> sim_actions;
+
+bool cm_admin_is_protected() {
+    return false;
+}
+
+void cm_http_register_home_action(const char *slug,
+    cm_http_home_action_description_t *description,
+    cm_http_home_action_t *action
+) {
+    sim_actions.push_back({slug, description, action});
+}
+
+bool sim_action_run(const char *slug) {
+    for (const sim_action &a : sim_actions) {
+        if (strcmp(a.slug, slug))
+            continue;
+        a.action();
+        ESP_LOGI(TAG, "action %s: %s", slug, a.description());
+        return true;
+    }
+    return false;
+}
+
+// Network
+
+static bool sim_net_up = true;
+static bool sim_mqtt_connected = true;
+
+const char *cm_net_hostname = "fcch-sim";
+const char *cm_mqtt_client_name = "fcch-sim";
+
+void sim_net_set_up(bool up) {
+    __atomic_store_n(&sim_net_up, up, __ATOMIC_SEQ_CST);
+}
+
+bool sim_net_is_up() {
+    return __atomic_load_n(&sim_net_up, __ATOMIC_SEQ_CST);
+}
+
+void sim_mqtt_set_connected(bool connected) {
+    __atomic_store_n(&sim_mqtt_connected, connected, __ATOMIC_SEQ_CST);
+}
+
+cm_net_ap_info cm_net_get_ap_info() {
+    return {
+        .enabled = false,
+        .network = "",
+        .ip = 0,
+    };
+}
+
+cm_net_sta_info cm_net_get_sta_info() {
+    bool up = sim_net_is_up();
+    return {
+        .connected = up,
+        .network = "sim",
+        .has_ip = up,
+        // 127.0.0.1, first octet in the low byte
+        .ip = up ? 0x0100007fU : 0,
+    };
+}
+
+cm_mqtt_info cm_mqtt_get_info() {
+    return {
+        .enabled = true,
+        .connected = sim_net_is_up() &&
+            __atomic_load_n(&sim_mqtt_connected, __ATOMIC_SEQ_CST),
+    };
+}
+
+// Messages are dropped while disconnected, as the MQTT client would.
+void cm_mqtt_publish_stat(const char *msg) {
+    if (!cm_mqtt_get_info().connected)
+        return;
+    sim_event_record(SIM_EVENT_MQTT, 0, 0, msg);
+}
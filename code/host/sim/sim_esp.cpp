@@ -0,0 +1,466 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// ESP-IDF odds and ends: errors, logging, heap, WiFi, SNTP, NVS, GPIO and the
+// virtual UART, plus the simulator's event log.
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdarg.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <driver/gpio.h>
+#include <driver/uart.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <nvs.h>
+#include <nvs_flash.h>
+
+#include "sim.h"
+
+const char *esp_err_to_name(esp_err_t err) {
+    switch (err) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND:
+        return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_INVALID_LENGTH:
+        return "ESP_ERR_NVS_INVALID_LENGTH";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+// Event log
+
+static std::mutex sim_events_lock;
+static std::vector<sim_event> sim_events;
+
+const char *sim_event_type_name(sim_event_type type) {
+    switch (type) {
+    case SIM_EVENT_GPIO:
+        return "gpio";
+    case SIM_EVENT_MQTT:
+        return "mqtt";
+    case SIM_EVENT_LCD:
+        return "lcd";
+    default:
+        return "?";
+    }
+}
+
+void sim_event_record(sim_event_type type, int pin, int level,
+    const char *text
+) {
+    sim_event ev{esp_timer_get_time(), type, pin, level, text ? text : ""};
+    {
+        std::lock_guard<std::mutex> guard(sim_events_lock);
+        sim_events.push_back(ev);
+    }
+    std::string shown = ev.text;
+    for (char &c : shown) {
+        if (c == '\n')
+            c = '|';
+    }
+    if (type == SIM_EVENT_GPIO) {
+        printf("sim: %10.3f ms gpio %d = %d\n", ev.time_us / 1000.0, pin,
+            level);
+    } else {
+        printf("sim: %10.3f ms %s %s\n", ev.time_us / 1000.0,
+            sim_event_type_name(type), shown.c_str());
+    }
+    fflush(stdout);
+}
+
+std::vector<sim_event> sim_events_since(int64_t since_us) {
+    std::lock_guard<std::mutex> guard(sim_events_lock);
+    std::vector<sim_event> ret;
+    for (const sim_event &ev : sim_events) {
+        if (ev.time_us >= since_us)
+            ret.push_back(ev);
+    }
+    return ret;
+}
+
+// Logging
+
+static esp_log_level_t sim_log_level = ESP_LOG_INFO;
+static vprintf_like_t sim_log_vprintf = &vprintf;
+
+void sim_log_set_level(esp_log_level_t level) {
+    sim_log_level = level;
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+}
+
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func) {
+    return __atomic_exchange_n(&sim_log_vprintf, func, __ATOMIC_SEQ_CST);
+}
+
+uint32_t esp_log_timestamp() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static int sim_log_printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vprintf_like_t func = __atomic_load_n(&sim_log_vprintf, __ATOMIC_SEQ_CST);
+    int ret = func(format, args);
+    va_end(args);
+    return ret;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag,
+    const char *format, ...
+) {
+    if (level > sim_log_level)
+        return;
+    char msg[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(msg, sizeof(msg), format, args);
+    va_end(args);
+    static const char letters[] = "NEWIDV";
+    sim_log_printf("%c (%lu) %s: %s\n", letters[level],
+        (unsigned long)esp_log_timestamp(), tag, msg);
+}
+
+// Heap: the host heap says nothing about the device's, so report nothing.
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return 0;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    return 0;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return 0;
+}
+
+// WiFi and SNTP
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap) {
+    if (!sim_net_is_up())
+        return ESP_FAIL;
+    *ap = {};
+    strcpy((char *)ap->ssid, "sim");
+    ap->rssi = -50;
+    return ESP_OK;
+}
+
+static bool sim_sntp_enabled;
+static sntp_sync_time_cb_t sim_sntp_cb;
+
+void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t mode) {
+}
+
+void esp_sntp_setservername(uint8_t idx, const char *server) {
+}
+
+void esp_sntp_init() {
+    sim_sntp_enabled = true;
+    std::thread([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        sntp_sync_time_cb_t cb = sim_sntp_cb;
+        if (!sim_sntp_enabled || !cb)
+            return;
+        timeval tv;
+        gettimeofday(&tv, NULL);
+        cb(&tv);
+    }).detach();
+}
+
+void esp_sntp_stop() {
+    sim_sntp_enabled = false;
+}
+
+bool esp_sntp_enabled() {
+    return sim_sntp_enabled;
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t cb) {
+    sim_sntp_cb = cb;
+}
+
+// NVS: namespace -> key -> value. Handles index sim_nvs_namespaces.
+
+static std::mutex sim_nvs_lock;
+static std::vector<std::string> sim_nvs_namespaces;
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>>
+    sim_nvs_data;
+static std::string sim_nvs_file;
+
+static void sim_nvs_load() {
+    FILE *f = fopen(sim_nvs_file.c_str(), "r");
+    if (!f)
+        return;
+    char ns[64], key[64];
+    size_t len;
+    while (fscanf(f, "%63s %63s %zu", ns, key, &len) == 3) {
+        std::vector<uint8_t> value(len);
+        for (size_t i = 0; i < len; i++) {
+            unsigned int byte;
+            if (fscanf(f, "%2x", &byte) != 1)
+                break;
+            value[i] = byte;
+        }
+        sim_nvs_data[ns][key] = value;
+    }
+    fclose(f);
+}
+
+// Must be called with sim_nvs_lock held.
+static void sim_nvs_save() {
+    if (sim_nvs_file.empty())
+        return;
+    std::string tmp = sim_nvs_file + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "w");
+    if (!f)
+        return;
+    for (const auto &ns : sim_nvs_data) {
+        for (const auto &kv : ns.second) {
+            fprintf(f, "%s %s %zu ", ns.first.c_str(), kv.first.c_str(),
+                kv.second.size());
+            for (uint8_t byte : kv.second)
+                fprintf(f, "%02x", byte);
+            fprintf(f, "\n");
+        }
+    }
+    fclose(f);
+    rename(tmp.c_str(), sim_nvs_file.c_str());
+}
+
+void sim_nvs_set_file(const char *path) {
+    std::lock_guard<std::mutex> guard(sim_nvs_lock);
+    sim_nvs_file = path;
+    sim_nvs_load();
+}
+
+esp_err_t nvs_flash_init() {
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode,
+    nvs_handle_t *handle
+) {
+    std::lock_guard<std::mutex> guard(sim_nvs_lock);
+    if (mode == NVS_READONLY && !sim_nvs_data.count(name))
+        return ESP_ERR_NVS_NOT_FOUND;
+    sim_nvs_data[name];
+    sim_nvs_namespaces.push_back(name);
+    *handle = sim_nvs_namespaces.size();
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+}
+
+static std::map<std::string, std::vector<uint8_t>> &sim_nvs_ns(
+    nvs_handle_t handle
+) {
+    assert(handle >= 1 && handle <= sim_nvs_namespaces.size());
+    return sim_nvs_data[sim_nvs_namespaces[handle - 1]];
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value,
+    size_t *length
+) {
+    std::lock_guard<std::mutex> guard(sim_nvs_lock);
+    auto &ns = sim_nvs_ns(handle);
+    auto it = ns.find(key);
+    if (it == ns.end())
+        return ESP_ERR_NVS_NOT_FOUND;
+    const std::vector<uint8_t> &stored = it->second;
+    if (!value) {
+        *length = stored.size();
+        return ESP_OK;
+    }
+    if (*length < stored.size())
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    memcpy(value, stored.data(), stored.size());
+    *length = stored.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key,
+    const void *value, size_t length
+) {
+    std::lock_guard<std::mutex> guard(sim_nvs_lock);
+    const uint8_t *p = (const uint8_t *)value;
+    sim_nvs_ns(handle)[key] = std::vector<uint8_t>(p, p + length);
+    return ESP_OK;
+}
+
+// Stored as 4-byte blobs; real NVS keeps the type, but nothing here mixes
+// types for one key.
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *value) {
+    size_t length = sizeof(*value);
+    esp_err_t err = nvs_get_blob(handle, key, value, &length);
+    if (err == ESP_OK && length != sizeof(*value))
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    return err;
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value) {
+    return nvs_set_blob(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    std::lock_guard<std::mutex> guard(sim_nvs_lock);
+    if (!sim_nvs_ns(handle).erase(key))
+        return ESP_ERR_NVS_NOT_FOUND;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> guard(sim_nvs_lock);
+    sim_nvs_save();
+    return ESP_OK;
+}
+
+// GPIO
+
+static std::mutex sim_gpio_lock;
+static int sim_gpio_levels[GPIO_NUM_MAX];
+
+esp_err_t gpio_reset_pin(gpio_num_t pin) {
+    if (pin < 0 || pin >= GPIO_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t pin, gpio_mode_t mode) {
+    if (pin < 0 || pin >= GPIO_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level) {
+    if (pin < 0 || pin >= GPIO_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+    level = !!level;
+    std::lock_guard<std::mutex> guard(sim_gpio_lock);
+    if (sim_gpio_levels[pin] == (int)level)
+        return ESP_OK;
+    sim_gpio_levels[pin] = level;
+    sim_event_record(SIM_EVENT_GPIO, pin, level, NULL);
+    return ESP_OK;
+}
+
+// Virtual UART. There's a single receiver; the firmware only opens one.
+
+struct sim_uart_byte {
+    uint8_t data;
+    int64_t arrival_us;
+};
+
+static std::mutex sim_uart_lock;
+static std::condition_variable sim_uart_cv;
+static std::deque<sim_uart_byte> sim_uart_rx;
+static uint32_t sim_uart_baud = 9600;
+static int64_t sim_uart_last_arrival_us;
+
+void sim_uart_set_baud(uint32_t baud) {
+    std::lock_guard<std::mutex> guard(sim_uart_lock);
+    sim_uart_baud = baud;
+}
+
+int64_t sim_uart_feed_at(int64_t at_us, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    int64_t now = esp_timer_get_time();
+    std::lock_guard<std::mutex> guard(sim_uart_lock);
+    // 8N1: 10 bit times per byte
+    int64_t byte_us = sim_uart_baud ? (10 * 1000000LL) / sim_uart_baud : 0;
+    int64_t t = std::max(std::max(now, at_us), sim_uart_last_arrival_us);
+    for (size_t i = 0; i < len; i++) {
+        t += byte_us;
+        sim_uart_rx.push_back({p[i], t});
+    }
+    sim_uart_last_arrival_us = t;
+    sim_uart_cv.notify_all();
+    return t;
+}
+
+int64_t sim_uart_feed(const void *data, size_t len) {
+    return sim_uart_feed_at(0, data, len);
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size,
+    int tx_buffer_size, int queue_size, QueueHandle_t *queue,
+    int intr_alloc_flags
+) {
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config) {
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts) {
+    return ESP_OK;
+}
+
+// Must be called with sim_uart_lock held.
+static size_t sim_uart_arrived(int64_t now) {
+    size_t count = 0;
+    for (const sim_uart_byte &b : sim_uart_rx) {
+        if (b.arrival_us > now)
+            break;
+        count++;
+    }
+    return count;
+}
+
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t length,
+    TickType_t ticks
+) {
+    int64_t deadline = esp_timer_get_time() +
+        (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+    std::unique_lock<std::mutex> guard(sim_uart_lock);
+    for (;;) {
+        int64_t now = esp_timer_get_time();
+        size_t arrived = sim_uart_arrived(now);
+        if (arrived >= length || now >= deadline)
+            break;
+        // Wake when the next byte arrives, or new bytes are queued.
+        int64_t wake = deadline;
+        if (arrived < sim_uart_rx.size())
+            wake = std::min(wake, sim_uart_rx[arrived].arrival_us);
+        sim_uart_cv.wait_for(guard, std::chrono::microseconds(wake - now));
+    }
+    size_t count = std::min((size_t)length,
+        sim_uart_arrived(esp_timer_get_time()));
+    uint8_t *p = (uint8_t *)buf;
+    for (size_t i = 0; i < count; i++) {
+        p[i] = sim_uart_rx.front().data;
+        sim_uart_rx.pop_front();
+    }
+    return count;
+}
@@ -0,0 +1,390 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// esp_http_server handlers, served by a minimal single-threaded HTTP/1.1
+// server like the device's, and an esp_http_client over host sockets.
+
+#include <errno.h>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include <esp_http_client.h>
+#include <esp_http_server.h>
+#include <esp_log.h>
+
+#include "fcch_connmgr/cm.h"
+#include "sim.h"
+
+static const char *TAG = "sim_http";
+
+// Server
+
+struct sim_http_response {
+    // Connection to write to, or -1 to capture into body
+    int fd;
+    std::string type = "text/html";
+    std::vector<std::pair<std::string, std::string>> headers;
+    bool started;
+    bool finished;
+    std::string body;
+};
+
+static std::mutex sim_http_lock;
+static std::vector<const httpd_uri_t *> sim_http_uris;
+
+void cm_http_register_uri_handler(const httpd_uri_t *uri) {
+    std::lock_guard<std::mutex> guard(sim_http_lock);
+    sim_http_uris.push_back(uri);
+}
+
+static const httpd_uri_t *sim_http_find(const char *uri) {
+    size_t len = strcspn(uri, "?");
+    std::lock_guard<std::mutex> guard(sim_http_lock);
+    for (const httpd_uri_t *h : sim_http_uris) {
+        if (strlen(h->uri) == len && !strncmp(h->uri, uri, len))
+            return h;
+    }
+    return nullptr;
+}
+
+static bool sim_http_write(int fd, const char *buf, size_t len) {
+    while (len) {
+        ssize_t ret = send(fd, buf, len, MSG_NOSIGNAL);
+        if (ret <= 0)
+            return false;
+        buf += ret;
+        len -= ret;
+    }
+    return true;
+}
+
+static bool sim_http_write_str(int fd, const std::string &s) {
+    return sim_http_write(fd, s.data(), s.size());
+}
+
+static std::string sim_http_headers(sim_http_response *resp,
+    const char *status, const std::string &length_hdr
+) {
+    std::string hdrs = std::string("HTTP/1.1 ") + status + "\r\n";
+    hdrs += "Content-Type: " + resp->type + "\r\n";
+    for (const auto &h : resp->headers)
+        hdrs += h.first + ": " + h.second + "\r\n";
+    hdrs += length_hdr + "\r\nConnection: close\r\n\r\n";
+    return hdrs;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type) {
+    req->sim->type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field,
+    const char *value
+) {
+    req->sim->headers.emplace_back(field, value);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t len) {
+    sim_http_response *resp = req->sim;
+    if (resp->started)
+        return ESP_ERR_INVALID_STATE;
+    if (len == HTTPD_RESP_USE_STRLEN)
+        len = buf ? strlen(buf) : 0;
+    resp->started = true;
+    resp->finished = true;
+    if (resp->fd < 0) {
+        resp->body.append(buf, len);
+        return ESP_OK;
+    }
+    std::string hdrs = sim_http_headers(resp, "200 OK",
+        "Content-Length: " + std::to_string(len));
+    if (!sim_http_write_str(resp->fd, hdrs) ||
+        !sim_http_write(resp->fd, buf, len)
+    ) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf,
+    ssize_t len
+) {
+    sim_http_response *resp = req->sim;
+    if (resp->finished)
+        return ESP_ERR_INVALID_STATE;
+    if (len == HTTPD_RESP_USE_STRLEN)
+        len = buf ? strlen(buf) : 0;
+    if (!buf)
+        len = 0;
+    bool started = resp->started;
+    resp->started = true;
+    if (!len)
+        resp->finished = true;
+    if (resp->fd < 0) {
+        resp->body.append(buf ? buf : "", len);
+        return ESP_OK;
+    }
+    if (!started) {
+        std::string hdrs = sim_http_headers(resp, "200 OK",
+            "Transfer-Encoding: chunked");
+        if (!sim_http_write_str(resp->fd, hdrs))
+            return ESP_FAIL;
+    }
+    char size[16];
+    snprintf(size, sizeof(size), "%zx\r\n", (size_t)len);
+    if (!sim_http_write(resp->fd, size, strlen(size)) ||
+        !sim_http_write(resp->fd, buf, len) ||
+        !sim_http_write(resp->fd, "\r\n", 2)
+    ) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_sendstr(httpd_req_t *req, const char *str) {
+    return httpd_resp_send(req, str, HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t httpd_resp_sendstr_chunk(httpd_req_t *req, const char *str) {
+    return httpd_resp_send_chunk(req, str, HTTPD_RESP_USE_STRLEN);
+}
+
+static esp_err_t sim_http_invoke(const httpd_uri_t *h, const char *uri,
+    sim_http_response *resp
+) {
+    httpd_req_t req{};
+    req.method = HTTP_GET;
+    snprintf(req.uri, sizeof(req.uri), "%s", uri);
+    req.user_ctx = h->user_ctx;
+    req.sim = resp;
+    return h->handler(&req);
+}
+
+bool sim_http_get(const char *uri, std::string *body,
+    std::string *content_type
+) {
+    const httpd_uri_t *h = sim_http_find(uri);
+    if (!h)
+        return false;
+    sim_http_response resp{};
+    resp.fd = -1;
+    if (sim_http_invoke(h, uri, &resp) != ESP_OK)
+        return false;
+    if (body)
+        *body = resp.body;
+    if (content_type)
+        *content_type = resp.type;
+    return true;
+}
+
+static void sim_http_send_error(int fd, const char *status) {
+    sim_http_response resp{};
+    resp.fd = fd;
+    resp.type = "text/plain";
+    std::string body = std::string(status) + "\n";
+    sim_http_write_str(fd, sim_http_headers(&resp, status,
+        "Content-Length: " + std::to_string(body.size())) + body);
+}
+
+static void sim_http_handle(int fd) {
+    std::string request;
+    char buf[512];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+        ssize_t ret = recv(fd, buf, sizeof(buf), 0);
+        if (ret <= 0 || request.size() > 4096)
+            return;
+        request.append(buf, ret);
+    }
+    char method[8], uri[513];
+    if (sscanf(request.c_str(), "%7s %512s", method, uri) != 2)
+        return sim_http_send_error(fd, "400 Bad Request");
+    if (strcmp(method, "GET"))
+        return sim_http_send_error(fd, "405 Method Not Allowed");
+    const httpd_uri_t *h = sim_http_find(uri);
+    if (!h)
+        return sim_http_send_error(fd, "404 Not Found");
+    sim_http_response resp{};
+    resp.fd = fd;
+    esp_err_t err = sim_http_invoke(h, uri, &resp);
+    if (err != ESP_OK && !resp.started)
+        sim_http_send_error(fd, "500 Internal Server Error");
+}
+
+int sim_http_serve(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) || listen(fd, 4)) {
+        fprintf(stderr, "sim: http port %d: %s\n", port, strerror(errno));
+        exit(1);
+    }
+    socklen_t addr_len = sizeof(addr);
+    getsockname(fd, (sockaddr *)&addr, &addr_len);
+    std::thread([fd] {
+        sim_thread_set_name("httpd");
+        for (;;) {
+            int conn = accept(fd, NULL, NULL);
+            if (conn < 0)
+                continue;
+            sim_http_handle(conn);
+            close(conn);
+        }
+    }).detach();
+    return ntohs(addr.sin_port);
+}
+
+// Client
+
+struct sim_http_client {
+    std::string host;
+    int port;
+    std::string path;
+    std::string user_agent;
+    int timeout_ms;
+    int fd = -1;
+    int status_code;
+    int64_t content_length;
+    // Body bytes received along with the headers
+    std::string body;
+    size_t body_read;
+};
+
+esp_http_client_handle_t esp_http_client_init(
+    const esp_http_client_config_t *config
+) {
+    if (!config->host || !config->path)
+        return NULL;
+    sim_http_client *client = new sim_http_client{};
+    client->host = config->host;
+    client->port = config->port ? config->port : 80;
+    client->path = config->path;
+    client->user_agent = config->user_agent ? config->user_agent : "";
+    client->timeout_ms = config->timeout_ms ? config->timeout_ms : 5000;
+    return client;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client) {
+    esp_http_client_close(client);
+    delete client;
+    return ESP_OK;
+}
+
+static int sim_http_connect(const sim_http_client *client) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *res;
+    std::string port = std::to_string(client->port);
+    if (getaddrinfo(client->host.c_str(), port.c_str(), &hints, &res))
+        return -1;
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    timeval tv{
+        .tv_sec = client->timeout_ms / 1000,
+        .tv_usec = (client->timeout_ms % 1000) * 1000,
+    };
+    if (fd >= 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (connect(fd, res->ai_addr, res->ai_addrlen)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client,
+    int write_len
+) {
+    if (!sim_net_is_up())
+        return ESP_FAIL;
+    client->fd = sim_http_connect(client);
+    if (client->fd < 0) {
+        ESP_LOGE(TAG, "connect %s:%d failed", client->host.c_str(),
+            client->port);
+        return ESP_FAIL;
+    }
+    std::string req = "GET " + client->path + " HTTP/1.1\r\n" +
+        "Host: " + client->host + "\r\n" +
+        "User-Agent: " + client->user_agent + "\r\n" +
+        "Content-Length: " + std::to_string(write_len) + "\r\n\r\n";
+    if (!sim_http_write_str(client->fd, req))
+        return ESP_FAIL;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client) {
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+    return ESP_OK;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client) {
+    std::string resp;
+    size_t end;
+    char buf[256];
+    while ((end = resp.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t ret = recv(client->fd, buf, sizeof(buf), 0);
+        if (ret <= 0 || resp.size() > 4096)
+            return ESP_FAIL;
+        resp.append(buf, ret);
+    }
+    if (sscanf(resp.c_str(), "HTTP/1.%*d %d", &client->status_code) != 1)
+        return ESP_FAIL;
+    client->content_length = 0;
+    size_t pos = 0;
+    while ((pos = resp.find("\r\n", pos)) != std::string::npos && pos < end) {
+        pos += 2;
+        if (!strncasecmp(resp.c_str() + pos, "Content-Length:", 15))
+            client->content_length = strtoll(resp.c_str() + pos + 15, NULL, 10);
+    }
+    client->body = resp.substr(end + 4);
+    client->body_read = 0;
+    return client->content_length;
+}
+
+int esp_http_client_read_response(esp_http_client_handle_t client,
+    char *buf, int len
+) {
+    int total = 0;
+    while (total < len) {
+        if (client->body_read < client->body.size()) {
+            size_t n = std::min((size_t)(len - total),
+                client->body.size() - client->body_read);
+            memcpy(buf + total, client->body.data() + client->body_read, n);
+            client->body_read += n;
+            total += n;
+            continue;
+        }
+        if ((int64_t)client->body_read >= client->content_length)
+            break;
+        char tmp[256];
+        ssize_t ret = recv(client->fd, tmp, sizeof(tmp), 0);
+        if (ret <= 0)
+            break;
+        client->body.append(tmp, ret);
+    }
+    return total;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client) {
+    return client->status_code;
+}
@@ -0,0 +1,164 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// Headless LCD: see include/LovyanGFX.hpp.
+
+#include <algorithm>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+#include <LovyanGFX.hpp>
+
+#include "sim.h"
+
+static std::mutex sim_lcd_lock;
+static std::vector<uint16_t> sim_lcd_fb;
+static int32_t sim_lcd_width;
+static int32_t sim_lcd_height;
+static std::string sim_lcd_last_text;
+
+namespace lgfx {
+
+void LovyanGFX::resize(int32_t width, int32_t height) {
+    m_width = width;
+    m_height = height;
+    m_fb.assign(m_width * m_height, 0);
+}
+
+void LovyanGFX::fill(int32_t x, int32_t y, int32_t w, int32_t h,
+    uint16_t color
+) {
+    int32_t x0 = std::max(x, 0);
+    int32_t y0 = std::max(y, 0);
+    int32_t x1 = std::min(x + w, m_width);
+    int32_t y1 = std::min(y + h, m_height);
+    for (int32_t row = y0; row < y1; row++) {
+        for (int32_t col = x0; col < x1; col++)
+            m_fb[row * m_width + col] = color;
+    }
+}
+
+void LovyanGFX::clear(uint16_t color) {
+    std::fill(m_fb.begin(), m_fb.end(), color);
+    m_text.clear();
+}
+
+void LovyanGFX::fillRect(int32_t x, int32_t y, int32_t w, int32_t h) {
+    fill(x, y, w, h, m_color);
+}
+
+// Cells are 6x8 pixels, scaled by the text size, as for LovyanGFX's default
+// font; lines wrap at the right edge.
+size_t LovyanGFX::println(const char *s) {
+    int32_t cell_w = 6 * m_text_size;
+    int32_t cell_h = 8 * m_text_size;
+    for (const char *p = s; *p; p++) {
+        if (*p == '\n') {
+            m_cursor_x = 0;
+            m_cursor_y += cell_h;
+            continue;
+        }
+        if (m_cursor_x + cell_w > m_width) {
+            m_cursor_x = 0;
+            m_cursor_y += cell_h;
+        }
+        for (int bit = 0; bit < 8; bit++) {
+            if (*p & (1 << bit)) {
+                fill(m_cursor_x, m_cursor_y + bit * m_text_size,
+                    cell_w - m_text_size, m_text_size, m_text_color);
+            }
+        }
+        m_cursor_x += cell_w;
+    }
+    m_cursor_x = 0;
+    m_cursor_y += cell_h;
+    m_text += s;
+    m_text += "\n";
+    return strlen(s) + 1;
+}
+
+size_t LovyanGFX::pushImage(int32_t x, int32_t y, int32_t w, int32_t h,
+    const uint16_t *data
+) {
+    size_t count = 0;
+    for (int32_t row = std::max(y, 0); row < std::min(y + h, m_height);
+        row++
+    ) {
+        for (int32_t col = std::max(x, 0); col < std::min(x + w, m_width);
+            col++
+        ) {
+            m_fb[row * m_width + col] = data[(row - y) * w + (col - x)];
+            count++;
+        }
+    }
+    return count;
+}
+
+bool LGFX_Device::init() {
+    auto cfg = m_panel->config();
+    resize(cfg.panel_width, cfg.panel_height);
+    return true;
+}
+
+void LGFX_Device::setBrightness(uint8_t brightness) {
+}
+
+size_t LGFX_Device::pushImage(int32_t x, int32_t y, int32_t w, int32_t h,
+    const uint16_t *data
+) {
+    m_pushed = true;
+    return LovyanGFX::pushImage(x, y, w, h, data);
+}
+
+void LGFX_Device::endWrite() {
+    if (!m_pushed)
+        return;
+    m_pushed = false;
+    std::string text = m_text;
+    if (!text.empty() && text.back() == '\n')
+        text.pop_back();
+    {
+        std::lock_guard<std::mutex> guard(sim_lcd_lock);
+        sim_lcd_fb = m_fb;
+        sim_lcd_width = m_width;
+        sim_lcd_height = m_height;
+        sim_lcd_last_text = text;
+    }
+    sim_event_record(SIM_EVENT_LCD, 0, 0, text.c_str());
+}
+
+void *LGFX_Sprite::createSprite(int32_t w, int32_t h) {
+    resize(w, h);
+    return getBuffer();
+}
+
+void LGFX_Sprite::pushSprite(LovyanGFX *dst, int32_t x, int32_t y) {
+    dst->pushImage(x, y, m_width, m_height, m_fb.data());
+    dst->m_text = m_text;
+}
+}
+
+std::string sim_lcd_text() {
+    std::lock_guard<std::mutex> guard(sim_lcd_lock);
+    return sim_lcd_last_text;
+}
+
+// lcd.cpp's colors are 5 bits per channel: r@0, g@6, b@11.
+bool sim_lcd_write_ppm(const char *path) {
+    std::lock_guard<std::mutex> guard(sim_lcd_lock);
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+    fprintf(f, "P6\n%ld %ld\n255\n", (long)sim_lcd_width,
+        (long)sim_lcd_height);
+    for (uint16_t px : sim_lcd_fb) {
+        uint8_t rgb[3] = {
+            (uint8_t)(((px >> 0) & 0x1f) << 3),
+            (uint8_t)(((px >> 6) & 0x1f) << 3),
+            (uint8_t)(((px >> 11) & 0x1f) << 3),
+        };
+        fwrite(rgb, sizeof(rgb), 1, f);
+    }
+    return fclose(f) == 0;
+}
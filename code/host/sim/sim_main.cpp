@@ -0,0 +1,412 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// Runs the firmware's app_main() on the host against virtual peripherals and
+// an in-process mock ACL server, then drives it from a scenario file and
+// checks the scenario's expectations. See README.md's "Host simulation"
+// section for the scenario format.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <esp_timer.h>
+
+#include "mock_acl.h"
+#include "rfid_capture.h"
+#include "rfid_decoder.h"
+#include "sim.h"
+
+extern "C" void app_main();
+
+// Readers repeat the frame while a card is held.
+#define SIM_FRAME_PERIOD_MS 100
+#define SIM_DEFAULT_RELAY_PIN 12
+
+struct sim_expect {
+    int line;
+    bool negate;
+    std::string kind;
+    std::string pattern;
+    int64_t start_us;
+    int64_t window_us;
+};
+
+struct sim_presentation {
+    int line;
+    uint32_t rfid;
+    int64_t start_us;
+    // When the first frame's last byte arrived
+    int64_t frame_us;
+};
+
+static int sim_relay_pin = SIM_DEFAULT_RELAY_PIN;
+static std::vector<sim_expect> sim_expects;
+static std::vector<sim_presentation> sim_presentations;
+
+static void sim_sleep_until(int64_t time_us) {
+    int64_t now = esp_timer_get_time();
+    if (time_us > now) {
+        std::this_thread::sleep_for(
+            std::chrono::microseconds(time_us - now));
+    }
+}
+
+// RDM6300 format: STX, 10 hex digits (version byte, 32-bit ID), 2 hex digits
+// of XOR checksum, ETX.
+static std::string sim_rfid_frame(uint32_t rfid) {
+    uint8_t bytes[5] = {
+        0,
+        (uint8_t)(rfid >> 24),
+        (uint8_t)(rfid >> 16),
+        (uint8_t)(rfid >> 8),
+        (uint8_t)(rfid >> 0),
+    };
+    uint8_t crc = 0;
+    char frame[RFID_DECODER_FRAME_LEN + 3];
+    char *p = frame;
+    *p++ = 0x02;
+    for (uint8_t b : bytes) {
+        p += sprintf(p, "%02X", b);
+        crc ^= b;
+    }
+    p += sprintf(p, "%02X", crc);
+    *p++ = 0x03;
+    return std::string(frame, p - frame);
+}
+
+static void sim_present(int line, uint32_t rfid, int64_t hold_ms) {
+    std::string frame = sim_rfid_frame(rfid);
+    int64_t now = esp_timer_get_time();
+    sim_presentation pres{line, rfid, now, 0};
+    for (int64_t t = 0; t <= hold_ms; t += SIM_FRAME_PERIOD_MS) {
+        int64_t end = sim_uart_feed_at(now + (t * 1000), frame.data(),
+            frame.size());
+        if (!t)
+            pres.frame_us = end;
+    }
+    sim_presentations.push_back(pres);
+}
+
+static bool sim_replay(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    rfid_capture_header hdr;
+    std::vector<rfid_capture_record> recs;
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1;
+    bool v1 = ok &&
+        !memcmp(hdr.magic, RFID_CAPTURE_MAGIC_V1, sizeof(hdr.magic));
+    ok = ok &&
+        (v1 || !memcmp(hdr.magic, RFID_CAPTURE_MAGIC, sizeof(hdr.magic)));
+    if (ok) {
+        recs.resize(hdr.record_count);
+        ok = fread(recs.data(), sizeof(recs[0]), recs.size(), f) ==
+            recs.size();
+    }
+    fclose(f);
+    if (!ok)
+        return false;
+    int64_t time_us = esp_timer_get_time();
+    for (size_t i = 0; i < recs.size(); i++) {
+        // Version 1 records hold 32-bit absolute times; unsigned subtraction
+        // unwraps them.
+        if (i && v1)
+            time_us += (uint32_t)(recs[i].delta_us - recs[i - 1].delta_us);
+        else if (i)
+            time_us += recs[i].delta_us;
+        sim_uart_feed_at(time_us, &recs[i].data, 1);
+    }
+    return true;
+}
+
+static bool sim_event_matches(const sim_event &ev, const sim_expect &exp) {
+    if (exp.kind == "relay") {
+        return ev.type == SIM_EVENT_GPIO && ev.pin == sim_relay_pin &&
+            ev.level == atoi(exp.pattern.c_str());
+    }
+    if (exp.kind == "mqtt" && ev.type != SIM_EVENT_MQTT)
+        return false;
+    if (exp.kind == "lcd" && ev.type != SIM_EVENT_LCD)
+        return false;
+    return ev.text.find(exp.pattern) != std::string::npos;
+}
+
+static bool sim_check_expect(const sim_expect &exp) {
+    const sim_event *match = nullptr;
+    std::vector<sim_event> events = sim_events_since(exp.start_us);
+    for (const sim_event &ev : events) {
+        if (ev.time_us > exp.start_us + exp.window_us)
+            break;
+        if (sim_event_matches(ev, exp)) {
+            match = &ev;
+            break;
+        }
+    }
+    bool pass = exp.negate ? !match : !!match;
+    printf("sim: %s line %d: %s%s %s", pass ? "PASS" : "FAIL", exp.line,
+        exp.negate ? "no " : "", exp.kind.c_str(), exp.pattern.c_str());
+    if (match) {
+        printf(" after %.3f ms\n", (match->time_us - exp.start_us) / 1000.0);
+    } else {
+        printf(" within %lld ms\n", (long long)(exp.window_us / 1000));
+    }
+    return pass;
+}
+
+// Time from the end of each presentation's first frame (when the firmware
+// can first decode it) to the first relay, MQTT and LCD activity.
+static void sim_report_timing() {
+    for (size_t i = 0; i < sim_presentations.size(); i++) {
+        const sim_presentation &pres = sim_presentations[i];
+        int64_t end = (i + 1 < sim_presentations.size()) ?
+            sim_presentations[i + 1].start_us : INT64_MAX;
+        int64_t relay = -1, mqtt = -1, lcd = -1;
+        for (const sim_event &ev : sim_events_since(pres.frame_us)) {
+            if (ev.time_us >= end)
+                break;
+            int64_t delta = ev.time_us - pres.frame_us;
+            if (ev.type == SIM_EVENT_GPIO && ev.pin == sim_relay_pin &&
+                ev.level && relay < 0
+            ) {
+                relay = delta;
+            } else if (ev.type == SIM_EVENT_MQTT && mqtt < 0) {
+                mqtt = delta;
+            } else if (ev.type == SIM_EVENT_LCD && lcd < 0) {
+                lcd = delta;
+            }
+        }
+        printf("sim: timing line %d rfid %lu: frame %.3f ms", pres.line,
+            (unsigned long)pres.rfid,
+            (pres.frame_us - pres.start_us) / 1000.0);
+        const char *names[] = {"relay", "mqtt", "lcd"};
+        int64_t deltas[] = {relay, mqtt, lcd};
+        for (int j = 0; j < 3; j++) {
+            if (deltas[j] < 0)
+                printf(", %s -", names[j]);
+            else
+                printf(", %s +%.3f ms", names[j], deltas[j] / 1000.0);
+        }
+        printf("\n");
+    }
+}
+
+static bool sim_run_line(int line_no, char *line, int64_t t0,
+    int64_t *end_us
+) {
+    char *save;
+    char *time_s = strtok_r(line, " \t\n", &save);
+    if (!time_s || time_s[0] == '#')
+        return true;
+    char *cmd = strtok_r(NULL, " \t\n", &save);
+    std::vector<std::string> args;
+    while (char *arg = strtok_r(NULL, " \t\n", &save))
+        args.push_back(arg);
+    if (!cmd)
+        return false;
+    int64_t at_us = t0 + strtoll(time_s, NULL, 0) * 1000;
+    sim_sleep_until(at_us);
+    auto arg = [&args](size_t i) {
+        return i < args.size() ? args[i].c_str() : "";
+    };
+    std::string c = cmd;
+
+    if (c == "present" && args.size() == 2) {
+        sim_present(line_no, strtoul(arg(0), NULL, 0),
+            strtoll(arg(1), NULL, 0));
+    } else if (c == "replay" && args.size() == 1) {
+        return sim_replay(arg(0));
+    } else if (c == "acl" && args.size() == 2 && args[0] == "allow") {
+        mock_acl_set(strtoul(arg(1), NULL, 0), true);
+    } else if (c == "acl" && args.size() == 2 && args[0] == "deny") {
+        mock_acl_set(strtoul(arg(1), NULL, 0), false);
+    } else if (c == "acl" && args.size() == 2 && args[0] == "delay") {
+        mock_acl_set_delay_ms(strtoul(arg(1), NULL, 0));
+    } else if (c == "acl" && args.size() == 1) {
+        mock_acl_set_up(args[0] == "up");
+    } else if (c == "net" && args.size() == 1) {
+        sim_net_set_up(args[0] == "up");
+    } else if (c == "mqtt" && args.size() == 1) {
+        sim_mqtt_set_connected(args[0] == "up");
+    } else if (c == "conf" && args.size() == 1) {
+        return sim_conf_set(arg(0));
+    } else if (c == "action" && args.size() == 1) {
+        return sim_action_run(arg(0));
+    } else if (c == "http" && args.size() == 1) {
+        std::string body;
+        if (!sim_http_get(arg(0), &body, NULL))
+            return false;
+        printf("sim: http %s\n%s\n", arg(0), body.c_str());
+    } else if ((c == "expect" || c == "expect-not") && args.size() == 3) {
+        sim_expects.push_back({line_no, c == "expect-not", args[0], args[1],
+            at_us, strtoll(arg(2), NULL, 0) * 1000});
+    } else if (c == "end" && args.empty()) {
+        *end_us = at_us;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void sim_uart_tcp_serve(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) || listen(fd, 1)) {
+        perror("sim: uart tcp");
+        exit(1);
+    }
+    std::thread([fd] {
+        sim_thread_set_name("uart_tcp");
+        for (;;) {
+            int conn = accept(fd, NULL, NULL);
+            if (conn < 0)
+                continue;
+            char buf[64];
+            ssize_t len;
+            while ((len = recv(conn, buf, sizeof(buf), 0)) > 0)
+                sim_uart_feed(buf, len);
+            close(conn);
+        }
+    }).detach();
+}
+
+static int usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [options] [scenario.txt]\n"
+        "  --conf PAGE.ITEM=VALUE  set a configuration item\n"
+        "  --http-port N           serve the firmware's HTTP pages\n"
+        "  --uart-tcp N            feed UART bytes from TCP port N\n"
+        "  --baud N                UART baud rate (0: instant; 9600)\n"
+        "  --acl-port N            mock ACL server port (any)\n"
+        "  --relay-pin N           relay GPIO (%d)\n"
+        "  --nvs FILE              persist NVS in FILE\n"
+        "  --lcd-ppm FILE          write the final LCD framebuffer\n"
+        "  --log-level e|w|i|d|v   firmware log level (i)\n"
+        "Without a scenario, runs until killed.\n",
+        argv0, SIM_DEFAULT_RELAY_PIN);
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    const char *scenario = nullptr;
+    const char *lcd_ppm = nullptr;
+    int http_port = -1;
+    int uart_tcp_port = -1;
+    int acl_port = 0;
+    std::vector<const char *> confs;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (arg[0] != '-') {
+            if (scenario)
+                return usage(argv[0]);
+            scenario = arg;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return usage(argv[0]);
+        const char *val = argv[++i];
+        if (!strcmp(arg, "--conf")) {
+            confs.push_back(val);
+        } else if (!strcmp(arg, "--http-port")) {
+            http_port = atoi(val);
+        } else if (!strcmp(arg, "--uart-tcp")) {
+            uart_tcp_port = atoi(val);
+        } else if (!strcmp(arg, "--baud")) {
+            sim_uart_set_baud(strtoul(val, NULL, 0));
+        } else if (!strcmp(arg, "--acl-port")) {
+            acl_port = atoi(val);
+        } else if (!strcmp(arg, "--relay-pin")) {
+            sim_relay_pin = atoi(val);
+        } else if (!strcmp(arg, "--nvs")) {
+            sim_nvs_set_file(val);
+        } else if (!strcmp(arg, "--lcd-ppm")) {
+            lcd_ppm = val;
+        } else if (!strcmp(arg, "--log-level")) {
+            const char *levels = "ewidv";
+            const char *p = strchr(levels, val[0]);
+            if (!p || !val[0])
+                return usage(argv[0]);
+            sim_log_set_level((esp_log_level_t)(ESP_LOG_ERROR + p - levels));
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    FILE *f = nullptr;
+    if (scenario) {
+        f = fopen(scenario, "r");
+        if (!f) {
+            perror(scenario);
+            return 2;
+        }
+    }
+
+    acl_port = mock_acl_start(acl_port, false);
+    char acl_port_conf[32];
+    snprintf(acl_port_conf, sizeof(acl_port_conf), "acl.p=%d", acl_port);
+    sim_conf_set("acl.h=127.0.0.1");
+    sim_conf_set(acl_port_conf);
+    sim_conf_set("acl.a=sim");
+    // After the defaults above, so they can be overridden.
+    for (const char *conf : confs)
+        sim_conf_set(conf);
+
+    app_main();
+    int64_t t0 = esp_timer_get_time();
+    sim_thread_set_name("sim");
+    printf("sim: %10.3f ms app_main done; mock ACL server on port %d\n",
+        t0 / 1000.0, acl_port);
+
+    if (http_port >= 0)
+        printf("sim: http on port %d\n", sim_http_serve(http_port));
+    if (uart_tcp_port >= 0)
+        sim_uart_tcp_serve(uart_tcp_port);
+
+    if (!f) {
+        for (;;)
+            pause();
+    }
+
+    char line[256];
+    int line_no = 0;
+    int64_t end_us = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        if (!sim_run_line(line_no, line, t0, &end_us)) {
+            fprintf(stderr, "%s:%d: invalid or failed command\n", scenario,
+                line_no);
+            fflush(stdout);
+            _exit(2);
+        }
+    }
+    fclose(f);
+
+    for (const sim_expect &exp : sim_expects)
+        end_us = std::max(end_us, exp.start_us + exp.window_us);
+    sim_sleep_until(end_us);
+
+    int passed = 0;
+    for (const sim_expect &exp : sim_expects)
+        passed += sim_check_expect(exp);
+    sim_report_timing();
+    if (lcd_ppm && !sim_lcd_write_ppm(lcd_ppm))
+        perror(lcd_ppm);
+    printf("sim: %d/%zu expectations passed\n", passed, sim_expects.size());
+
+    // Firmware tasks are still running, so skip static destructors.
+    fflush(stdout);
+    _exit(passed == (int)sim_expects.size() ? 0 : 1);
+}
@@ -0,0 +1,554 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// FreeRTOS tasks, notifications, software timers and ring buffers, plus
+// esp_timer, on top of pthreads.
+
+#include <assert.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/ringbuf.h>
+
+#include "sim.h"
+
+using sim_clock = std::chrono::steady_clock;
+
+static sim_clock::time_point sim_start() {
+    static const sim_clock::time_point start = sim_clock::now();
+    return start;
+}
+
+// Pin the time origin at startup rather than at the first call.
+static const sim_clock::time_point sim_start_init = sim_start();
+
+int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        sim_clock::now() - sim_start()).count();
+}
+
+static sim_clock::time_point sim_time_point(int64_t time_us) {
+    return sim_start() + std::chrono::microseconds(time_us);
+}
+
+static int64_t sim_ticks_to_us(TickType_t ticks) {
+    return (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+// Tasks
+
+struct sim_task {
+    std::string name;
+    TaskFunction_t fn;
+    void *arg;
+    uint32_t stack_size;
+    UBaseType_t priority;
+    BaseType_t core;
+    UBaseType_t number;
+    pthread_t thread;
+    // Painted stack, and the stack pointer on entry, for the high-water mark.
+    uint8_t *stack;
+    uint8_t *stack_top;
+    bool deleted;
+    std::mutex lock;
+    std::condition_variable cv;
+    uint32_t notify_count;
+};
+
+static std::mutex sim_tasks_lock;
+static std::vector<sim_task *> sim_tasks;
+static thread_local sim_task *sim_task_current;
+
+static sim_task *sim_task_add(const char *name, uint32_t stack_size,
+    UBaseType_t priority, BaseType_t core
+) {
+    sim_task *task = new sim_task{};
+    task->name = name;
+    task->stack_size = stack_size;
+    task->priority = priority;
+    task->core = core;
+    task->thread = pthread_self();
+    std::lock_guard<std::mutex> guard(sim_tasks_lock);
+    task->number = sim_tasks.size() + 1;
+    sim_tasks.push_back(task);
+    return task;
+}
+
+// Threads that weren't created as tasks (app_main, the simulator's own
+// threads) are registered on first use.
+static sim_task *sim_task_self() {
+    if (!sim_task_current)
+        sim_task_current = sim_task_add("sim", 0, 1, 0);
+    return sim_task_current;
+}
+
+void sim_thread_set_name(const char *name) {
+    sim_task *task = sim_task_self();
+    std::lock_guard<std::mutex> guard(sim_tasks_lock);
+    task->name = name;
+    pthread_setname_np(pthread_self(), task->name.substr(0, 15).c_str());
+}
+
+// Each task runs on a stack of its own, painted so that its high-water mark
+// is measured much as FreeRTOS does. The host's code paths differ from the
+// device's (glibc, the stand-ins), so this is an estimate; there's slack
+// beyond the task's size so that the host can't overflow it.
+#define SIM_STACK_PAINT 0xa5
+#define SIM_STACK_SLACK (256 * 1024)
+
+static void *sim_task_entry(void *arg) {
+    sim_task *task = (sim_task *)arg;
+    // glibc keeps the thread descriptor and TLS at the top of the stack, so
+    // usage is measured from here.
+    uint8_t here;
+    task->stack_top = &here;
+    sim_task_current = task;
+    pthread_setname_np(pthread_self(), task->name.substr(0, 15).c_str());
+    task->fn(task->arg);
+    // FreeRTOS tasks must not return; treat it as deletion.
+    fprintf(stderr, "sim: task %s returned\n", task->name.c_str());
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+    uint32_t stack_size, void *arg, UBaseType_t priority,
+    TaskHandle_t *handle, BaseType_t core
+) {
+    sim_task *task = sim_task_add(name, stack_size, priority, core);
+    task->fn = fn;
+    task->arg = arg;
+    // Publish the handle before the task can run, as FreeRTOS does when
+    // the creator has the higher priority.
+    if (handle)
+        *handle = task;
+    // Not freed when the task exits, since a thread can't free the stack it
+    // runs on; only loadgen exits.
+    size_t alloc = stack_size + SIM_STACK_SLACK;
+    task->stack = (uint8_t *)malloc(alloc);
+    assert(task->stack);
+    memset(task->stack, SIM_STACK_PAINT, alloc);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, task->stack, alloc);
+    pthread_t thread;
+    int err = pthread_create(&thread, &attr, sim_task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (err)
+        return pdFAIL;
+    {
+        std::lock_guard<std::mutex> guard(sim_tasks_lock);
+        task->thread = thread;
+    }
+    pthread_detach(thread);
+    return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn,
+    const char *name, uint32_t stack_size, void *arg, UBaseType_t priority,
+    StackType_t *stack, StaticTask_t *tcb, BaseType_t core
+) {
+    TaskHandle_t handle;
+    if (xTaskCreatePinnedToCore(fn, name, stack_size, arg, priority, &handle,
+        core) != pdPASS
+    ) {
+        return NULL;
+    }
+    return handle;
+}
+
+void vTaskDelete(TaskHandle_t handle) {
+    // Only self-deletion is used by the firmware.
+    assert(handle == NULL || handle == sim_task_current);
+    sim_task *task = sim_task_self();
+    {
+        std::lock_guard<std::mutex> guard(sim_tasks_lock);
+        task->deleted = true;
+    }
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::microseconds(
+        sim_ticks_to_us(ticks)));
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(esp_timer_get_time() / (portTICK_PERIOD_MS * 1000));
+}
+
+TaskHandle_t xTaskGetHandle(const char *name) {
+    std::lock_guard<std::mutex> guard(sim_tasks_lock);
+    for (sim_task *task : sim_tasks) {
+        if (!task->deleted && task->name == name)
+            return task;
+    }
+    return NULL;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return sim_task_self();
+}
+
+static UBaseType_t sim_task_stack_free(sim_task *task) {
+    if (!task->stack || !task->stack_top)
+        return task->stack_size;
+    const uint8_t *p = task->stack;
+    while (p < task->stack_top && *p == SIM_STACK_PAINT)
+        p++;
+    uint32_t used = task->stack_top - p;
+    return (used < task->stack_size) ? task->stack_size - used : 0;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t handle) {
+    if (!handle)
+        handle = sim_task_self();
+    return sim_task_stack_free(handle);
+}
+
+static uint32_t sim_task_cpu_time_us(sim_task *task) {
+    clockid_t clock;
+    timespec ts;
+    if (pthread_getcpuclockid(task->thread, &clock) ||
+        clock_gettime(clock, &ts)
+    ) {
+        return 0;
+    }
+    return (uint32_t)(((int64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000));
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status,
+    UBaseType_t status_count, uint32_t *total_run_time
+) {
+    std::lock_guard<std::mutex> guard(sim_tasks_lock);
+    UBaseType_t count = 0;
+    for (sim_task *task : sim_tasks) {
+        if (task->deleted)
+            continue;
+        if (count == status_count)
+            return 0;
+        TaskStatus_t &s = status[count++];
+        s = {};
+        s.xHandle = task;
+        s.pcTaskName = task->name.c_str();
+        s.xTaskNumber = task->number;
+        s.eCurrentState = eBlocked;
+        s.uxCurrentPriority = task->priority;
+        s.uxBasePriority = task->priority;
+        s.ulRunTimeCounter = sim_task_cpu_time_us(task);
+        s.usStackHighWaterMark = sim_task_stack_free(task);
+        s.xCoreID = task->core;
+    }
+    // The device counts run time per core.
+    if (total_run_time) {
+        *total_run_time =
+            (uint32_t)(esp_timer_get_time() * portNUM_PROCESSORS);
+    }
+    return count;
+}
+
+BaseType_t xPortGetCoreID() {
+    sim_task *task = sim_task_current;
+    if (!task || task->core < 0 || task->core >= portNUM_PROCESSORS)
+        return 0;
+    return task->core;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    sim_task *task = sim_task_self();
+    std::unique_lock<std::mutex> guard(task->lock);
+    auto notified = [task] { return task->notify_count != 0; };
+    if (ticks == portMAX_DELAY) {
+        task->cv.wait(guard, notified);
+    } else {
+        task->cv.wait_for(guard,
+            std::chrono::microseconds(sim_ticks_to_us(ticks)), notified);
+    }
+    uint32_t count = task->notify_count;
+    if (count)
+        task->notify_count = clear ? 0 : count - 1;
+    return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle) {
+    {
+        std::lock_guard<std::mutex> guard(handle->lock);
+        handle->notify_count++;
+    }
+    handle->cv.notify_one();
+    return pdPASS;
+}
+
+// Timers. FreeRTOS software timers and esp_timers share an implementation;
+// each kind has its own service thread, as on the device.
+
+struct sim_timer_service {
+    const char *name;
+    UBaseType_t priority;
+    std::mutex lock;
+    std::condition_variable cv;
+    std::vector<sim_timer *> timers;
+    bool started;
+};
+
+struct sim_timer {
+    sim_timer_service *service;
+    const char *name;
+    void (*cb)(sim_timer *timer);
+    esp_timer_cb_t esp_cb;
+    void *arg;
+    int64_t period_us;
+    bool periodic;
+    bool active;
+    int64_t expiry_us;
+};
+
+static sim_timer_service sim_timer_service_freertos{"Tmr Svc", 1};
+static sim_timer_service sim_timer_service_esp{"esp_timer", 22};
+
+static void sim_timer_service_task(void *arg) {
+    sim_timer_service *service = (sim_timer_service *)arg;
+    std::unique_lock<std::mutex> guard(service->lock);
+    for (;;) {
+        sim_timer *next = nullptr;
+        for (sim_timer *timer : service->timers) {
+            if (timer->active &&
+                (!next || timer->expiry_us < next->expiry_us)
+            ) {
+                next = timer;
+            }
+        }
+        if (!next) {
+            service->cv.wait(guard);
+            continue;
+        }
+        if (esp_timer_get_time() < next->expiry_us) {
+            service->cv.wait_until(guard, sim_time_point(next->expiry_us));
+            continue;
+        }
+        if (next->periodic)
+            next->expiry_us += next->period_us;
+        else
+            next->active = false;
+        guard.unlock();
+        next->cb(next);
+        guard.lock();
+    }
+}
+
+static void sim_timer_add(sim_timer_service *service, sim_timer *timer) {
+    timer->service = service;
+    std::lock_guard<std::mutex> guard(service->lock);
+    service->timers.push_back(timer);
+    if (!service->started) {
+        service->started = true;
+        xTaskCreatePinnedToCore(sim_timer_service_task, service->name, 4096,
+            service, service->priority, NULL, 0);
+    }
+}
+
+static void sim_timer_start(sim_timer *timer, int64_t period_us,
+    bool periodic
+) {
+    sim_timer_service *service = timer->service;
+    {
+        std::lock_guard<std::mutex> guard(service->lock);
+        timer->period_us = period_us;
+        timer->periodic = periodic;
+        timer->expiry_us = esp_timer_get_time() + period_us;
+        timer->active = true;
+    }
+    service->cv.notify_one();
+}
+
+static void sim_timer_stop(sim_timer *timer) {
+    sim_timer_service *service = timer->service;
+    std::lock_guard<std::mutex> guard(service->lock);
+    timer->active = false;
+}
+
+static bool sim_timer_is_active(sim_timer *timer) {
+    std::lock_guard<std::mutex> guard(timer->service->lock);
+    return timer->active;
+}
+
+struct sim_freertos_timer : sim_timer {
+    TimerCallbackFunction_t freertos_cb;
+    void *id;
+};
+
+static void sim_freertos_timer_cb(sim_timer *timer) {
+    ((sim_freertos_timer *)timer)->freertos_cb(timer);
+}
+
+TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period,
+    UBaseType_t auto_reload, void *id, TimerCallbackFunction_t cb,
+    StaticTimer_t *buf
+) {
+    sim_freertos_timer *timer = new sim_freertos_timer{};
+    timer->name = name;
+    timer->cb = sim_freertos_timer_cb;
+    timer->freertos_cb = cb;
+    timer->id = id;
+    timer->period_us = sim_ticks_to_us(period);
+    timer->periodic = auto_reload;
+    sim_timer_add(&sim_timer_service_freertos, timer);
+    return timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t block) {
+    sim_timer_start(timer, timer->period_us, timer->periodic);
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t block) {
+    sim_timer_stop(timer);
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t block) {
+    return xTimerStart(timer, block);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period,
+    TickType_t block
+) {
+    sim_timer_start(timer, sim_ticks_to_us(period), timer->periodic);
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer) {
+    return sim_timer_is_active(timer);
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer) {
+    return ((sim_freertos_timer *)timer)->id;
+}
+
+static void sim_esp_timer_cb(sim_timer *timer) {
+    timer->esp_cb(timer->arg);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args,
+    esp_timer_handle_t *handle
+) {
+    sim_timer *timer = new sim_timer{};
+    timer->name = args->name;
+    timer->cb = sim_esp_timer_cb;
+    timer->esp_cb = args->callback;
+    timer->arg = args->arg;
+    sim_timer_add(&sim_timer_service_esp, timer);
+    *handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer,
+    uint64_t period_us
+) {
+    if (sim_timer_is_active(timer))
+        return ESP_ERR_INVALID_STATE;
+    sim_timer_start(timer, period_us, true);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    if (sim_timer_is_active(timer))
+        return ESP_ERR_INVALID_STATE;
+    sim_timer_start(timer, timeout_us, false);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!sim_timer_is_active(timer))
+        return ESP_ERR_INVALID_STATE;
+    sim_timer_stop(timer);
+    return ESP_OK;
+}
+
+// Ring buffers
+
+struct sim_ringbuf {
+    size_t size;
+    size_t used;
+    std::mutex lock;
+    std::condition_variable cv;
+    std::deque<std::vector<char>> items;
+    // Received but not yet returned; their space is still in use
+    std::list<std::vector<char>> held;
+};
+
+static size_t sim_ringbuf_item_cost(size_t len) {
+    return 8 + ((len + 3) & ~(size_t)3);
+}
+
+RingbufHandle_t xRingbufferCreateStatic(size_t size, RingbufferType_t type,
+    uint8_t *storage, StaticRingbuffer_t *buf
+) {
+    assert(type == RINGBUF_TYPE_NOSPLIT);
+    sim_ringbuf *ring = new sim_ringbuf{};
+    ring->size = size;
+    return ring;
+}
+
+BaseType_t xRingbufferSend(RingbufHandle_t ring, const void *item,
+    size_t size, TickType_t ticks
+) {
+    size_t cost = sim_ringbuf_item_cost(size);
+    std::unique_lock<std::mutex> guard(ring->lock);
+    auto fits = [ring, cost] { return ring->used + cost <= ring->size; };
+    if (ticks == portMAX_DELAY) {
+        ring->cv.wait(guard, fits);
+    } else if (!ring->cv.wait_for(guard,
+        std::chrono::microseconds(sim_ticks_to_us(ticks)), fits)
+    ) {
+        return pdFALSE;
+    }
+    ring->used += cost;
+    const char *p = (const char *)item;
+    ring->items.emplace_back(p, p + size);
+    ring->cv.notify_all();
+    return pdTRUE;
+}
+
+void *xRingbufferReceive(RingbufHandle_t ring, size_t *size,
+    TickType_t ticks
+) {
+    std::unique_lock<std::mutex> guard(ring->lock);
+    auto available = [ring] { return !ring->items.empty(); };
+    if (ticks == portMAX_DELAY) {
+        ring->cv.wait(guard, available);
+    } else if (!ring->cv.wait_for(guard,
+        std::chrono::microseconds(sim_ticks_to_us(ticks)), available)
+    ) {
+        return NULL;
+    }
+    ring->held.push_back(std::move(ring->items.front()));
+    ring->items.pop_front();
+    std::vector<char> &item = ring->held.back();
+    *size = item.size();
+    return item.data();
+}
+
+void vRingbufferReturnItem(RingbufHandle_t ring, void *item) {
+    std::lock_guard<std::mutex> guard(ring->lock);
+    for (auto it = ring->held.begin(); it != ring->held.end(); ++it) {
+        if (it->data() != item)
+            continue;
+        ring->used -= sim_ringbuf_item_cost(it->size());
+        ring->held.erase(it);
+        ring->cv.notify_all();
+        return;
+    }
+    assert(!"vRingbufferReturnItem: unknown item");
+}
@@ -0,0 +1,73 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// Minimal UDP syslog collector, to stand in for a real one when testing the
+// firmware's log forwarding. Prints each received message with its source
+// address and decoded severity.
+//
+// Usage: syslog_listen [port]
+//   The port defaults to 5140, since 514 needs root; set the device's
+//   "Syslog Server UDP Port" to match.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+static const char *listen_severity_names[] = {
+    "emerg", "alert", "crit", "err", "warning", "notice", "info", "debug",
+};
+
+int main(int argc, char **argv) {
+    int port = 5140;
+    if (argc == 2)
+        port = atoi(argv[1]);
+    if (argc > 2 || port <= 0 || port > 65535) {
+        fprintf(stderr, "usage: %s [port]\n", argv[0]);
+        return 1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("socket");
+        return 1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(sock, (const sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+    fprintf(stderr, "listening on UDP port %d\n", port);
+
+    for (;;) {
+        char buf[2048];
+        sockaddr_in src;
+        socklen_t src_len = sizeof(src);
+        ssize_t len = recvfrom(sock, buf, sizeof(buf) - 1, 0,
+            (sockaddr *)&src, &src_len);
+        if (len < 0) {
+            perror("recvfrom");
+            return 1;
+        }
+        buf[len] = '\0';
+        while (len && (buf[len - 1] == '\n' || buf[len - 1] == '\r'))
+            buf[--len] = '\0';
+
+        // "<PRI>" prefix: facility * 8 + severity.
+        const char *msg = buf;
+        const char *severity = "?";
+        int pri;
+        int pri_len;
+        if (sscanf(buf, "<%d>%n", &pri, &pri_len) == 1 && pri >= 0) {
+            severity = listen_severity_names[pri % 8];
+            msg += pri_len;
+        }
+        printf("%s %-7s %s\n", inet_ntoa(src.sin_addr), severity, msg);
+        fflush(stdout);
+    }
+}
@@ -0,0 +1,110 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+// Decodes a binary trace dump (downloaded from /trace), merging all cores'
+// rings into one timeline, oldest first:
+//
+//   <seconds since boot> <core> <event> [<arg name>=<value>]...
+//
+// Usage: trace_decode trace.bin
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "fcch_trace/trace.h"
+#include "trace_format.h"
+
+struct decode_id {
+    const char *name;
+    const char *arg0;
+    const char *arg1;
+};
+
+static const decode_id decode_ids[] = {
+#define DECODE_ID(name, arg0, arg1) {#name, #arg0, #arg1},
+    TRACE_IDS(DECODE_ID)
+#undef DECODE_ID
+};
+
+struct decode_event {
+    uint64_t time_us;
+    uint32_t core;
+    trace_record rec;
+};
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s trace.bin\n", argv[0]);
+        return 1;
+    }
+    FILE *f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+    trace_dump_header hdr;
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+        memcmp(hdr.magic, TRACE_DUMP_MAGIC, sizeof(hdr.magic))) {
+        fprintf(stderr, "%s: not a trace dump\n", argv[1]);
+        return 1;
+    }
+    uint32_t n = hdr.records_per_core;
+    if (!n || (n & (n - 1)) || n > 65536) {
+        fprintf(stderr, "%s: bad records_per_core %lu\n", argv[1],
+            (unsigned long)n);
+        return 1;
+    }
+
+    std::vector<decode_event> events;
+    std::vector<trace_record> ring(n);
+    for (uint32_t core = 0; core < hdr.cores; core++) {
+        trace_dump_core core_hdr;
+        if (fread(&core_hdr, sizeof(core_hdr), 1, f) != 1 ||
+            fread(ring.data(), sizeof(trace_record), n, f) != n) {
+            fprintf(stderr, "%s: truncated\n", argv[1]);
+            return 1;
+        }
+        uint32_t written = core_hdr.written;
+        uint32_t count = std::min(written, n);
+        uint32_t stale = 0;
+        for (uint32_t i = written - count; i != written; i++) {
+            const trace_record &rec = ring[i % n];
+            if (rec.seq != (uint16_t)i) {
+                stale++;
+                continue;
+            }
+            // Timestamps are the low 32 bits; records are assumed to be less
+            // than ~71 minutes older than the dump.
+            uint32_t age_us = (uint32_t)hdr.time_us - rec.time_us;
+            events.push_back({hdr.time_us - age_us, core, rec});
+        }
+        fprintf(stderr, "core %lu: %lu records written, %lu kept, "
+            "%lu overwritten during dump\n", (unsigned long)core,
+            (unsigned long)written, (unsigned long)(count - stale),
+            (unsigned long)stale);
+    }
+    fclose(f);
+
+    std::stable_sort(events.begin(), events.end(),
+        [](const decode_event &a, const decode_event &b) {
+            return a.time_us < b.time_us;
+        });
+    for (const decode_event &ev : events) {
+        printf("%14.6f %lu ", ev.time_us / 1000000.0, (unsigned long)ev.core);
+        if (ev.rec.id < TRACE_ID_NUM) {
+            const decode_id &id = decode_ids[ev.rec.id];
+            printf("%s", id.name);
+            if (strcmp(id.arg0, "unused"))
+                printf(" %s=%lu", id.arg0, (unsigned long)ev.rec.arg0);
+            if (strcmp(id.arg1, "unused"))
+                printf(" %s=%lu", id.arg1, (unsigned long)ev.rec.arg1);
+            printf("\n");
+        } else {
+            printf("ID_%u %lu %lu\n", ev.rec.id,
+                (unsigned long)ev.rec.arg0, (unsigned long)ev.rec.arg1);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <nvs.h>
+
+#include "boot.h"
+#include "fcch_connmgr/cm_net.h"
+
+static const char *TAG = "boot";
+
+#define BOOT_NVS_NAMESPACE "boot"
+#define BOOT_NVS_KEY_COUNT "count"
+
+static const uint64_t boot_net_poll_period_us = 50 * 1000;
+
+static const char *boot_phase_names[BOOT_PHASE_NUM] = {
+    [BOOT_PHASE_CONF] = "conf",
+    [BOOT_PHASE_CM] = "cm",
+    [BOOT_PHASE_DECISION_PATH] = "decision_path",
+    [BOOT_PHASE_APP_MAIN] = "app_main",
+    [BOOT_PHASE_NET_UP] = "net_up",
+    [BOOT_PHASE_FIRST_DECISION] = "first_decision",
+    [BOOT_PHASE_FIRST_GRANT] = "first_grant",
+};
+
+static portMUX_TYPE boot_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t boot_times[BOOT_PHASE_NUM];
+static esp_timer_handle_t boot_net_timer;
+static uint32_t boot_count;
+
+void boot_mark(boot_phase phase) {
+    assert(phase < BOOT_PHASE_NUM);
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&boot_lock);
+    bool first = boot_times[phase] == 0;
+    if (first)
+        boot_times[phase] = now;
+    portEXIT_CRITICAL(&boot_lock);
+    if (first)
+        ESP_LOGI(TAG, "%s at %lld us", boot_phase_names[phase], now);
+}
+
+const char *boot_phase_name(boot_phase phase) {
+    assert(phase < BOOT_PHASE_NUM);
+    return boot_phase_names[phase];
+}
+
+int64_t boot_get_time(boot_phase phase) {
+    assert(phase < BOOT_PHASE_NUM);
+    portENTER_CRITICAL(&boot_lock);
+    int64_t ret = boot_times[phase];
+    portEXIT_CRITICAL(&boot_lock);
+    return ret ? ret : -1;
+}
+
+uint32_t boot_get_count() {
+    return boot_count;
+}
+
+static void boot_count_increment() {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(BOOT_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open: %s", esp_err_to_name(err));
+        return;
+    }
+    uint32_t count = 0;
+    err = nvs_get_u32(handle, BOOT_NVS_KEY_COUNT, &count);
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+        count++;
+        err = nvs_set_u32(handle, BOOT_NVS_KEY_COUNT, count);
+    }
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "boot count: %s", esp_err_to_name(err));
+        return;
+    }
+    boot_count = count;
+    ESP_LOGI(TAG, "boot %lu", count);
+}
+
+static void boot_net_poll(void *arg) {
+    if (!cm_net_get_sta_info().has_ip)
+        return;
+    boot_mark(BOOT_PHASE_NET_UP);
+    esp_timer_stop(boot_net_timer);
+}
+
+void boot_init() {
+    boot_count_increment();
+
+    const esp_timer_create_args_t args = {
+        .callback = &boot_net_poll,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "boot",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &boot_net_timer));
+    ESP_ERROR_CHECK(
+        esp_timer_start_periodic(boot_net_timer, boot_net_poll_period_us));
+}
@@ -0,0 +1,29 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+// Boot phase timing. Each phase records the esp_timer time (us since the app
+// started; bootloader time is excluded) at which it was first reached.
+enum boot_phase {
+    BOOT_PHASE_CONF,          // Configuration pages registered
+    BOOT_PHASE_CM,            // cm_init() returned
+    BOOT_PHASE_DECISION_PATH, // RFID reader running, decisions possible
+    BOOT_PHASE_APP_MAIN,      // app_main() returned
+    BOOT_PHASE_NET_UP,        // WiFi station has an IP address
+    BOOT_PHASE_FIRST_DECISION,
+    BOOT_PHASE_FIRST_GRANT,
+    BOOT_PHASE_NUM,
+};
+
+// Call after cm_init(), which initializes NVS.
+extern void boot_init();
+// Number of boots, including this one, counted in NVS. 0 if NVS failed.
+extern uint32_t boot_get_count();
+// Safe to call from any task; only the first call for each phase counts.
+extern void boot_mark(boot_phase phase);
+extern const char *boot_phase_name(boot_phase phase);
+// Returns -1 if the phase hasn't been reached.
+extern int64_t boot_get_time(boot_phase phase);
@@ -0,0 +1,148 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "conf_watch.h"
+#include "dispatch.h"
+
+static const char *TAG = "conf_watch";
+
+#define CONF_WATCH_MAX_VALUES 24
+#define CONF_WATCH_MAX_CALLBACKS 8
+
+static const uint64_t conf_watch_poll_period_us = 1000 * 1000;
+
+struct conf_watch_value {
+    cm_conf_item_type type;
+    cm_conf_p_val p_val;
+    conf_watch_callback *cb;
+    // Last applied value: the u16 itself, or a string's pointer and hash.
+    uint16_t u16;
+    const char *str;
+    uint32_t str_hash;
+};
+
+static conf_watch_value conf_watch_values[CONF_WATCH_MAX_VALUES];
+static int conf_watch_values_count;
+static esp_timer_handle_t conf_watch_timer;
+
+static uint32_t conf_watch_hash(const char *s) {
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (; *s; s++)
+        hash = (hash ^ (uint8_t)*s) * 16777619UL;
+    return hash;
+}
+
+static bool conf_watch_changed(const conf_watch_value &value) {
+    switch (value.type) {
+    case CM_CONF_ITEM_TYPE_U16:
+        return *value.p_val.u16 != value.u16;
+    case CM_CONF_ITEM_TYPE_STR: {
+        const char *str = *value.p_val.str;
+        return (str != value.str) || (conf_watch_hash(str) != value.str_hash);
+    }
+    default:
+        return false;
+    }
+}
+
+static void conf_watch_snapshot(conf_watch_value &value) {
+    switch (value.type) {
+    case CM_CONF_ITEM_TYPE_U16:
+        value.u16 = *value.p_val.u16;
+        break;
+    case CM_CONF_ITEM_TYPE_STR:
+        value.str = *value.p_val.str;
+        value.str_hash = conf_watch_hash(value.str);
+        break;
+    default:
+        break;
+    }
+}
+
+static void conf_watch_add(
+    cm_conf_item_type type,
+    cm_conf_p_val p_val,
+    conf_watch_callback *cb
+) {
+    assert(conf_watch_values_count < CONF_WATCH_MAX_VALUES);
+    conf_watch_value &value = conf_watch_values[conf_watch_values_count++];
+    value.type = type;
+    value.p_val = p_val;
+    value.cb = cb;
+}
+
+void conf_watch_register_page(
+    const cm_conf_page *page,
+    conf_watch_callback *cb
+) {
+    for (size_t i = 0; i < page->items_count; i++) {
+        const cm_conf_item *item = page->items[i];
+        conf_watch_add(item->type, item->p_val, cb);
+    }
+}
+
+void conf_watch_register_u16(const uint16_t *p_val, conf_watch_callback *cb) {
+    conf_watch_add(CM_CONF_ITEM_TYPE_U16,
+        {.u16 = const_cast<uint16_t *>(p_val)}, cb);
+}
+
+// Runs in the esp_timer task; only detects, so the dispatch task can apply.
+static void conf_watch_poll(void *arg) {
+    for (int i = 0; i < conf_watch_values_count; i++) {
+        if (conf_watch_changed(conf_watch_values[i])) {
+            dispatch_event ev{
+                .id = DISPATCH_EVENT_CONF_CHANGED,
+                .dummy = 0,
+            };
+            dispatch_post(ev);
+            return;
+        }
+    }
+}
+
+static void conf_watch_on_event_conf_changed(const dispatch_event &ev) {
+    conf_watch_callback *cbs[CONF_WATCH_MAX_CALLBACKS];
+    int cbs_count = 0;
+
+    for (int i = 0; i < conf_watch_values_count; i++) {
+        conf_watch_value &value = conf_watch_values[i];
+        if (!conf_watch_changed(value))
+            continue;
+        conf_watch_snapshot(value);
+        bool seen = false;
+        for (int j = 0; j < cbs_count; j++)
+            seen |= (cbs[j] == value.cb);
+        if (!seen) {
+            assert(cbs_count < CONF_WATCH_MAX_CALLBACKS);
+            cbs[cbs_count++] = value.cb;
+        }
+    }
+
+    ESP_LOGI(TAG, "Applying changes (%d modules)", cbs_count);
+    for (int i = 0; i < cbs_count; i++)
+        cbs[i]();
+}
+
+void conf_watch_init() {
+    for (int i = 0; i < conf_watch_values_count; i++)
+        conf_watch_snapshot(conf_watch_values[i]);
+
+    dispatch_register(DISPATCH_EVENT_CONF_CHANGED,
+        conf_watch_on_event_conf_changed);
+
+    const esp_timer_create_args_t args = {
+        .callback = &conf_watch_poll,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "conf_watch",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &conf_watch_timer));
+    ESP_ERROR_CHECK(
+        esp_timer_start_periodic(conf_watch_timer, conf_watch_poll_period_us));
+}
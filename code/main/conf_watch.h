@@ -0,0 +1,28 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+#include "fcch_connmgr/cm_conf.h"
+
+// Configuration change notifications. fcch_connmgr doesn't report changes, so
+// the registered values are polled. When any change, a
+// DISPATCH_EVENT_CONF_CHANGED event is posted, and each callback whose
+// values changed is called once, in the dispatch task.
+
+typedef void conf_watch_callback();
+
+// Watch every item on a page.
+extern void conf_watch_register_page(
+    const cm_conf_page *page,
+    conf_watch_callback *cb
+);
+// Watch a value that isn't on a page this application registers.
+extern void conf_watch_register_u16(
+    const uint16_t *p_val,
+    conf_watch_callback *cb
+);
+// Call after all watches are registered and the configuration is loaded.
+extern void conf_watch_init();
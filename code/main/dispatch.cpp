@@ -0,0 +1,255 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <atomic>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "dispatch.h"
+#include "fcch_trace/trace.h"
+#include "spsc_ring.h"
+#include "stall.h"
+#include "tasks.h"
+
+// Single task through which RFID presence, momentary timer and ACL decision
+// events flow. Each event is copied once, into either the presence ring (from
+// rfid_task only) or the general queue (from anywhere); handlers are plain
+// function calls in the dispatch task. Handlers must not block for long,
+// except the ACL decision stage itself; anything slow (LCD drawing, MQTT
+// publishing) is handed to that module's own task.
+//
+// The dispatch task sleeps on its task notification; every post notifies it.
+// This lets it wait on both the lock-free ring and the queue at once.
+//
+// Neither path ever blocks the poster or asserts when full. Each event ID has
+// an overflow policy for the general queue:
+// - Coalesce: an event that supersedes any queued event with the same ID
+//   replaces it in place (e.g. a momentary timer expiry; only the newest
+//   epoch is ever acted upon, or a configuration change, which rescans all
+//   values). Otherwise it's queued, or dropped if full.
+// - Drop newest: the event is queued, or dropped if full.
+// Drops and coalesces are counted in dispatch_stats.
+//
+// Presence is state rather than a stream, so the latest presence event is
+// never lost. If the ring is full (e.g. while the dispatch task waits on a
+// slow ACL request), the event goes to a single overflow slot instead, and
+// while that's occupied, newer events replace it there rather than entering
+// the ring. So the slot is always newer than anything in the ring, and the
+// dispatch task handles it once the ring is empty. Only the intermediate
+// events it replaced are dropped; a card's final absent event always arrives.
+
+static const char *TAG = "dispatch";
+
+#define DISPATCH_QUEUE_LEN 16
+#define DISPATCH_PRESENCE_RING_LEN 16
+#define DISPATCH_MAX_HANDLERS 4
+
+enum dispatch_overflow_policy {
+    DISPATCH_POLICY_DROP_NEWEST,
+    DISPATCH_POLICY_COALESCE,
+};
+
+static const dispatch_overflow_policy dispatch_policies[DISPATCH_EVENT_NUM] = {
+    [DISPATCH_EVENT_RFID_PRESENT] = DISPATCH_POLICY_DROP_NEWEST,
+    [DISPATCH_EVENT_RFID_ABSENT] = DISPATCH_POLICY_DROP_NEWEST,
+    [DISPATCH_EVENT_MOMENTARY_TIMER] = DISPATCH_POLICY_COALESCE,
+    [DISPATCH_EVENT_RFID_ERR] = DISPATCH_POLICY_DROP_NEWEST,
+    [DISPATCH_EVENT_RFID_OK] = DISPATCH_POLICY_DROP_NEWEST,
+    [DISPATCH_EVENT_RFID_BAD] = DISPATCH_POLICY_DROP_NEWEST,
+    [DISPATCH_EVENT_RFID_NONE] = DISPATCH_POLICY_DROP_NEWEST,
+    [DISPATCH_EVENT_CONF_CHANGED] = DISPATCH_POLICY_COALESCE,
+    [DISPATCH_EVENT_NET_CHANGED] = DISPATCH_POLICY_COALESCE,
+};
+
+static TaskHandle_t dispatch_task_handle;
+static portMUX_TYPE dispatch_queue_lock = portMUX_INITIALIZER_UNLOCKED;
+static dispatch_event dispatch_queue[DISPATCH_QUEUE_LEN];
+static uint32_t dispatch_queue_head;
+static uint32_t dispatch_queue_count;
+static SpscRing<dispatch_event, DISPATCH_PRESENCE_RING_LEN>
+    dispatch_presence_ring;
+// The overflow slot. valid is only set by rfid_task and only cleared by the
+// dispatch task; the event itself is protected by the lock.
+static std::atomic<bool> dispatch_presence_latest_valid;
+static portMUX_TYPE dispatch_presence_lock = portMUX_INITIALIZER_UNLOCKED;
+static dispatch_event dispatch_presence_latest;
+static dispatch_handler *dispatch_handlers
+    [DISPATCH_EVENT_NUM][DISPATCH_MAX_HANDLERS];
+static portMUX_TYPE dispatch_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static dispatch_stats dispatch_cur_stats;
+
+void dispatch_emit(const dispatch_event &ev) {
+    if (ev.id >= DISPATCH_EVENT_NUM) {
+        ESP_LOGE(TAG, "Unknown event: %d", (int)ev.id);
+        return;
+    }
+    for (dispatch_handler *handler : dispatch_handlers[ev.id]) {
+        if (handler == nullptr)
+            break;
+        handler(ev);
+    }
+}
+
+static void dispatch_run(const dispatch_event &ev) {
+    stall_enter(STALL_ID_DISPATCH, ev.id);
+    int64_t start = esp_timer_get_time();
+    trace(TRACE_ID_DISPATCH_RUN, ev.id, (uint32_t)(start - ev.post_time));
+    dispatch_emit(ev);
+    int64_t end = esp_timer_get_time();
+    stall_exit(STALL_ID_DISPATCH);
+
+    int64_t latency = start - ev.post_time;
+    int64_t handler = end - start;
+    portENTER_CRITICAL(&dispatch_stats_lock);
+    dispatch_stats &stats = dispatch_cur_stats;
+    stats.events++;
+    stats.latency_us_sum += latency;
+    if (latency > stats.latency_us_max)
+        stats.latency_us_max = latency;
+    stats.handler_us_sum += handler;
+    if (handler > stats.handler_us_max)
+        stats.handler_us_max = handler;
+    portEXIT_CRITICAL(&dispatch_stats_lock);
+}
+
+// Only once the ring is empty, so the slot's event is handled last.
+static bool dispatch_presence_pop(dispatch_event *ev) {
+    if (dispatch_presence_ring.pop(ev))
+        return true;
+    if (!dispatch_presence_latest_valid.load(std::memory_order_acquire))
+        return false;
+    portENTER_CRITICAL(&dispatch_presence_lock);
+    *ev = dispatch_presence_latest;
+    dispatch_presence_latest_valid.store(false, std::memory_order_release);
+    portEXIT_CRITICAL(&dispatch_presence_lock);
+    return true;
+}
+
+static bool dispatch_queue_pop(dispatch_event *ev) {
+    bool popped = false;
+    portENTER_CRITICAL(&dispatch_queue_lock);
+    if (dispatch_queue_count) {
+        *ev = dispatch_queue[dispatch_queue_head];
+        dispatch_queue_head = (dispatch_queue_head + 1) % DISPATCH_QUEUE_LEN;
+        dispatch_queue_count--;
+        popped = true;
+    }
+    portEXIT_CRITICAL(&dispatch_queue_lock);
+    return popped;
+}
+
+static void dispatch_task(void *pvParameters) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // Presence events first; they're what a member is waiting on.
+        for (;;) {
+            dispatch_event ev;
+            if (dispatch_presence_pop(&ev) || dispatch_queue_pop(&ev)) {
+                dispatch_run(ev);
+                continue;
+            }
+            break;
+        }
+    }
+}
+
+void dispatch_register(dispatch_event_id id, dispatch_handler *handler) {
+    assert(id < DISPATCH_EVENT_NUM);
+    for (dispatch_handler *&slot : dispatch_handlers[id]) {
+        if (slot == nullptr) {
+            slot = handler;
+            return;
+        }
+    }
+    assert(!"Too many handlers");
+}
+
+void dispatch_post(dispatch_event &ev) {
+    assert(ev.id < DISPATCH_EVENT_NUM);
+    ev.post_time = esp_timer_get_time();
+
+    bool coalesced = false;
+    bool dropped = false;
+    portENTER_CRITICAL(&dispatch_queue_lock);
+    if (dispatch_policies[ev.id] == DISPATCH_POLICY_COALESCE) {
+        for (uint32_t i = 0; i < dispatch_queue_count; i++) {
+            uint32_t idx = (dispatch_queue_head + i) % DISPATCH_QUEUE_LEN;
+            if (dispatch_queue[idx].id == ev.id) {
+                dispatch_queue[idx] = ev;
+                coalesced = true;
+                break;
+            }
+        }
+    }
+    if (!coalesced) {
+        if (dispatch_queue_count < DISPATCH_QUEUE_LEN) {
+            uint32_t idx =
+                (dispatch_queue_head + dispatch_queue_count) %
+                DISPATCH_QUEUE_LEN;
+            dispatch_queue[idx] = ev;
+            dispatch_queue_count++;
+        } else {
+            dropped = true;
+        }
+    }
+    uint32_t depth = dispatch_queue_count;
+    portEXIT_CRITICAL(&dispatch_queue_lock);
+
+    if (!dropped)
+        xTaskNotifyGive(dispatch_task_handle);
+
+    portENTER_CRITICAL(&dispatch_stats_lock);
+    dispatch_stats &stats = dispatch_cur_stats;
+    if (depth > stats.queue_hwm)
+        stats.queue_hwm = depth;
+    if (coalesced)
+        stats.queue_coalesced++;
+    if (dropped)
+        stats.queue_drops++;
+    portEXIT_CRITICAL(&dispatch_stats_lock);
+
+    if (dropped)
+        trace(TRACE_ID_DISPATCH_DROP, ev.id, 0);
+}
+
+void dispatch_post_presence(dispatch_event &ev) {
+    ev.post_time = esp_timer_get_time();
+    bool replaced = false;
+    if (dispatch_presence_latest_valid.load(std::memory_order_acquire) ||
+        !dispatch_presence_ring.push(ev)
+    ) {
+        portENTER_CRITICAL(&dispatch_presence_lock);
+        replaced =
+            dispatch_presence_latest_valid.load(std::memory_order_relaxed);
+        dispatch_presence_latest = ev;
+        dispatch_presence_latest_valid.store(true, std::memory_order_release);
+        portEXIT_CRITICAL(&dispatch_presence_lock);
+    }
+    xTaskNotifyGive(dispatch_task_handle);
+    uint32_t depth = dispatch_presence_ring.size();
+    portENTER_CRITICAL(&dispatch_stats_lock);
+    if (replaced)
+        dispatch_cur_stats.presence_overflows++;
+    if (depth > dispatch_cur_stats.presence_hwm)
+        dispatch_cur_stats.presence_hwm = depth;
+    portEXIT_CRITICAL(&dispatch_stats_lock);
+    if (replaced)
+        trace(TRACE_ID_DISPATCH_DROP, ev.id, 1);
+}
+
+void dispatch_get_stats(dispatch_stats *stats) {
+    portENTER_CRITICAL(&dispatch_stats_lock);
+    *stats = dispatch_cur_stats;
+    portEXIT_CRITICAL(&dispatch_stats_lock);
+    portENTER_CRITICAL(&dispatch_queue_lock);
+    stats->queue_depth = dispatch_queue_count;
+    portEXIT_CRITICAL(&dispatch_queue_lock);
+    stats->presence_depth = dispatch_presence_ring.size();
+}
+
+void dispatch_init() {
+    dispatch_task_handle = tasks_create(TASKS_ID_DISPATCH, dispatch_task);
+    assert(dispatch_task_handle != NULL);
+}
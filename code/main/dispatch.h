@@ -0,0 +1,78 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+enum dispatch_event_id {
+    // Posted by rfid_task
+    DISPATCH_EVENT_RFID_PRESENT,
+    DISPATCH_EVENT_RFID_ABSENT,
+    // Posted by the momentary timer
+    DISPATCH_EVENT_MOMENTARY_TIMER,
+    // Emitted by the ACL decision stage
+    DISPATCH_EVENT_RFID_ERR,
+    DISPATCH_EVENT_RFID_OK,
+    DISPATCH_EVENT_RFID_BAD,
+    DISPATCH_EVENT_RFID_NONE,
+    // Posted by conf_watch
+    DISPATCH_EVENT_CONF_CHANGED,
+    // Posted by net_watch
+    DISPATCH_EVENT_NET_CHANGED,
+    DISPATCH_EVENT_NUM,
+};
+
+struct dispatch_event {
+    dispatch_event_id id;
+    union {
+        uint32_t dummy;
+        uint32_t rfid;
+        uint32_t timer_epoch;
+    };
+    // esp_timer_get_time() when posted; filled in by dispatch_post().
+    int64_t post_time;
+    // For RFID_PRESENT, rfid_get_rx_time() for the card's frame.
+    int64_t rx_time;
+};
+
+typedef void dispatch_handler(const dispatch_event &ev);
+
+struct dispatch_stats {
+    uint32_t events;
+    uint32_t queue_hwm;
+    // Events replaced by a newer event with the same ID while queued
+    uint32_t queue_coalesced;
+    // Events dropped because the queue was full
+    uint32_t queue_drops;
+    // Current depths, when dispatch_get_stats() was called
+    uint32_t queue_depth;
+    uint32_t presence_depth;
+    uint32_t presence_hwm;
+    // Presence events dropped because the ring was full and a newer one
+    // replaced them; the latest is never dropped
+    uint32_t presence_overflows;
+    // Time from dispatch_post() until handlers start running
+    int64_t latency_us_sum;
+    int64_t latency_us_max;
+    // Time spent running all handlers for one event
+    int64_t handler_us_sum;
+    int64_t handler_us_max;
+};
+
+extern void dispatch_init();
+// Handlers run in registration order. All registration must be complete
+// before the first event is posted.
+extern void dispatch_register(dispatch_event_id id, dispatch_handler *handler);
+// Queue an event to the dispatch task. Safe to call from any task. Never
+// blocks; see dispatch.cpp for what happens when the queue is full.
+extern void dispatch_post(dispatch_event &ev);
+// Hand a presence event to the dispatch task via a lock-free ring. Never
+// blocks; if the ring is full, the latest event is still delivered, and
+// older ones it supersedes are dropped and counted. Must only be called from
+// rfid_task.
+extern void dispatch_post_presence(dispatch_event &ev);
+// Run all handlers for an event immediately. Only for use from handlers,
+// which already run in the dispatch task.
+extern void dispatch_emit(const dispatch_event &ev);
+extern void dispatch_get_stats(dispatch_stats *stats);
@@ -0,0 +1,176 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <stdio.h>
+
+#include <esp_http_server.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "dispatch.h"
+#include "fcch_connmgr/cm.h"
+#include "latency.h"
+
+const uint32_t latency_bucket_bounds_us[LATENCY_BUCKETS - 1] = {
+    100, 200, 500,
+    1000, 2000, 5000,
+    10000, 20000, 50000,
+    100000, 200000, 500000,
+    1000000, 2000000, 5000000,
+};
+
+static const char *latency_stage_names[LATENCY_STAGE_NUM] = {
+    [LATENCY_STAGE_RFID] = "rfid",
+    [LATENCY_STAGE_QUEUE] = "queue",
+    [LATENCY_STAGE_PRE_ACL] = "pre_acl",
+    [LATENCY_STAGE_ACL] = "acl",
+    [LATENCY_STAGE_DECISION] = "decision",
+    [LATENCY_STAGE_POST_ACL] = "post_acl",
+    [LATENCY_STAGE_TOTAL] = "total",
+    [LATENCY_STAGE_FAST_GRANT] = "fast_grant",
+};
+
+static portMUX_TYPE latency_lock = portMUX_INITIALIZER_UNLOCKED;
+static latency_histogram latency_hists[LATENCY_STAGE_NUM];
+
+// Only touched by the dispatch task, so needs no locking. A time of 0 means
+// the stage hasn't been reached in this session.
+struct latency_session {
+    bool active;
+    int64_t rx_time;
+    int64_t dispatch_time;
+    int64_t acl_start_time;
+    int64_t decision_time;
+};
+
+static latency_session latency_cur_session;
+
+const char *latency_stage_name(latency_stage stage) {
+    assert(stage < LATENCY_STAGE_NUM);
+    return latency_stage_names[stage];
+}
+
+void latency_record(latency_stage stage, int64_t us) {
+    assert(stage < LATENCY_STAGE_NUM);
+    if (us < 0)
+        us = 0;
+    uint32_t us32 = (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 &&
+        us32 > latency_bucket_bounds_us[bucket]
+    ) {
+        bucket++;
+    }
+
+    portENTER_CRITICAL(&latency_lock);
+    latency_histogram &hist = latency_hists[stage];
+    hist.buckets[bucket]++;
+    hist.count++;
+    hist.sum_us += us32;
+    if (us32 > hist.max_us)
+        hist.max_us = us32;
+    portEXIT_CRITICAL(&latency_lock);
+}
+
+void latency_get(latency_stage stage, latency_histogram *hist) {
+    assert(stage < LATENCY_STAGE_NUM);
+    portENTER_CRITICAL(&latency_lock);
+    *hist = latency_hists[stage];
+    portEXIT_CRITICAL(&latency_lock);
+}
+
+static void latency_on_event_rfid_present(const dispatch_event &ev) {
+    int64_t now = esp_timer_get_time();
+    latency_cur_session = {
+        .active = ev.rx_time != 0,
+        .rx_time = ev.rx_time,
+        .dispatch_time = now,
+        .acl_start_time = 0,
+        .decision_time = 0,
+    };
+    if (!latency_cur_session.active)
+        return;
+    latency_record(LATENCY_STAGE_RFID, ev.post_time - ev.rx_time);
+    latency_record(LATENCY_STAGE_QUEUE, now - ev.post_time);
+}
+
+void latency_stamp_acl_start() {
+    latency_session &s = latency_cur_session;
+    if (!s.active)
+        return;
+    s.acl_start_time = esp_timer_get_time();
+    latency_record(LATENCY_STAGE_PRE_ACL, s.acl_start_time - s.dispatch_time);
+}
+
+void latency_stamp_decision() {
+    latency_session &s = latency_cur_session;
+    if (!s.active || !s.acl_start_time)
+        return;
+    s.decision_time = esp_timer_get_time();
+    latency_record(LATENCY_STAGE_ACL, s.decision_time - s.acl_start_time);
+    latency_record(LATENCY_STAGE_DECISION, s.decision_time - s.rx_time);
+}
+
+void latency_stamp_relay() {
+    latency_session &s = latency_cur_session;
+    if (!s.active || !s.decision_time)
+        return;
+    int64_t now = esp_timer_get_time();
+    latency_record(LATENCY_STAGE_POST_ACL, now - s.decision_time);
+    latency_record(LATENCY_STAGE_TOTAL, now - s.rx_time);
+    s.active = false;
+}
+
+int64_t latency_get_decision_us() {
+    const latency_session &s = latency_cur_session;
+    if (!s.decision_time)
+        return -1;
+    return s.decision_time - s.rx_time;
+}
+
+static esp_err_t latency_http_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "text/plain");
+    // Wide enough for a row with every column at its widest (10 digits).
+    char line[256];
+    int len = snprintf(line, sizeof(line), "%-10s %7s %9s %9s",
+        "stage", "count", "avg_us", "max_us");
+    for (int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+        len += snprintf(line + len, sizeof(line) - len, " %7lu",
+            latency_bucket_bounds_us[i]);
+    }
+    snprintf(line + len, sizeof(line) - len, "    +Inf\n");
+    esp_err_t err = httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN);
+
+    for (int stage = 0; (err == ESP_OK) && (stage < LATENCY_STAGE_NUM);
+        stage++
+    ) {
+        latency_histogram hist;
+        latency_get((latency_stage)stage, &hist);
+        uint32_t avg_us = hist.count ? (uint32_t)(hist.sum_us / hist.count) : 0;
+        len = snprintf(line, sizeof(line), "%-10s %7lu %9lu %9lu",
+            latency_stage_names[stage], hist.count, avg_us, hist.max_us);
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            len += snprintf(line + len, sizeof(line) - len, " %7lu",
+                hist.buckets[i]);
+        }
+        snprintf(line + len, sizeof(line) - len, "\n");
+        err = httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN);
+    }
+    if (err == ESP_OK)
+        err = httpd_resp_send_chunk(req, NULL, 0);
+    return err;
+}
+
+static const httpd_uri_t latency_http_uri = {
+    .uri = "/latency",
+    .method = HTTP_GET,
+    .handler = latency_http_handler,
+    .user_ctx = NULL,
+};
+
+void latency_init() {
+    cm_http_register_uri_handler(&latency_http_uri);
+    dispatch_register(DISPATCH_EVENT_RFID_PRESENT,
+        latency_on_event_rfid_present);
+}
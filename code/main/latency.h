@@ -0,0 +1,58 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+// Swipe-to-relay latency, per stage. Each card presentation is a session,
+// stamped as it passes through each stage; the time spent in each stage is
+// added to a fixed-bucket histogram.
+
+enum latency_stage {
+    // rfid_task receiving the UART data to posting the presence event; this
+    // includes frame decode and the fast grant path.
+    LATENCY_STAGE_RFID,
+    // Presence event queued, waiting for the dispatch task.
+    LATENCY_STAGE_QUEUE,
+    // Dispatch task start to ACL request start (momentary logic).
+    LATENCY_STAGE_PRE_ACL,
+    // ACL request round trip.
+    LATENCY_STAGE_ACL,
+    // UART data to decision, for every decision.
+    LATENCY_STAGE_DECISION,
+    // Decision to relay_write(), for grants.
+    LATENCY_STAGE_POST_ACL,
+    // UART data to relay_write(), for grants.
+    LATENCY_STAGE_TOTAL,
+    // UART data to relay_write(), for fast grants from cache.
+    LATENCY_STAGE_FAST_GRANT,
+    LATENCY_STAGE_NUM,
+};
+
+// Upper bounds (inclusive, us) of each bucket but the last, which is
+// unbounded.
+#define LATENCY_BUCKETS 16
+extern const uint32_t latency_bucket_bounds_us[LATENCY_BUCKETS - 1];
+
+struct latency_histogram {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+};
+
+extern void latency_init();
+extern const char *latency_stage_name(latency_stage stage);
+extern void latency_get(latency_stage stage, latency_histogram *hist);
+// Safe to call from any task.
+extern void latency_record(latency_stage stage, int64_t us);
+
+// Session stamps. These must be called from the dispatch task. A session
+// begins when the dispatch task receives an RFID_PRESENT event.
+extern void latency_stamp_acl_start();
+extern void latency_stamp_decision();
+extern void latency_stamp_relay();
+// The current session's UART-data-to-decision time, or -1 if the session has
+// no decision yet. Must be called from the dispatch task.
+extern int64_t latency_get_decision_us();
@@ -2,16 +2,26 @@
 // SPDX-License-Identifier: MIT
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <LovyanGFX.hpp>
+#include <new>
+#include <sys/param.h>
 
 #include "app_config.h"
+#include "conf_watch.h"
+#include "dispatch.h"
 #include "fcch_connmgr/cm.h"
 #include "fcch_connmgr/cm_conf.h"
 #include "fcch_connmgr/cm_net.h"
 #include "fcch_connmgr/cm_mqtt.h"
 #include "fcch_connmgr/cm_util.h"
 #include "lcd.h"
+#include "lcd_band.h"
+#include "lcd_text.h"
+#include "net_watch.h"
+#include "stall.h"
+#include "tasks.h"
 
 // ideaspark® ESP32 Development Board 1.14 inch 135x240 LCD Display,CH340,WiFi+BL
 // ideaspark® ESP32 Development Board 16MB 1.9 in 170x320 LCD Display,CH340,WiFi+BL
@@ -103,9 +113,39 @@ static cm_conf_item lcd_item_lcd_show_rfids = {
     .default_func = &cm_conf_default_u16_0,
 };
 
+static uint16_t lcd_dim_minutes;
+static cm_conf_item lcd_item_dim_minutes = {
+    .slug_name = "dm", // DiM
+    .text_name = "Dim Backlight After Idle (Minutes, 0 for 5)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &lcd_dim_minutes },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static uint16_t lcd_dim_brightness;
+static cm_conf_item lcd_item_dim_brightness = {
+    .slug_name = "db", // Dim Brightness
+    .text_name = "Dimmed Backlight Brightness (1-255, 0 for 16)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &lcd_dim_brightness },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static uint16_t lcd_sleep_minutes;
+static cm_conf_item lcd_item_sleep_minutes = {
+    .slug_name = "sl", // SLeep
+    .text_name = "Sleep Display After Idle (Minutes, 0 for 60)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &lcd_sleep_minutes },
+    .default_func = &cm_conf_default_u16_0,
+};
+
 static cm_conf_item *lcd_items[] = {
     &lcd_item_lcd_type,
     &lcd_item_lcd_show_rfids,
+    &lcd_item_dim_minutes,
+    &lcd_item_dim_brightness,
+    &lcd_item_sleep_minutes,
 };
 
 static cm_conf_page lcd_conf_page = {
@@ -129,22 +169,6 @@ static const char *lcd_http_action_show_rfids_toggle_description() {
     }
 }
 
-enum lcd_message_id {
-    LCD_MESSAGE_TIMER,
-    LCD_MESSAGE_RFID_ERR,
-    LCD_MESSAGE_RFID_OK,
-    LCD_MESSAGE_RFID_BAD,
-    LCD_MESSAGE_RFID_NONE,
-};
-
-struct lcd_message {
-    lcd_message_id id;
-    union {
-        uint32_t rfid;
-        uint32_t timer_epoch;
-    };
-};
-
 enum lcd_page {
     LCD_PAGE_IDENT,
     LCD_PAGE_AP,
@@ -154,7 +178,7 @@ enum lcd_page {
     LCD_PAGE_NUM,
 };
 
-#define BLOCK_TIME (10 / portTICK_PERIOD_MS)
+#define LCD_PAGE_TIME ((2 * 1000) / portTICK_PERIOD_MS)
 
 class LcdDevice : public lgfx::LGFX_Device {
     lgfx::Panel_ST7735S m_panel_instance;
@@ -182,10 +206,6 @@ public:
         panel_cfg.pin_cs = DISPLAY_CS;
         panel_cfg.pin_rst = DISPLAY_RST;
         panel_cfg.pin_busy = DISPLAY_BUSY;
-        panel_cfg.panel_width = lcd_config->width;
-        panel_cfg.panel_height = lcd_config->height;
-        panel_cfg.offset_x = lcd_config->offset_x;
-        panel_cfg.offset_y = lcd_config->offset_y;
         panel_cfg.offset_rotation = 0;
         panel_cfg.dummy_read_pixel = 8;
         panel_cfg.dummy_read_bits = 1;
@@ -205,19 +225,62 @@ public:
         m_panel_instance.setLight(&m_light_instance);
 
         setPanel(&m_panel_instance);
+        set_geometry(lcd_config);
+    }
+
+    // Takes effect at the next init().
+    void set_geometry(const struct lcd_config *config) {
+        auto panel_cfg = m_panel_instance.config();
+        panel_cfg.panel_width = config->width;
+        panel_cfg.panel_height = config->height;
+        panel_cfg.offset_x = config->offset_x;
+        panel_cfg.offset_y = config->offset_y;
+        m_panel_instance.config(panel_cfg);
     }
 };
 
-static QueueHandle_t lcd_queue;
-static TimerHandle_t lcd_timer;
-static uint32_t lcd_timer_epoch;
+static TaskHandle_t lcd_task_handle;
 static int lcd_page;
-static TickType_t lcd_last_rfid_time;
-static lcd_message lcd_last_rfid_message{
-    .id = LCD_MESSAGE_RFID_NONE,
+// Card presence, an RFID decision, or a network state change. Only used by
+// lcd_task.
+static TickType_t lcd_last_activity;
+static lcd_power_state lcd_power;
+// Whether lcd->sleep() is in effect; only used by lcd_task.
+static bool lcd_asleep;
+// Latest RFID event from the dispatch task, not yet seen by lcd_task. Only the
+// latest matters for display, so events that arrive mid-redraw coalesce.
+static portMUX_TYPE lcd_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool lcd_pending_rfid_valid;
+static dispatch_event lcd_pending_rfid_event;
+static uint32_t lcd_coalesced;
+// Set when the LCD type changed, so lcd_task must re-initialize the panel.
+static bool lcd_reconfigure_pending;
+// Set when net_watch reported a change, not yet seen by lcd_task.
+static bool lcd_net_changed_pending;
+// Set when a card was presented, not yet seen by lcd_task.
+static bool lcd_presence_pending;
+// The network state shown by the status bar and the AP, STA and MQTT pages,
+// as of the last DISPATCH_EVENT_NET_CHANGED. Only used by lcd_task, so pages
+// are redrawn only when it or the page changes, never to poll.
+static net_watch_state lcd_net;
+static dispatch_event lcd_last_rfid_event{
+    .id = DISPATCH_EVENT_RFID_NONE,
     .rfid = 0,
 };
+// LcdDevice depends on lcd_config, which isn't known until lcd_init(), so it's
+// constructed in place there rather than being a plain static object.
+alignas(LcdDevice) static uint8_t lcd_storage[sizeof(LcdDevice)];
 static LcdDevice *lcd = nullptr;
+// Frames are drawn a band at a time, alternating between two sprites, so one
+// can be drawn while DMA sends the other. Only bands that changed are sent,
+// so there's no flicker, and a page flip typically sends a few text rows
+// rather than the whole panel. A full-frame sprite would need up to 106 KiB
+// of DMA-capable RAM; the two bands need at most 20 KiB.
+static lgfx::LGFX_Sprite lcd_band_sprites[2];
+static lcd_bands lcd_bands_sent;
+// Protected by lcd_lock. power_us excludes the time since lcd_power_since_us.
+static lcd_stats lcd_stats_val;
+static int64_t lcd_power_since_us;
 
 // Within a uint16_t, 5 bit per channel: b@11, g@6, grey@5, r@0
 // CONFUSING: Colors are interpreted differently if within a uint32_t.
@@ -232,167 +295,121 @@ static const uint16_t lcd_color_ok = gen_color_u16(0, 0x1f, 0);
 static const uint16_t lcd_color_bad = gen_color_u16(0x1f, 0, 0);
 static const uint16_t lcd_color_none = gen_color_u16(0, 0, 0);
 
-static bool lcd_sta_connected;
-static bool lcd_mqtt_connected;
+static bool lcd_stat_bar_ok(const net_watch_state &net) {
+    return net.sta.connected && (!net.mqtt.enabled || net.mqtt.connected);
+}
 
 static void lcd_msg(const char *s) {
     uint16_t bg;
-    switch (lcd_last_rfid_message.id) {
-    case LCD_MESSAGE_RFID_ERR:
+    switch (lcd_last_rfid_event.id) {
+    case DISPATCH_EVENT_RFID_ERR:
         bg = lcd_color_err;
         break;
-    case LCD_MESSAGE_RFID_OK:
+    case DISPATCH_EVENT_RFID_OK:
         bg = lcd_color_ok;
         break;
-    case LCD_MESSAGE_RFID_BAD:
+    case DISPATCH_EVENT_RFID_BAD:
         bg = lcd_color_bad;
         break;
-    case LCD_MESSAGE_RFID_NONE:
+    case DISPATCH_EVENT_RFID_NONE:
         bg = lcd_color_none;
         break;
     default:
-        ESP_LOGE(TAG, "Unknown last RFID message %d", lcd_last_rfid_message.id);
+        ESP_LOGE(TAG, "Unknown last RFID event %d", lcd_last_rfid_event.id);
         bg = gen_color_u16(0x1f, 0, 0x1f);
         break;
     }
 
-    lcd->clear(bg);
     uint16_t stat_bar_color;
-    if (!lcd_sta_connected || !lcd_mqtt_connected)
+    if (!lcd_stat_bar_ok(lcd_net))
         stat_bar_color = lcd_color_err;
     else
         stat_bar_color = lcd_color_ok;
-    lcd->setColor(stat_bar_color);
-    lcd->fillRect(0, lcd_config->height - 8, lcd_config->width, 8);
-    lcd->setCursor(0, 0);
-    lcd->setTextSize(lcd_config->font_size);
-    lcd->setTextColor(TFT_WHITE);
-    lcd->println(s);
-}
-
-static void lcd_on_timer(TimerHandle_t xTimer) {
-    lcd_message msg{
-        .id = LCD_MESSAGE_TIMER,
-        .timer_epoch = lcd_timer_epoch,
-    };
-    assert(xQueueSend(lcd_queue, &msg, BLOCK_TIME) == pdTRUE);
-}
-
-char *stpcat_trunc(char *p, const char *s, size_t len) {
-    p = stpncpy(p, s, 16);
-    if (strlen(s) > 16) {
-        p[-1] = '.';
-        p[-2] = '.';
-        p[-3] = '.';
+    int stat_bar_y = lcd_config->height - 8;
+
+    int64_t start = esp_timer_get_time();
+    uint32_t sent = 0;
+    uint32_t skipped = 0;
+    uint32_t spi_bytes = 0;
+    int sprite = 0;
+    lcd->startWrite();
+    for (int band = 0, y = 0; y < lcd_config->height;
+        band++, y += LCD_BAND_HEIGHT
+    ) {
+        auto *band_sprite = &lcd_band_sprites[sprite];
+        band_sprite->clear(bg);
+        if (stat_bar_y < y + LCD_BAND_HEIGHT) {
+            band_sprite->setColor(stat_bar_color);
+            band_sprite->fillRect(0, stat_bar_y - y, lcd_config->width, 8);
+        }
+        // Text outside the band is clipped.
+        band_sprite->setCursor(0, -y);
+        band_sprite->setTextSize(lcd_config->font_size);
+        band_sprite->setTextColor(TFT_WHITE);
+        band_sprite->println(s);
+
+        size_t pixels =
+            lcd_config->width * MIN(LCD_BAND_HEIGHT, lcd_config->height - y);
+        if (!lcd_bands_update(&lcd_bands_sent, band,
+            (const uint16_t *)band_sprite->getBuffer(), pixels)
+        ) {
+            skipped++;
+            continue;
+        }
+        // Returns once the transfer has started; the next band is drawn in
+        // the other sprite meanwhile.
+        band_sprite->pushSprite(lcd, 0, y);
+        sent++;
+        spi_bytes += pixels * sizeof(uint16_t);
+        sprite ^= 1;
     }
-    return p;
+    lcd->waitDMA();
+    lcd->endWrite();
+    uint32_t frame_us = esp_timer_get_time() - start;
+
+    portENTER_CRITICAL(&lcd_lock);
+    lcd_stats_val.frames++;
+    lcd_stats_val.bands_sent += sent;
+    lcd_stats_val.bands_skipped += skipped;
+    lcd_stats_val.spi_bytes += spi_bytes;
+    lcd_stats_val.frame_us_sum += frame_us;
+    lcd_stats_val.frame_us_max = MAX(lcd_stats_val.frame_us_max, frame_us);
+    portEXIT_CRITICAL(&lcd_lock);
 }
 
 static void lcd_draw_page_ident() {
-    bool is_protected = cm_admin_is_protected();
-
-    char buf[64];
-    char *p = stpcpy(buf, "ID\n");
-    p = stpcat_trunc(p, cm_net_hostname, 16);
-    if (is_protected)
-        p = stpcpy(p, "\nadmin protected");
-    else
-        p = stpcpy(p, "\nadmin open");
-    *p = '\0';
+    char buf[LCD_TEXT_BUF_SIZE];
+    lcd_text_ident(buf, cm_net_hostname, cm_admin_is_protected());
     lcd_msg(buf);
 }
 
-#define U32IP2STR(ip) \
-    uint32_t(((ip) >>  0) & 0xff), \
-    uint32_t(((ip) >>  8) & 0xff), \
-    uint32_t(((ip) >> 16) & 0xff), \
-    uint32_t(((ip) >> 24) & 0xff)
-
 static void lcd_draw_page_ap() {
-    auto ap_info = cm_net_get_ap_info();
-
-    char buf[64];
-    char *p = stpcpy(buf, "AP ");
-    if (ap_info.enabled) {
-        p = stpcpy(p, "enabled\n");
-        p = stpcat_trunc(p, ap_info.network, 16);
-        p += sprintf(p, "\n%lu.%lu.%lu.%lu", U32IP2STR(ap_info.ip));
-    } else {
-        p = stpcpy(p, "disabled\n");
-    }
-    *p = '\0';
+    const auto &ap_info = lcd_net.ap;
+
+    char buf[LCD_TEXT_BUF_SIZE];
+    lcd_text_ap(buf, ap_info.enabled, ap_info.network, ap_info.ip);
     lcd_msg(buf);
 }
 
 static void lcd_draw_page_sta() {
-    auto sta_info = cm_net_get_sta_info();
-    lcd_sta_connected = sta_info.connected;
-
-    char buf[64];
-    char *p = stpcpy(buf, "STA ");
-    if (sta_info.connected) {
-        p = stpcpy(p, "connected\n");
-        p = stpcat_trunc(p, sta_info.network, 16);
-    } else {
-        p = stpcpy(p, "disconnected\n");
-    }
-    if (sta_info.has_ip) {
-        p += sprintf(p, "\n%lu.%lu.%lu.%lu", U32IP2STR(sta_info.ip));
-    }
-    *p = '\0';
+    const auto &sta_info = lcd_net.sta;
+
+    char buf[LCD_TEXT_BUF_SIZE];
+    lcd_text_sta(buf, sta_info.connected, sta_info.network, sta_info.has_ip,
+        sta_info.ip);
     lcd_msg(buf);
 }
 
 static void lcd_draw_page_mqtt() {
-    auto mqtt_info = cm_mqtt_get_info();
-    lcd_mqtt_connected = (!mqtt_info.enabled) || mqtt_info.connected;
-
-    char buf[64];
-    char *p = stpcpy(buf, "MQTT ");
-    if (mqtt_info.connected) {
-        p = stpcpy(p, "connected\n");
-    } else {
-        p = stpcpy(p, "disconnected\n");
-    }
-    p = stpcat_trunc(p, cm_mqtt_client_name, 16);
-    *p = '\0';
+    char buf[LCD_TEXT_BUF_SIZE];
+    lcd_text_mqtt(buf, lcd_net.mqtt.connected, cm_mqtt_client_name);
     lcd_msg(buf);
 }
 
 static void lcd_draw_page_rfid() {
-    char buf[64];
-    char *p = stpcpy(buf, "RFID ");
-    switch (lcd_last_rfid_message.id) {
-    case LCD_MESSAGE_RFID_ERR:
-        p = stpcpy(p, "comms error");
-        break;
-    case LCD_MESSAGE_RFID_OK:
-        p = stpcpy(p, "granted");
-        break;
-    case LCD_MESSAGE_RFID_BAD:
-        p = stpcpy(p, "denied");
-        break;
-    case LCD_MESSAGE_RFID_NONE:
-        p = stpcpy(p, "not present");
-        break;
-    default:
-        p = stpcpy(p, "???");
-        break;
-    }
-    switch (lcd_last_rfid_message.id) {
-    case LCD_MESSAGE_RFID_ERR:
-    case LCD_MESSAGE_RFID_OK:
-    case LCD_MESSAGE_RFID_BAD:
-        if (lcd_show_rfids || lcd_show_rfids_override) {
-            p += sprintf(p, "\n%lu", lcd_last_rfid_message.rfid);
-        } else {
-            p = stpcpy(p, "\n<hidden>");
-        }
-        break;
-    default:
-        break;
-    }
-    *p = '\0';
+    char buf[LCD_TEXT_BUF_SIZE];
+    lcd_text_rfid(buf, lcd_last_rfid_event.id, lcd_last_rfid_event.rfid,
+        lcd_show_rfids || lcd_show_rfids_override);
     lcd_msg(buf);
 }
 
@@ -419,139 +436,284 @@ static void lcd_draw_page() {
     }
 }
 
-static void lcd_on_msg_timer(lcd_message &msg) {
-    if (msg.timer_epoch != lcd_timer_epoch) {
-        ESP_LOGW(TAG, "epoch mismatch: msg:%" PRIu32 ", state:%" PRIu32,
-            msg.timer_epoch, lcd_timer_epoch);
-        return;
-    }
+static void lcd_next_page() {
     lcd_page++;
     if (lcd_page >= LCD_PAGE_NUM)
         lcd_page = 0;
 }
 
-static void lcd_on_msg_rfid_any(lcd_message &msg) {
-    if (lcd_last_rfid_message.id == LCD_MESSAGE_RFID_NONE &&
-        msg.id == LCD_MESSAGE_RFID_NONE
+// Returns true if the page rotation should restart from now.
+static bool lcd_on_rfid_event(const dispatch_event &ev) {
+    if (lcd_last_rfid_event.id == DISPATCH_EVENT_RFID_NONE &&
+        ev.id == DISPATCH_EVENT_RFID_NONE
     ) {
-        return;
+        return false;
     }
-    lcd_last_rfid_time = xTaskGetTickCount();
-    lcd_last_rfid_message = msg;
-    assert(xTimerStop(lcd_timer, BLOCK_TIME) == pdPASS);
-    lcd_timer_epoch++;
+    lcd_last_rfid_event = ev;
     lcd_page = LCD_PAGE_RFID;
-    assert(xTimerStart(lcd_timer, BLOCK_TIME) == pdPASS);
+    return true;
 }
 
-static void lcd_on_msg_rfid_err(lcd_message &msg) {
-    lcd_on_msg_rfid_any(msg);
+// Returns true if the display must be redrawn.
+static bool lcd_on_net_changed() {
+    net_watch_state net;
+    net_watch_get(&net);
+    bool redraw = lcd_stat_bar_ok(net) != lcd_stat_bar_ok(lcd_net);
+    switch (lcd_page) {
+    case LCD_PAGE_AP:
+    case LCD_PAGE_STA:
+    case LCD_PAGE_MQTT:
+        redraw = true;
+        break;
+    default:
+        break;
+    }
+    lcd_net = net;
+    return redraw;
+}
+
+static const char *const lcd_power_names[LCD_POWER_NUM] = {
+    [LCD_POWER_ON] = "on",
+    [LCD_POWER_DIM] = "dim",
+    [LCD_POWER_SLEEP] = "sleep",
+};
+
+const char *lcd_power_state_name(lcd_power_state state) {
+    if (state >= LCD_POWER_NUM)
+        return "unknown";
+    return lcd_power_names[state];
+}
+
+static TickType_t lcd_minutes_to_ticks(uint16_t minutes, uint16_t dflt) {
+    if (!minutes)
+        minutes = dflt;
+    return ((TickType_t)minutes * 60 * 1000) / portTICK_PERIOD_MS;
+}
+
+static lcd_power_state lcd_power_for_idle(TickType_t idle) {
+    if (idle >= lcd_minutes_to_ticks(lcd_sleep_minutes, 60))
+        return LCD_POWER_SLEEP;
+    if (idle >= lcd_minutes_to_ticks(lcd_dim_minutes, 5))
+        return LCD_POWER_DIM;
+    return LCD_POWER_ON;
+}
+
+// Ticks until lcd_power_for_idle() next changes, as idle grows.
+static TickType_t lcd_power_wait(TickType_t idle) {
+    TickType_t wait = portMAX_DELAY;
+    TickType_t thresholds[] = {
+        lcd_minutes_to_ticks(lcd_dim_minutes, 5),
+        lcd_minutes_to_ticks(lcd_sleep_minutes, 60),
+    };
+    for (TickType_t threshold : thresholds) {
+        if (idle < threshold)
+            wait = MIN(wait, threshold - idle);
+    }
+    return wait;
 }
 
-static void lcd_on_msg_rfid_ok(lcd_message &msg) {
-    lcd_on_msg_rfid_any(msg);
+// Puts the panel and backlight into lcd_power's state. The panel keeps its
+// content while asleep, so waking needs no redraw.
+static void lcd_apply_power() {
+    if (lcd_power == LCD_POWER_SLEEP) {
+        lcd->setBrightness(0);
+        if (!lcd_asleep)
+            lcd->sleep();
+        lcd_asleep = true;
+        return;
+    }
+    if (lcd_asleep)
+        lcd->wakeup();
+    lcd_asleep = false;
+    uint8_t brightness = 255;
+    if (lcd_power == LCD_POWER_DIM)
+        brightness = lcd_dim_brightness ? MIN(lcd_dim_brightness, 255) : 16;
+    lcd->setBrightness(brightness);
 }
 
-static void lcd_on_msg_rfid_bad(lcd_message &msg) {
-    lcd_on_msg_rfid_any(msg);
+static void lcd_set_power(lcd_power_state state) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&lcd_lock);
+    lcd_stats_val.power_us[lcd_power] += now - lcd_power_since_us;
+    lcd_power_since_us = now;
+    lcd_power = state;
+    portEXIT_CRITICAL(&lcd_lock);
+    ESP_LOGI(TAG, "Display %s", lcd_power_names[state]);
+    lcd_apply_power();
 }
 
-static void lcd_on_msg_rfid_none(lcd_message &msg) {
-    lcd_on_msg_rfid_any(msg);
+// After lcd->init(), the panel's content is unknown, and its width may have
+// changed.
+static void lcd_create_band_sprites() {
+    for (auto &band_sprite : lcd_band_sprites) {
+        band_sprite.deleteSprite();
+        band_sprite.setColorDepth(16);
+        assert(band_sprite.createSprite(lcd_config->width, LCD_BAND_HEIGHT));
+    }
+    assert((lcd_config->height + LCD_BAND_HEIGHT - 1) / LCD_BAND_HEIGHT <=
+        LCD_BAND_MAX);
+    lcd_bands_invalidate(&lcd_bands_sent);
+}
+
+static void lcd_reconfigure() {
+    ESP_LOGI(TAG, "LCD type %u", lcd_type);
+    lcd_config = &(lcd_configs[lcd_type]);
+    lcd->set_geometry(lcd_config);
+    assert(lcd->init());
+    lcd_asleep = false;
+    lcd_apply_power();
+    lcd_create_band_sprites();
 }
 
 static void lcd_task(void *pvParameters) {
     assert(lcd->init());
-    lcd->setBrightness(255);
+    lcd_apply_power();
+    lcd_create_band_sprites();
 
-    assert(xTimerStart(lcd_timer, BLOCK_TIME));
+    TickType_t page_start = xTaskGetTickCount();
+    lcd_last_activity = page_start;
+    bool redraw = true;
 
     for (;;) {
-        lcd_draw_page();
-
-        lcd_message msg;
-        assert(xQueueReceive(lcd_queue, &msg, portMAX_DELAY) == pdTRUE);
-        ESP_LOGD(TAG, "msg.id %d", msg.id);
-        switch (msg.id) {
-        case LCD_MESSAGE_TIMER:
-            lcd_on_msg_timer(msg);
-            break;
-        case LCD_MESSAGE_RFID_ERR:
-            lcd_on_msg_rfid_err(msg);
-            break;
-        case LCD_MESSAGE_RFID_OK:
-            lcd_on_msg_rfid_ok(msg);
-            break;
-        case LCD_MESSAGE_RFID_BAD:
-            lcd_on_msg_rfid_bad(msg);
-            break;
-        case LCD_MESSAGE_RFID_NONE:
-            lcd_on_msg_rfid_none(msg);
-            break;
-        default:
-            ESP_LOGE(TAG, "Unknown message: %d", (int)msg.id);
-            break;
+        // Nothing is drawn while asleep; the page is redrawn on waking.
+        if (redraw && lcd_power != LCD_POWER_SLEEP) {
+            stall_enter(STALL_ID_LCD, lcd_page);
+            lcd_draw_page();
+            stall_exit(STALL_ID_LCD);
+            redraw = false;
+        }
+
+        // While asleep, pages aren't rotated, and only an event wakes the
+        // task.
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = portMAX_DELAY;
+        if (lcd_power != LCD_POWER_SLEEP) {
+            TickType_t elapsed = now - page_start;
+            wait = (elapsed < LCD_PAGE_TIME) ? LCD_PAGE_TIME - elapsed : 0;
+            wait = MIN(wait, lcd_power_wait(now - lcd_last_activity));
+        }
+        if (ulTaskNotifyTake(pdTRUE, wait)) {
+            portENTER_CRITICAL(&lcd_lock);
+            bool valid = lcd_pending_rfid_valid;
+            dispatch_event ev = lcd_pending_rfid_event;
+            lcd_pending_rfid_valid = false;
+            bool reconfigure = lcd_reconfigure_pending;
+            lcd_reconfigure_pending = false;
+            bool net_changed = lcd_net_changed_pending;
+            lcd_net_changed_pending = false;
+            bool presence = lcd_presence_pending;
+            lcd_presence_pending = false;
+            portEXIT_CRITICAL(&lcd_lock);
+            if (valid || net_changed || presence)
+                lcd_last_activity = xTaskGetTickCount();
+            if (reconfigure) {
+                lcd_reconfigure();
+                redraw = true;
+            }
+            if (valid && lcd_on_rfid_event(ev)) {
+                page_start = xTaskGetTickCount();
+                redraw = true;
+            }
+            if (net_changed && lcd_on_net_changed())
+                redraw = true;
+        }
+
+        now = xTaskGetTickCount();
+        lcd_power_state power = lcd_power_for_idle(now - lcd_last_activity);
+        if (power != lcd_power) {
+            if (lcd_power == LCD_POWER_SLEEP) {
+                page_start = now;
+                redraw = true;
+            }
+            lcd_set_power(power);
+        }
+        if (lcd_power != LCD_POWER_SLEEP &&
+            now - page_start >= LCD_PAGE_TIME
+        ) {
+            lcd_next_page();
+            page_start = now;
+            redraw = true;
         }
     }
 }
 
+static void lcd_on_event_rfid_any(const dispatch_event &ev) {
+    portENTER_CRITICAL(&lcd_lock);
+    if (lcd_pending_rfid_valid)
+        lcd_coalesced++;
+    lcd_pending_rfid_event = ev;
+    lcd_pending_rfid_valid = true;
+    portEXIT_CRITICAL(&lcd_lock);
+    xTaskNotifyGive(lcd_task_handle);
+}
+
+// Only wakes the display; the decision that follows updates it.
+static void lcd_on_event_rfid_present(const dispatch_event &ev) {
+    portENTER_CRITICAL(&lcd_lock);
+    lcd_presence_pending = true;
+    portEXIT_CRITICAL(&lcd_lock);
+    xTaskNotifyGive(lcd_task_handle);
+}
+
+static void lcd_on_event_net_changed(const dispatch_event &ev) {
+    portENTER_CRITICAL(&lcd_lock);
+    lcd_net_changed_pending = true;
+    portEXIT_CRITICAL(&lcd_lock);
+    xTaskNotifyGive(lcd_task_handle);
+}
+
+uint32_t lcd_get_coalesced() {
+    portENTER_CRITICAL(&lcd_lock);
+    uint32_t ret = lcd_coalesced;
+    portEXIT_CRITICAL(&lcd_lock);
+    return ret;
+}
+
+void lcd_get_stats(lcd_stats *stats) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&lcd_lock);
+    *stats = lcd_stats_val;
+    stats->power = lcd_power;
+    stats->power_us[lcd_power] += now - lcd_power_since_us;
+    portEXIT_CRITICAL(&lcd_lock);
+}
+
+// Runs in the dispatch task. The type item's replace_invalid_value keeps it in
+// range; the show RFIDs item is read at each redraw, so needs no action.
+static void lcd_on_conf_changed() {
+    if (lcd_type >= ARRAY_SIZE(lcd_configs) ||
+        &(lcd_configs[lcd_type]) == lcd_config
+    ) {
+        return;
+    }
+    portENTER_CRITICAL(&lcd_lock);
+    lcd_reconfigure_pending = true;
+    portEXIT_CRITICAL(&lcd_lock);
+    xTaskNotifyGive(lcd_task_handle);
+}
+
 void lcd_register_conf() {
     cm_conf_register_page(&lcd_conf_page);
 }
 
 void lcd_init() {
     lcd_config = &(lcd_configs[lcd_type]);
-    lcd = new LcdDevice();
-
-    lcd_queue = xQueueCreate(8, sizeof(lcd_message));
-    assert(lcd_queue != NULL);
+    lcd = new (lcd_storage) LcdDevice();
 
-    lcd_timer = xTimerCreate(
-        "lcd",
-        (2 * 1000) / portTICK_PERIOD_MS,
-        pdTRUE,
-        NULL,
-        lcd_on_timer);
-    assert(lcd_timer != NULL);
-
-    BaseType_t xRet = xTaskCreate(lcd_task, "lcd", 4096, NULL, 5, NULL);
-    assert(xRet == pdPASS);
+    lcd_task_handle = tasks_create(TASKS_ID_LCD, lcd_task);
+    assert(lcd_task_handle != NULL);
 
     cm_http_register_home_action(
         "toggle-show-rfids",
         lcd_http_action_show_rfids_toggle_description,
         lcd_http_action_show_rfids_toggle
     );
-}
-
-void lcd_on_rfid_err(uint32_t rfid) {
-    lcd_message msg{
-        .id = LCD_MESSAGE_RFID_ERR,
-        .rfid = rfid,
-    };
-    assert(xQueueSend(lcd_queue, &msg, BLOCK_TIME) == pdTRUE);
-}
 
-void lcd_on_rfid_ok(uint32_t rfid) {
-    lcd_message msg{
-        .id = LCD_MESSAGE_RFID_OK,
-        .rfid = rfid,
-    };
-    assert(xQueueSend(lcd_queue, &msg, BLOCK_TIME) == pdTRUE);
-}
-
-void lcd_on_rfid_bad(uint32_t rfid) {
-    lcd_message msg{
-        .id = LCD_MESSAGE_RFID_BAD,
-        .rfid = rfid,
-    };
-    assert(xQueueSend(lcd_queue, &msg, BLOCK_TIME) == pdTRUE);
-}
-
-void lcd_on_rfid_none() {
-    lcd_message msg{
-        .id = LCD_MESSAGE_RFID_NONE,
-        .rfid = 0,
-    };
-    assert(xQueueSend(lcd_queue, &msg, BLOCK_TIME) == pdTRUE);
+    dispatch_register(DISPATCH_EVENT_RFID_PRESENT, lcd_on_event_rfid_present);
+    dispatch_register(DISPATCH_EVENT_RFID_ERR, lcd_on_event_rfid_any);
+    dispatch_register(DISPATCH_EVENT_RFID_OK, lcd_on_event_rfid_any);
+    dispatch_register(DISPATCH_EVENT_RFID_BAD, lcd_on_event_rfid_any);
+    dispatch_register(DISPATCH_EVENT_RFID_NONE, lcd_on_event_rfid_any);
+    dispatch_register(DISPATCH_EVENT_NET_CHANGED, lcd_on_event_net_changed);
+    conf_watch_register_page(&lcd_conf_page, lcd_on_conf_changed);
 }
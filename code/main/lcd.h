@@ -1,11 +1,32 @@
-// Copyright 2024-2025 Stephen Warren <swarren@wwwdotorg.org>
+// Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
 // SPDX-License-Identifier: MIT
 
 #pragma once
 
+#include <stdint.h>
+
+enum lcd_power_state {
+    LCD_POWER_ON,
+    LCD_POWER_DIM,   // Backlight dimmed
+    LCD_POWER_SLEEP, // Backlight off, panel asleep, pages not rotated
+    LCD_POWER_NUM,
+};
+
+// All monotonically increasing since boot, except frame_us_max and power.
+struct lcd_stats {
+    uint32_t frames;        // Redraws
+    uint32_t bands_sent;    // Bands that changed, so were sent to the panel
+    uint32_t bands_skipped; // Bands that were already on the panel
+    uint64_t spi_bytes;     // Pixel data sent to the panel
+    uint64_t frame_us_sum;  // Time to draw and send each frame
+    uint32_t frame_us_max;
+    lcd_power_state power;
+    uint64_t power_us[LCD_POWER_NUM]; // Time spent in each power state
+};
+
 extern void lcd_register_conf();
 extern void lcd_init();
-extern void lcd_on_rfid_err(uint32_t rfid);
-extern void lcd_on_rfid_ok(uint32_t rfid);
-extern void lcd_on_rfid_bad(uint32_t rfid);
-extern void lcd_on_rfid_none();
+// Number of RFID events superseded before lcd_task displayed them.
+extern uint32_t lcd_get_coalesced();
+extern void lcd_get_stats(lcd_stats *stats);
+extern const char *lcd_power_state_name(lcd_power_state state);
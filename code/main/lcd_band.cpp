@@ -0,0 +1,37 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <assert.h>
+#include <string.h>
+
+#include "lcd_band.h"
+
+// FNV-1a, a pixel at a time. Collisions only cost a stale band until it
+// next changes.
+uint32_t lcd_band_hash(const uint16_t *pixels, size_t count) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < count; i++) {
+        hash ^= pixels[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void lcd_bands_invalidate(lcd_bands *bands) {
+    memset(bands->valid, 0, sizeof(bands->valid));
+}
+
+bool lcd_bands_update(
+    lcd_bands *bands,
+    int band,
+    const uint16_t *pixels,
+    size_t count
+) {
+    assert(band >= 0 && band < LCD_BAND_MAX);
+    uint32_t hash = lcd_band_hash(pixels, count);
+    if (bands->valid[band] && bands->hashes[band] == hash)
+        return false;
+    bands->valid[band] = true;
+    bands->hashes[band] = hash;
+    return true;
+}
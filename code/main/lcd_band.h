@@ -0,0 +1,33 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Damage tracking for the LCD. A frame is drawn as horizontal bands of
+// LCD_BAND_HEIGHT rows; a hash of each band as last sent to the panel is
+// kept, so unchanged bands needn't be sent again.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LCD_BAND_HEIGHT 16
+// Enough for the tallest panel, 170 rows.
+#define LCD_BAND_MAX 11
+
+struct lcd_bands {
+    bool valid[LCD_BAND_MAX];
+    uint32_t hashes[LCD_BAND_MAX];
+};
+
+extern uint32_t lcd_band_hash(const uint16_t *pixels, size_t count);
+// Forget what the panel shows, e.g. after it's re-initialized, so every band
+// is sent next frame.
+extern void lcd_bands_invalidate(lcd_bands *bands);
+// Record band's new content. Returns true if it differs from what the panel
+// shows, so must be sent.
+extern bool lcd_bands_update(
+    lcd_bands *bands,
+    int band,
+    const uint16_t *pixels,
+    size_t count
+);
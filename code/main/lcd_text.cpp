@@ -0,0 +1,116 @@
+// Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lcd_text.h"
+
+char *stpcat_trunc(char *p, const char *s, size_t len) {
+    p = stpncpy(p, s, len);
+    if (strlen(s) > len) {
+        p[-1] = '.';
+        p[-2] = '.';
+        p[-3] = '.';
+    }
+    return p;
+}
+
+void lcd_text_ident(char *buf, const char *hostname, bool is_protected) {
+    char *p = stpcpy(buf, "ID\n");
+    p = stpcat_trunc(p, hostname, 16);
+    if (is_protected)
+        p = stpcpy(p, "\nadmin protected");
+    else
+        p = stpcpy(p, "\nadmin open");
+    *p = '\0';
+}
+
+#define U32IP2STR(ip) \
+    uint32_t(((ip) >>  0) & 0xff), \
+    uint32_t(((ip) >>  8) & 0xff), \
+    uint32_t(((ip) >> 16) & 0xff), \
+    uint32_t(((ip) >> 24) & 0xff)
+
+void lcd_text_ap(char *buf, bool enabled, const char *network, uint32_t ip) {
+    char *p = stpcpy(buf, "AP ");
+    if (enabled) {
+        p = stpcpy(p, "enabled\n");
+        p = stpcat_trunc(p, network, 16);
+        p += sprintf(p, "\n%lu.%lu.%lu.%lu", U32IP2STR(ip));
+    } else {
+        p = stpcpy(p, "disabled\n");
+    }
+    *p = '\0';
+}
+
+void lcd_text_sta(
+    char *buf,
+    bool connected,
+    const char *network,
+    bool has_ip,
+    uint32_t ip
+) {
+    char *p = stpcpy(buf, "STA ");
+    if (connected) {
+        p = stpcpy(p, "connected\n");
+        p = stpcat_trunc(p, network, 16);
+    } else {
+        p = stpcpy(p, "disconnected\n");
+    }
+    if (has_ip) {
+        p += sprintf(p, "\n%lu.%lu.%lu.%lu", U32IP2STR(ip));
+    }
+    *p = '\0';
+}
+
+void lcd_text_mqtt(char *buf, bool connected, const char *client_name) {
+    char *p = stpcpy(buf, "MQTT ");
+    if (connected) {
+        p = stpcpy(p, "connected\n");
+    } else {
+        p = stpcpy(p, "disconnected\n");
+    }
+    p = stpcat_trunc(p, client_name, 16);
+    *p = '\0';
+}
+
+void lcd_text_rfid(
+    char *buf,
+    dispatch_event_id id,
+    uint32_t rfid,
+    bool show_rfid
+) {
+    char *p = stpcpy(buf, "RFID ");
+    switch (id) {
+    case DISPATCH_EVENT_RFID_ERR:
+        p = stpcpy(p, "comms error");
+        break;
+    case DISPATCH_EVENT_RFID_OK:
+        p = stpcpy(p, "granted");
+        break;
+    case DISPATCH_EVENT_RFID_BAD:
+        p = stpcpy(p, "denied");
+        break;
+    case DISPATCH_EVENT_RFID_NONE:
+        p = stpcpy(p, "not present");
+        break;
+    default:
+        p = stpcpy(p, "???");
+        break;
+    }
+    switch (id) {
+    case DISPATCH_EVENT_RFID_ERR:
+    case DISPATCH_EVENT_RFID_OK:
+    case DISPATCH_EVENT_RFID_BAD:
+        if (show_rfid) {
+            p += sprintf(p, "\n%lu", rfid);
+        } else {
+            p = stpcpy(p, "\n<hidden>");
+        }
+        break;
+    default:
+        break;
+    }
+    *p = '\0';
+}
@@ -0,0 +1,41 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// LCD page text assembly. Each lcd_text_*() function writes one page's
+// NUL-terminated text to buf, which must hold LCD_TEXT_BUF_SIZE bytes.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dispatch.h"
+
+#define LCD_TEXT_BUF_SIZE 64
+
+// Append at most len characters of s at p, ending with "..." if s was
+// truncated. Returns the new end; doesn't NUL-terminate.
+extern char *stpcat_trunc(char *p, const char *s, size_t len);
+extern void lcd_text_ident(char *buf, const char *hostname, bool is_protected);
+// ip has the first octet in the low byte.
+extern void lcd_text_ap(
+    char *buf,
+    bool enabled,
+    const char *network,
+    uint32_t ip
+);
+extern void lcd_text_sta(
+    char *buf,
+    bool connected,
+    const char *network,
+    bool has_ip,
+    uint32_t ip
+);
+extern void lcd_text_mqtt(char *buf, bool connected, const char *client_name);
+// id is the last DISPATCH_EVENT_RFID_* decision.
+extern void lcd_text_rfid(
+    char *buf,
+    dispatch_event_id id,
+    uint32_t rfid,
+    bool show_rfid
+);
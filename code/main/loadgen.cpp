@@ -0,0 +1,271 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "dispatch.h"
+#include "fcch_connmgr/cm.h"
+#include "fcch_connmgr/cm_conf.h"
+#include "fcch_connmgr/cm_mqtt.h"
+#include "fcch_connmgr/cm_util.h"
+#include "fcch_rfid/rfid.h"
+#include "loadgen.h"
+#include "tasks.h"
+
+// Synthetic swipe load generator. Injects a scripted sequence of RFIDs through
+// rfid_inject(), so they follow exactly the same path as real cards, and
+// measures the time from rfid_task reporting each card present to the
+// ACL decision being made.
+
+static const char *TAG = "loadgen";
+
+static const uint32_t loadgen_default_rfid = 12345;
+static const uint16_t loadgen_default_count = 20;
+static const uint16_t loadgen_default_dwell_ms = 500;
+static const uint16_t loadgen_default_gap_ms = 500;
+// rfid_task only polls injections every 100ms; a shorter gap could merge
+// two consecutive swipes of the same RFID into one presentation.
+static const uint16_t loadgen_min_gap_ms = 200;
+static const int loadgen_max_rfids = 16;
+
+static const char *loadgen_rfids;
+static cm_conf_item loadgen_item_rfids = {
+    .slug_name = "i", // Ids
+    .text_name = "RFIDs (comma separated, empty for 12345)",
+    .type = CM_CONF_ITEM_TYPE_STR,
+    .p_val = {.str = &loadgen_rfids },
+    .default_func = &cm_conf_default_str_empty,
+};
+
+static uint16_t loadgen_count;
+static cm_conf_item loadgen_item_count = {
+    .slug_name = "c", // Count
+    .text_name = "Swipe Count (0 for 20)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &loadgen_count },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static uint16_t loadgen_dwell_ms;
+static cm_conf_item loadgen_item_dwell_ms = {
+    .slug_name = "d", // Dwell
+    .text_name = "Dwell Time (Milliseconds, 0 for 500)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &loadgen_dwell_ms },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static uint16_t loadgen_gap_ms;
+static cm_conf_item loadgen_item_gap_ms = {
+    .slug_name = "g", // Gap
+    .text_name = "Gap Between Swipes (Milliseconds, 0 for 500, min 200)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &loadgen_gap_ms },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static cm_conf_item *loadgen_items[] = {
+    &loadgen_item_rfids,
+    &loadgen_item_count,
+    &loadgen_item_dwell_ms,
+    &loadgen_item_gap_ms,
+};
+
+static cm_conf_page loadgen_page = {
+    .slug_name = "lg", // Load Generator
+    .text_name = "Load Generator",
+    .items = loadgen_items,
+    .items_count = ARRAY_SIZE(loadgen_items),
+};
+
+struct loadgen_stats {
+    uint32_t swipes;
+    uint32_t decisions;
+    int64_t latency_us_sum;
+    int64_t latency_us_min;
+    int64_t latency_us_max;
+    int64_t elapsed_us;
+};
+
+static portMUX_TYPE loadgen_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool loadgen_running;
+static uint32_t loadgen_cur_rfid;
+static int64_t loadgen_present_time;
+static loadgen_stats loadgen_cur_stats;
+
+static int loadgen_parse_rfids(uint32_t *rfids) {
+    int n = 0;
+    const char *p = loadgen_rfids;
+    while (*p && n < loadgen_max_rfids) {
+        char *end;
+        unsigned long rfid = strtoul(p, &end, 10);
+        if (end == p) {
+            p++;
+            continue;
+        }
+        if (rfid)
+            rfids[n++] = rfid;
+        p = end;
+    }
+    if (!n)
+        rfids[n++] = loadgen_default_rfid;
+    return n;
+}
+
+static void loadgen_publish_stats(const loadgen_stats &stats) {
+    dispatch_stats dispatch;
+    dispatch_get_stats(&dispatch);
+    uint32_t elapsed_ms = stats.elapsed_us / 1000;
+    uint32_t rate_x100 = elapsed_ms ?
+        (uint32_t)((stats.decisions * 100000ULL) / elapsed_ms) : 0;
+    uint32_t latency_avg_us = stats.decisions ?
+        (uint32_t)(stats.latency_us_sum / stats.decisions) : 0;
+
+    AutoFree<char> data;
+    asprintf(
+        &data.val,
+        "{\"loadgen\":{"
+        "\"swipes\":%lu,"
+        "\"decisions\":%lu,"
+        "\"decisions_per_s\":%lu.%02lu,"
+        "\"latency_us_min\":%lu,"
+        "\"latency_us_avg\":%lu,"
+        "\"latency_us_max\":%lu,"
+        "\"dispatch_queue_hwm\":%lu,"
+        "\"dispatch_latency_us_max\":%lu}}",
+        stats.swipes,
+        stats.decisions,
+        rate_x100 / 100, rate_x100 % 100,
+        (uint32_t)(stats.decisions ? stats.latency_us_min : 0),
+        latency_avg_us,
+        (uint32_t)stats.latency_us_max,
+        dispatch.queue_hwm,
+        (uint32_t)dispatch.latency_us_max);
+    assert(data.val != NULL);
+
+    ESP_LOGI(TAG, "%s", data.val);
+    cm_mqtt_publish_stat(data.val);
+}
+
+static void loadgen_task(void *pvParameters) {
+    uint32_t rfids[loadgen_max_rfids];
+    int rfids_count = loadgen_parse_rfids(rfids);
+    uint16_t count = loadgen_count ? loadgen_count : loadgen_default_count;
+    uint16_t dwell_ms = loadgen_dwell_ms ?
+        loadgen_dwell_ms : loadgen_default_dwell_ms;
+    uint16_t gap_ms = loadgen_gap_ms ? loadgen_gap_ms : loadgen_default_gap_ms;
+    if (gap_ms < loadgen_min_gap_ms)
+        gap_ms = loadgen_min_gap_ms;
+
+    ESP_LOGI(TAG, "start: %d RFIDs, %u swipes, dwell %ums, gap %ums",
+        rfids_count, count, dwell_ms, gap_ms);
+    int64_t start = esp_timer_get_time();
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t rfid = rfids[i % rfids_count];
+        portENTER_CRITICAL(&loadgen_lock);
+        loadgen_cur_rfid = rfid;
+        loadgen_present_time = 0;
+        loadgen_cur_stats.swipes++;
+        portEXIT_CRITICAL(&loadgen_lock);
+        rfid_inject(rfid, dwell_ms);
+        vTaskDelay((dwell_ms + gap_ms) / portTICK_PERIOD_MS);
+    }
+
+    portENTER_CRITICAL(&loadgen_lock);
+    loadgen_cur_stats.elapsed_us = esp_timer_get_time() - start;
+    loadgen_stats stats = loadgen_cur_stats;
+    loadgen_running = false;
+    portEXIT_CRITICAL(&loadgen_lock);
+
+    loadgen_publish_stats(stats);
+    tasks_exit(TASKS_ID_LOADGEN);
+}
+
+static void loadgen_http_action_run() {
+    portENTER_CRITICAL(&loadgen_lock);
+    bool was_running = loadgen_running;
+    if (!was_running) {
+        loadgen_running = true;
+        loadgen_cur_rfid = 0;
+        loadgen_cur_stats = {};
+    }
+    portEXIT_CRITICAL(&loadgen_lock);
+    if (was_running)
+        return;
+
+    if (tasks_create(TASKS_ID_LOADGEN, loadgen_task) == NULL) {
+        ESP_LOGE(TAG, "Can't create task");
+        portENTER_CRITICAL(&loadgen_lock);
+        loadgen_running = false;
+        portEXIT_CRITICAL(&loadgen_lock);
+    }
+}
+
+static const char *loadgen_http_action_run_description() {
+    static char desc[128];
+
+    portENTER_CRITICAL(&loadgen_lock);
+    bool running = loadgen_running;
+    loadgen_stats stats = loadgen_cur_stats;
+    portEXIT_CRITICAL(&loadgen_lock);
+
+    if (running) {
+        snprintf(desc, sizeof(desc),
+            "Run Synthetic Swipe Load (Running, %lu swipes)", stats.swipes);
+    } else if (stats.swipes) {
+        uint32_t latency_avg_ms = stats.decisions ?
+            (uint32_t)(stats.latency_us_sum / stats.decisions / 1000) : 0;
+        snprintf(desc, sizeof(desc),
+            "Run Synthetic Swipe Load (Last: %lu/%lu decided, "
+            "avg %lums, max %lums)",
+            stats.decisions, stats.swipes, latency_avg_ms,
+            (uint32_t)(stats.latency_us_max / 1000));
+    } else {
+        return "Run Synthetic Swipe Load";
+    }
+    return desc;
+}
+
+void loadgen_register_conf() {
+    cm_conf_register_page(&loadgen_page);
+}
+
+void loadgen_init() {
+    cm_http_register_home_action(
+        "loadgen-run",
+        loadgen_http_action_run_description,
+        loadgen_http_action_run
+    );
+}
+
+void loadgen_on_rfid_present(uint32_t rfid) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&loadgen_lock);
+    if (loadgen_running && rfid == loadgen_cur_rfid)
+        loadgen_present_time = now;
+    portEXIT_CRITICAL(&loadgen_lock);
+}
+
+void loadgen_on_decision(uint32_t rfid) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&loadgen_lock);
+    if (loadgen_running && rfid == loadgen_cur_rfid && loadgen_present_time) {
+        int64_t latency = now - loadgen_present_time;
+        loadgen_present_time = 0;
+        loadgen_stats &stats = loadgen_cur_stats;
+        if (!stats.decisions || latency < stats.latency_us_min)
+            stats.latency_us_min = latency;
+        if (latency > stats.latency_us_max)
+            stats.latency_us_max = latency;
+        stats.latency_us_sum += latency;
+        stats.decisions++;
+    }
+    portEXIT_CRITICAL(&loadgen_lock);
+}
@@ -0,0 +1,11 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+extern void loadgen_register_conf();
+extern void loadgen_init();
+extern void loadgen_on_rfid_present(uint32_t rfid);
+extern void loadgen_on_decision(uint32_t rfid);
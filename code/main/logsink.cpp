@@ -0,0 +1,340 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <netdb.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/socket.h>
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/ringbuf.h>
+
+#include "conf_watch.h"
+#include "fcch_connmgr/cm_conf.h"
+#include "fcch_connmgr/cm_net.h"
+#include "fcch_connmgr/cm_util.h"
+#include "logsink.h"
+#include "tasks.h"
+
+static const char *TAG = "logsink";
+
+// Roughly 40 typical lines.
+#define LOGSINK_RING_SIZE 4096
+// Longer lines are truncated. This is on the logging task's stack.
+#define LOGSINK_LINE_MAX 160
+// Distinct tags that are rate limited individually: the firmware's own 17,
+// plus room for the ESP-IDF components that log. Any further tags share one
+// extra entry, and their lines are counted.
+#define LOGSINK_TAGS 32
+#define LOGSINK_TAG_LEN 16
+
+static const uint16_t logsink_default_rate = 10;
+static const uint16_t logsink_default_port = 514;
+// Syslog facility local0.
+static const int logsink_facility = 16;
+static const TickType_t logsink_window_ticks = 1000 / portTICK_PERIOD_MS;
+static const TickType_t logsink_resolve_retry_ticks =
+    10000 / portTICK_PERIOD_MS;
+
+static uint16_t logsink_rate;
+static cm_conf_item logsink_item_rate = {
+    .slug_name = "r", // Rate
+    .text_name = "Max Lines Per Second Per Tag (0 for 10)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &logsink_rate },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static const char *logsink_host;
+static cm_conf_item logsink_item_host = {
+    .slug_name = "h", // Host name
+    .text_name = "Syslog Server Host Name (empty to disable)",
+    .type = CM_CONF_ITEM_TYPE_STR,
+    .p_val = {.str = &logsink_host },
+    .default_func = &cm_conf_default_str_empty,
+};
+
+static uint16_t logsink_port;
+static cm_conf_item logsink_item_port = {
+    .slug_name = "p", // Port
+    .text_name = "Syslog Server UDP Port (0 for 514)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &logsink_port },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static cm_conf_item *logsink_items[] = {
+    &logsink_item_rate,
+    &logsink_item_host,
+    &logsink_item_port,
+};
+
+static cm_conf_page logsink_page = {
+    .slug_name = "lo", // Logging
+    .text_name = "Logging",
+    .items = logsink_items,
+    .items_count = ARRAY_SIZE(logsink_items),
+};
+
+struct logsink_tag_state {
+    char tag[LOGSINK_TAG_LEN];
+    // Lines logged in the current one second window, which started at
+    // window_start.
+    TickType_t window_start;
+    uint16_t count;
+    // Lines dropped since the tag was last allowed to log.
+    uint32_t suppressed;
+};
+
+static uint8_t logsink_ring_storage[LOGSINK_RING_SIZE];
+static StaticRingbuffer_t logsink_ring_buf;
+static RingbufHandle_t logsink_ring;
+static vprintf_like_t logsink_console_vprintf;
+static portMUX_TYPE logsink_lock = portMUX_INITIALIZER_UNLOCKED;
+static logsink_tag_state logsink_tags[LOGSINK_TAGS];
+static logsink_tag_state logsink_tag_overflow;
+static logsink_stats logsink_cur_stats;
+
+// Only used by logsink_task.
+static volatile bool logsink_resolve_pending;
+static TickType_t logsink_resolve_time;
+static int logsink_sock = -1;
+static bool logsink_addr_valid;
+static sockaddr_in logsink_addr;
+
+// Lines look like "I (1234) tag: message", possibly wrapped in color codes.
+static const char *logsink_skip_color(const char *line) {
+    if (line[0] == '\033') {
+        const char *m = strchr(line, 'm');
+        if (m)
+            return m + 1;
+    }
+    return line;
+}
+
+static void logsink_parse_tag(const char *line, char *tag) {
+    tag[0] = '\0';
+    const char *start = strstr(logsink_skip_color(line), ") ");
+    if (!start)
+        return;
+    start += 2;
+    const char *end = strchr(start, ':');
+    if (!end)
+        return;
+    size_t len = MIN((size_t)(end - start), LOGSINK_TAG_LEN - 1);
+    memcpy(tag, start, len);
+    tag[len] = '\0';
+}
+
+// Must be called with logsink_lock held.
+static logsink_tag_state *logsink_find_tag(const char *tag) {
+    for (int i = 0; i < LOGSINK_TAGS; i++) {
+        logsink_tag_state *state = &logsink_tags[i];
+        if (!strcmp(state->tag, tag))
+            return state;
+        if (!state->tag[0] && !state->count && !state->suppressed) {
+            strcpy(state->tag, tag);
+            return state;
+        }
+    }
+    logsink_cur_stats.tag_overflows++;
+    return &logsink_tag_overflow;
+}
+
+// Returns whether the line may be logged, and in *suppressed, how many lines
+// from this tag were dropped before it. *shared is set if the tag didn't fit
+// in the table, so the count covers all such tags.
+static bool logsink_rate_check(const char *tag, uint32_t *suppressed,
+    bool *shared) {
+    uint16_t rate = logsink_rate ? logsink_rate : logsink_default_rate;
+    TickType_t now = xTaskGetTickCount();
+    bool allowed;
+    portENTER_CRITICAL(&logsink_lock);
+    logsink_tag_state *state = logsink_find_tag(tag);
+    *shared = state == &logsink_tag_overflow;
+    if (now - state->window_start >= logsink_window_ticks) {
+        state->window_start = now;
+        state->count = 0;
+    }
+    allowed = state->count < rate;
+    if (allowed) {
+        state->count++;
+        *suppressed = state->suppressed;
+        state->suppressed = 0;
+    } else {
+        state->suppressed++;
+        logsink_cur_stats.rate_limited++;
+    }
+    portEXIT_CRITICAL(&logsink_lock);
+    return allowed;
+}
+
+static void logsink_push(const char *line, size_t len) {
+    bool sent = xRingbufferSend(logsink_ring, line, len, 0) == pdTRUE;
+    portENTER_CRITICAL(&logsink_lock);
+    if (sent)
+        logsink_cur_stats.lines++;
+    else
+        logsink_cur_stats.overflows++;
+    portEXIT_CRITICAL(&logsink_lock);
+}
+
+// Installed with esp_log_set_vprintf(); runs in whichever task is logging.
+static int logsink_vprintf(const char *fmt, va_list ap) {
+    char line[LOGSINK_LINE_MAX];
+    int ret = vsnprintf(line, sizeof(line), fmt, ap);
+    if (ret <= 0)
+        return ret;
+    size_t len = MIN((size_t)ret, sizeof(line) - 1);
+    if (len < (size_t)ret)
+        line[len - 1] = '\n';
+
+    char tag[LOGSINK_TAG_LEN];
+    logsink_parse_tag(line, tag);
+    uint32_t suppressed;
+    bool shared;
+    if (!logsink_rate_check(tag, &suppressed, &shared))
+        return ret;
+    if (suppressed) {
+        char note[64];
+        int note_len = snprintf(note, sizeof(note),
+            "W (%lu) %s: %s: %lu lines suppressed\n",
+            esp_log_timestamp(), TAG, shared ? "(other tags)" : tag,
+            suppressed);
+        logsink_push(note, MIN((size_t)note_len, sizeof(note) - 1));
+    }
+    logsink_push(line, len);
+    return ret;
+}
+
+__attribute__((format(printf, 1, 2)))
+static void logsink_console(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    logsink_console_vprintf(fmt, ap);
+    va_end(ap);
+}
+
+static void logsink_resolve() {
+    logsink_addr_valid = false;
+    const char *host = logsink_host;
+    if (!host[0]) {
+        logsink_resolve_pending = false;
+        return;
+    }
+    // Retried later, when the network is up.
+    TickType_t now = xTaskGetTickCount();
+    if (!cm_net_get_sta_info().has_ip ||
+        (logsink_resolve_time &&
+            now - logsink_resolve_time < logsink_resolve_retry_ticks))
+        return;
+    logsink_resolve_time = now;
+
+    char port[8];
+    snprintf(port, sizeof(port), "%u",
+        logsink_port ? logsink_port : logsink_default_port);
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo *res;
+    int err = getaddrinfo(host, port, &hints, &res);
+    if (err || res == NULL) {
+        ESP_LOGW(TAG, "Can't resolve %s: %d", host, err);
+        return;
+    }
+    memcpy(&logsink_addr, res->ai_addr, sizeof(logsink_addr));
+    freeaddrinfo(res);
+
+    if (logsink_sock < 0) {
+        logsink_sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (logsink_sock < 0) {
+            ESP_LOGE(TAG, "Can't create socket");
+            return;
+        }
+    }
+    logsink_addr_valid = true;
+    logsink_resolve_pending = false;
+}
+
+static int logsink_severity(const char *line) {
+    switch (*logsink_skip_color(line)) {
+    case 'E':
+        return 3;
+    case 'W':
+        return 4;
+    case 'I':
+        return 6;
+    default:
+        return 7;
+    }
+}
+
+// One RFC 3164 message per datagram, as RFC 5426 requires, with no
+// timestamp; the collector supplies one.
+static void logsink_forward(const char *line, size_t len) {
+    if (!logsink_addr_valid)
+        return;
+    if (len && line[len - 1] == '\n')
+        len--;
+    char msg[LOGSINK_LINE_MAX + 48];
+    int msg_len = snprintf(msg, sizeof(msg), "<%d>%s fcch: %.*s",
+        (logsink_facility * 8) + logsink_severity(line), cm_net_hostname,
+        (int)len, line);
+    msg_len = MIN((size_t)msg_len, sizeof(msg) - 1);
+    bool sent = sendto(logsink_sock, msg, msg_len, 0,
+        (const sockaddr *)&logsink_addr, sizeof(logsink_addr)) >= 0;
+    portENTER_CRITICAL(&logsink_lock);
+    if (sent)
+        logsink_cur_stats.forwarded++;
+    else
+        logsink_cur_stats.forward_errors++;
+    portEXIT_CRITICAL(&logsink_lock);
+}
+
+// Blocks until there's output, then drains everything buffered in one pass.
+static void logsink_task(void *pvParameters) {
+    for (;;) {
+        size_t len;
+        char *line = (char *)xRingbufferReceive(logsink_ring, &len,
+            portMAX_DELAY);
+        if (logsink_resolve_pending)
+            logsink_resolve();
+        while (line != NULL) {
+            logsink_console("%.*s", (int)len, line);
+            logsink_forward(line, len);
+            vRingbufferReturnItem(logsink_ring, line);
+            line = (char *)xRingbufferReceive(logsink_ring, &len, 0);
+        }
+    }
+}
+
+// Runs in the dispatch task.
+static void logsink_apply() {
+    logsink_resolve_time = 0;
+    logsink_resolve_pending = true;
+}
+
+void logsink_register_conf() {
+    cm_conf_register_page(&logsink_page);
+}
+
+void logsink_init() {
+    logsink_ring = xRingbufferCreateStatic(sizeof(logsink_ring_storage),
+        RINGBUF_TYPE_NOSPLIT, logsink_ring_storage, &logsink_ring_buf);
+    assert(logsink_ring != NULL);
+    logsink_resolve_pending = true;
+    conf_watch_register_page(&logsink_page, logsink_apply);
+
+    TaskHandle_t task = tasks_create(TASKS_ID_LOG, logsink_task);
+    assert(task != NULL);
+    logsink_console_vprintf = esp_log_set_vprintf(logsink_vprintf);
+}
+
+void logsink_get_stats(logsink_stats *stats) {
+    portENTER_CRITICAL(&logsink_lock);
+    *stats = logsink_cur_stats;
+    portEXIT_CRITICAL(&logsink_lock);
+}
@@ -0,0 +1,31 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+// ESP_LOG output is redirected into a RAM buffer and written out by a low
+// priority task, so logging never blocks on the console UART or network.
+// Each tag may log a limited number of lines per second; the excess is
+// dropped and counted. Optionally, lines are also forwarded to a syslog
+// collector over UDP.
+
+struct logsink_stats {
+    // Lines accepted into the buffer
+    uint32_t lines;
+    // Lines dropped by the per-tag rate limit
+    uint32_t rate_limited;
+    // Lines dropped because the buffer was full
+    uint32_t overflows;
+    // Lines from tags beyond the rate limit table, which share one limit
+    uint32_t tag_overflows;
+    // Lines sent to the syslog collector, or that failed to send
+    uint32_t forwarded;
+    uint32_t forward_errors;
+};
+
+extern void logsink_register_conf();
+// Call as early as possible, so that the most output goes through the sink.
+extern void logsink_init();
+extern void logsink_get_stats(logsink_stats *stats);
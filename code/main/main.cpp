@@ -9,116 +9,172 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs.h>
 #include <nvs_flash.h>
 
+#include "boot.h"
+#include "conf_watch.h"
+#include "dispatch.h"
 #include "fcch_acl_client/acl_client.h"
 #include "fcch_connmgr/cm.h"
 #include "fcch_rfid/rfid.h"
+#include "fcch_trace/trace.h"
+#include "latency.h"
 #include "lcd.h"
+#include "loadgen.h"
+#include "logsink.h"
+#include "metrics.h"
 #include "momentary.h"
 #include "mqtt.h"
+#include "net_watch.h"
 #include "relay.h"
-
-enum main_event {
-    MAIN_EVENT_RFID_PRESENT,
-    MAIN_EVENT_RFID_ABSENT,
-};
+#include "stall.h"
+#include "status.h"
+#include "tasks.h"
+#include "timesync.h"
 
 static const char *TAG = "main";
 
-static esp_event_loop_handle_t main_event_loop;
-ESP_EVENT_DEFINE_BASE(MAIN_EVENT);
-
-static void main_rfid_present(uint32_t rfid) {
-    ESP_ERROR_CHECK(esp_event_post_to(main_event_loop,
-        MAIN_EVENT, MAIN_EVENT_RFID_PRESENT,
-        &rfid, sizeof(rfid), 10 / portTICK_PERIOD_MS));
+// Called in rfid_task.
+static void main_on_rfid_present(uint32_t rfid) {
+    stall_enter(STALL_ID_RFID, DISPATCH_EVENT_RFID_PRESENT);
+    trace(TRACE_ID_RFID_PRESENT, rfid);
+    // Fast path: act on a cached grant right here, rather than waiting for
+    // the dispatch task and ACL server. The normal path still runs, updating
+    // the LCD and MQTT, and revoking the grant if the server now disagrees.
+    if (relay_fast_grant_enabled()) {
+        bool allowed;
+        if (acl_client_cache_lookup(rfid, &allowed) && allowed) {
+            relay_on_fast_grant(rfid_get_rx_time());
+            boot_mark(BOOT_PHASE_FIRST_GRANT);
+        }
+    }
+    loadgen_on_rfid_present(rfid);
+    dispatch_event ev{
+        .id = DISPATCH_EVENT_RFID_PRESENT,
+        .rfid = rfid,
+        .post_time = 0,
+        .rx_time = rfid_get_rx_time(),
+    };
+    dispatch_post_presence(ev);
+    stall_exit(STALL_ID_RFID);
 }
 
-static void main_rfid_absent() {
-    ESP_ERROR_CHECK(esp_event_post_to(main_event_loop,
-        MAIN_EVENT, MAIN_EVENT_RFID_ABSENT,
-        NULL, 0, 10 / portTICK_PERIOD_MS));
+// Called in rfid_task.
+static void main_on_rfid_absent() {
+    trace(TRACE_ID_RFID_ABSENT);
+    dispatch_event ev{
+        .id = DISPATCH_EVENT_RFID_ABSENT,
+        .dummy = 0,
+    };
+    dispatch_post_presence(ev);
 }
 
-static void main_event_handler(
-    void *arg,
-    esp_event_base_t event_base,
-    int32_t event_id,
-    void *event_data
-) {
-    if (event_base != MAIN_EVENT) {
-        ESP_LOGE(TAG, "main_event_handler: event_base != MAIN_EVENT");
-        return;
-    }
+static void main_emit(dispatch_event_id id, uint32_t rfid) {
+    dispatch_event ev{
+        .id = id,
+        .rfid = rfid,
+    };
+    dispatch_emit(ev);
+}
 
-    switch (event_id) {
-        case MAIN_EVENT_RFID_PRESENT: {
-            uint32_t rfid = *(uint32_t *)event_data;
-            ESP_LOGI(TAG, "MAIN_EVENT_RFID_PRESENT: %lu", rfid);
-            // FIXME: Might want our own event loop task since
-            // acl_client_check_id might take a while.
-            // rfid_init should take an event loop handle to post to.
-            bool allowed;
-            esp_err_t err = acl_client_check_id(rfid, &allowed);
-            if (err != ESP_OK) {
-                ESP_LOGW(TAG, "ACL check error: %d", err);
-                lcd_on_rfid_err(rfid);
-                mqtt_on_rfid_err(rfid);
-                break;
-            }
-            ESP_LOGI(TAG, "ACL check: %d", (int)allowed);
-            if (allowed) {
-                relay_on_rfid_ok();
-                lcd_on_rfid_ok(rfid);
-                mqtt_on_rfid_ok(rfid);
-            } else {
-                lcd_on_rfid_bad(rfid);
-                mqtt_on_rfid_bad(rfid);
-            }
-            break;
-        }
-        case MAIN_EVENT_RFID_ABSENT: {
-            ESP_LOGI(TAG, "MAIN_EVENT_RFID_ABSENT");
-            bool allowed;
-            // Ignore errors in ACL check; this is only performed to create a
-            // log entry for offline stats reporting.
-            acl_client_check_id(0, &allowed);
-            relay_on_rfid_none();
-            lcd_on_rfid_none();
-            mqtt_on_rfid_none();
-            break;
+// Called by momentary, in the dispatch task.
+// Nothing is logged until the decision has been acted on, since console
+// output is slow; the trace records each step instead.
+static void main_decide_present(uint32_t rfid) {
+    // acl_client_check_id might take a while, which blocks the dispatch task.
+    // The LCD and MQTT are unaffected since they update in their own tasks.
+    bool allowed;
+    latency_stamp_acl_start();
+    esp_err_t err = acl_client_check_id(rfid, &allowed);
+    latency_stamp_decision();
+    loadgen_on_decision(rfid);
+    boot_mark(BOOT_PHASE_FIRST_DECISION);
+    bool from_cache = false;
+    if (err != ESP_OK) {
+        if (!acl_client_cache_lookup(rfid, &allowed)) {
+            trace(TRACE_ID_ACL_DECISION, rfid, DISPATCH_EVENT_RFID_ERR);
+            status_record_decision(rfid, DISPATCH_EVENT_RFID_ERR, false);
+            main_emit(DISPATCH_EVENT_RFID_ERR, rfid);
+            ESP_LOGW(TAG, "RFID %lu: ACL check error: %d", rfid, err);
+            return;
         }
-        default:
-            ESP_LOGI(TAG, "MAIN_EVENT_? %" PRId32, event_id);
-            break;
+        from_cache = true;
     }
+    dispatch_event_id id = allowed ?
+        DISPATCH_EVENT_RFID_OK : DISPATCH_EVENT_RFID_BAD;
+    trace(TRACE_ID_ACL_DECISION, rfid, id);
+    status_record_decision(rfid, id, from_cache);
+    main_emit(id, rfid);
+    if (allowed)
+        boot_mark(BOOT_PHASE_FIRST_GRANT);
+    if (from_cache)
+        ESP_LOGW(TAG, "RFID %lu: ACL check error: %d; cached decision: %d",
+            rfid, err, (int)allowed);
+    else
+        ESP_LOGI(TAG, "RFID %lu: ACL check: %d", rfid, (int)allowed);
+}
+
+// Called by momentary, in the dispatch task.
+static void main_decide_absent() {
+    bool allowed;
+    // Ignore errors in ACL check; this is only performed to create a
+    // log entry for offline stats reporting.
+    acl_client_check_id(0, &allowed);
+    main_emit(DISPATCH_EVENT_RFID_NONE, 0);
+    ESP_LOGI(TAG, "RFID absent");
 }
 
+// Boot is ordered so that cards can be decided as early as possible:
+// cm_init() must come first since it loads the configuration, but nothing
+// after it waits for the network. The ACL client loads its persisted
+// decisions before the RFID reader starts, and a decision made before WiFi
+// is up fails fast to those cached decisions. The LCD panel and MQTT
+// connection come up in their own tasks, in parallel with everything else.
 extern "C" void app_main() {
-    // These values match the default event loop, other than task_name.
-    const esp_event_loop_args_t event_loop_args = {
-        .queue_size = CONFIG_ESP_SYSTEM_EVENT_QUEUE_SIZE,
-        .task_name = "main",
-        .task_priority = ESP_TASKD_EVENT_PRIO,
-        .task_stack_size = ESP_TASKD_EVENT_STACK,
-        .task_core_id = 0
-    };
-    ESP_ERROR_CHECK(esp_event_loop_create(&event_loop_args, &main_event_loop));
     cm_register_conf();
     acl_client_register_conf();
     momentary_register_conf();
     lcd_register_conf();
+    relay_register_conf();
+    mqtt_register_conf();
+    loadgen_register_conf();
+    stall_register_conf();
+    logsink_register_conf();
+    timesync_register_conf();
+    boot_mark(BOOT_PHASE_CONF);
     cm_init();
+    boot_mark(BOOT_PHASE_CM);
+    logsink_init();
+    timesync_init();
+    boot_init();
+    tasks_init();
+    status_init();
+    metrics_init();
+    trace_init();
+    stall_init();
+    dispatch_init();
+    // Handlers run in registration order; the relay is first so that it's
+    // never delayed by the other handlers. All handlers must be registered
+    // before rfid_init().
+    relay_init();
+    // Before momentary_init(), so a session starts before the decision.
+    latency_init();
     mqtt_init();
     lcd_init();
-    relay_init();
-    acl_client_init();
-    momentary_init(&main_rfid_present,  &main_rfid_absent);
-    rfid_init(&momentary_on_rfid_present, &momentary_on_rfid_absent);
-    ESP_ERROR_CHECK(esp_event_handler_register_with(main_event_loop,
-        MAIN_EVENT, ESP_EVENT_ANY_ID, main_event_handler, NULL));
+    acl_client_init(&timesync_get_time_ms);
+    conf_watch_register_page(acl_client_get_conf_page(),
+        acl_client_reconfigure);
+    momentary_init(&main_decide_present, &main_decide_absent);
+    conf_watch_init();
+    net_watch_init();
+    tasks_set_handle(TASKS_ID_RFID,
+        rfid_init(&main_on_rfid_present, &main_on_rfid_absent,
+            tasks_get_config(TASKS_ID_RFID)->priority,
+            tasks_get_core(TASKS_ID_RFID)));
+    boot_mark(BOOT_PHASE_DECISION_PATH);
+    loadgen_init();
+    tasks_log_ram_budget();
+    boot_mark(BOOT_PHASE_APP_MAIN);
 }
@@ -0,0 +1,290 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <stdio.h>
+
+#include <esp_heap_caps.h>
+#include <esp_http_server.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+
+#include "dispatch.h"
+#include "fcch_acl_client/acl_client.h"
+#include "fcch_connmgr/cm.h"
+#include "fcch_rfid/rfid.h"
+#include "latency.h"
+#include "lcd.h"
+#include "logsink.h"
+#include "metrics.h"
+#include "metrics_writer.h"
+#include "mqtt.h"
+#include "mqtt_queue.h"
+#include "relay.h"
+#include "status.h"
+
+// GET /metrics, in Prometheus text format. Output is streamed in chunks from
+// a small static buffer; the HTTP server runs one handler at a time, so the
+// buffer needs no lock.
+
+#define METRICS_CHUNK_SIZE 512
+
+static char metrics_chunk[METRICS_CHUNK_SIZE];
+
+static bool metrics_http_flush(void *ctx, const char *buf, size_t len) {
+    httpd_req_t *req = (httpd_req_t *)ctx;
+    return httpd_resp_send_chunk(req, buf, len) == ESP_OK;
+}
+
+static void metrics_write_system(metrics_writer *w) {
+    metrics_header(w, "fcch_uptime_seconds", "gauge",
+        "Time since boot.");
+    metrics_sample_us(w, "fcch_uptime_seconds", nullptr,
+        esp_timer_get_time());
+
+    metrics_header(w, "fcch_heap_free_bytes", "gauge",
+        "Free internal heap.");
+    metrics_sample(w, "fcch_heap_free_bytes", nullptr,
+        heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    metrics_header(w, "fcch_heap_min_free_bytes", "gauge",
+        "Minimum free internal heap since boot.");
+    metrics_sample(w, "fcch_heap_min_free_bytes", nullptr,
+        heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    metrics_header(w, "fcch_heap_largest_free_block_bytes", "gauge",
+        "Largest free internal heap block.");
+    metrics_sample(w, "fcch_heap_largest_free_block_bytes", nullptr,
+        heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+
+    // Omitted while not connected; there's no meaningful value.
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+        metrics_header(w, "fcch_wifi_rssi_dbm", "gauge",
+            "WiFi station signal strength.");
+        metrics_printf(w, "fcch_wifi_rssi_dbm %d\n", ap.rssi);
+    }
+}
+
+static void metrics_write_rfid(metrics_writer *w) {
+    rfid_stats stats;
+    rfid_get_stats(&stats);
+    metrics_header(w, "fcch_rfid_frames_total", "counter",
+        "RFID reader frames with a valid checksum.");
+    metrics_sample(w, "fcch_rfid_frames_total", nullptr, stats.frames);
+    metrics_header(w, "fcch_rfid_errors_total", "counter",
+        "RFID reader frame errors.");
+    metrics_sample(w, "fcch_rfid_errors_total", "type=\"crc\"",
+        stats.crc_errors);
+    metrics_sample(w, "fcch_rfid_errors_total", "type=\"framing\"",
+        stats.framing_errors);
+    metrics_sample(w, "fcch_rfid_errors_total", "type=\"timeout\"",
+        stats.timeouts);
+    metrics_header(w, "fcch_rfid_presentations_total", "counter",
+        "Distinct card presentations.");
+    metrics_sample(w, "fcch_rfid_presentations_total", nullptr,
+        stats.presentations);
+}
+
+static void metrics_write_acl(metrics_writer *w) {
+    acl_client_stats stats;
+    acl_client_get_stats(&stats);
+    metrics_header(w, "fcch_acl_requests_total", "counter",
+        "ACL server requests.");
+    metrics_sample(w, "fcch_acl_requests_total", nullptr, stats.requests);
+    metrics_header(w, "fcch_acl_request_errors_total", "counter",
+        "ACL server requests that failed.");
+    metrics_sample(w, "fcch_acl_request_errors_total", nullptr, stats.errors);
+    metrics_header(w, "fcch_acl_cache_lookups_total", "counter",
+        "Decision cache lookups.");
+    metrics_sample(w, "fcch_acl_cache_lookups_total", nullptr,
+        stats.cache_lookups);
+    metrics_header(w, "fcch_acl_cache_hits_total", "counter",
+        "Decision cache lookups that found a decision.");
+    metrics_sample(w, "fcch_acl_cache_hits_total", nullptr, stats.cache_hits);
+
+    status_decision_counts counts;
+    status_get_decision_counts(&counts);
+    metrics_header(w, "fcch_decisions_total", "counter",
+        "Access decisions, by result.");
+    metrics_sample(w, "fcch_decisions_total", "result=\"grant\"",
+        counts.grants);
+    metrics_sample(w, "fcch_decisions_total", "result=\"deny\"",
+        counts.denials);
+    metrics_sample(w, "fcch_decisions_total", "result=\"error\"",
+        counts.errors);
+    metrics_header(w, "fcch_decisions_from_cache_total", "counter",
+        "Access decisions made from the cache, the server being unreachable.");
+    metrics_sample(w, "fcch_decisions_from_cache_total", nullptr,
+        counts.from_cache);
+
+    metrics_header(w, "fcch_relay_on_seconds_total", "counter",
+        "Time the relay has been on.");
+    metrics_sample_us(w, "fcch_relay_on_seconds_total", nullptr,
+        relay_get_on_time_us());
+}
+
+static void metrics_write_dispatch(metrics_writer *w) {
+    dispatch_stats stats;
+    dispatch_get_stats(&stats);
+    metrics_header(w, "fcch_dispatch_events_total", "counter",
+        "Events handled by the dispatch task.");
+    metrics_sample(w, "fcch_dispatch_events_total", nullptr, stats.events);
+    metrics_header(w, "fcch_dispatch_dropped_total", "counter",
+        "Events dropped because a queue was full.");
+    metrics_sample(w, "fcch_dispatch_dropped_total", "queue=\"general\"",
+        stats.queue_drops);
+    metrics_sample(w, "fcch_dispatch_dropped_total", "queue=\"presence\"",
+        stats.presence_overflows);
+}
+
+static void metrics_write_mqtt(metrics_writer *w) {
+    mqtt_stats stats;
+    mqtt_get_stats(&stats);
+    metrics_header(w, "fcch_mqtt_status_messages_total", "counter",
+        "MQTT status messages published, by type.");
+    metrics_sample(w, "fcch_mqtt_status_messages_total", "type=\"status\"",
+        stats.status_msgs);
+    metrics_sample(w, "fcch_mqtt_status_messages_total",
+        "type=\"heartbeat\"", stats.heartbeat_msgs);
+    metrics_header(w, "fcch_mqtt_stats_messages_total", "counter",
+        "MQTT stats messages, by whether they were published or unchanged.");
+    metrics_sample(w, "fcch_mqtt_stats_messages_total", "result=\"sent\"",
+        stats.stats_msgs);
+    metrics_sample(w, "fcch_mqtt_stats_messages_total",
+        "result=\"unchanged\"", stats.stats_unchanged);
+    metrics_header(w, "fcch_mqtt_bytes_total", "counter",
+        "MQTT message bytes published.");
+    metrics_sample(w, "fcch_mqtt_bytes_total", nullptr, stats.bytes);
+    metrics_header(w, "fcch_mqtt_bytes_saved_total", "counter",
+        "MQTT bytes not published: heartbeats and unchanged stats.");
+    metrics_sample(w, "fcch_mqtt_bytes_saved_total", nullptr,
+        stats.bytes_saved);
+
+    mqtt_queue_stats queue_stats;
+    mqtt_queue_get_stats(&queue_stats);
+    metrics_header(w, "fcch_mqtt_queue_depth", "gauge",
+        "Status changes waiting to be published, by location.");
+    metrics_sample(w, "fcch_mqtt_queue_depth", "location=\"ram\"",
+        queue_stats.depth - queue_stats.depth_flash);
+    metrics_sample(w, "fcch_mqtt_queue_depth", "location=\"flash\"",
+        queue_stats.depth_flash);
+    metrics_header(w, "fcch_mqtt_queue_dropped_total", "counter",
+        "Status changes dropped because the queue was full.");
+    metrics_sample(w, "fcch_mqtt_queue_dropped_total", nullptr,
+        queue_stats.drops);
+    metrics_header(w, "fcch_mqtt_queue_flash_writes_total", "counter",
+        "Blocks of status changes written to flash.");
+    metrics_sample(w, "fcch_mqtt_queue_flash_writes_total", nullptr,
+        queue_stats.spills);
+}
+
+static void metrics_write_lcd(metrics_writer *w) {
+    lcd_stats stats;
+    lcd_get_stats(&stats);
+    metrics_header(w, "fcch_lcd_frames_total", "counter",
+        "LCD redraws.");
+    metrics_sample(w, "fcch_lcd_frames_total", nullptr, stats.frames);
+    metrics_header(w, "fcch_lcd_frame_seconds_total", "counter",
+        "Time spent drawing LCD frames and sending them to the panel.");
+    metrics_sample_us(w, "fcch_lcd_frame_seconds_total", nullptr,
+        stats.frame_us_sum);
+    metrics_header(w, "fcch_lcd_frame_max_seconds", "gauge",
+        "Longest LCD redraw.");
+    metrics_sample_us(w, "fcch_lcd_frame_max_seconds", nullptr,
+        stats.frame_us_max);
+    metrics_header(w, "fcch_lcd_spi_bytes_total", "counter",
+        "Pixel data sent to the LCD panel.");
+    metrics_sample(w, "fcch_lcd_spi_bytes_total", nullptr, stats.spi_bytes);
+    metrics_header(w, "fcch_lcd_bands_total", "counter",
+        "LCD bands drawn, by whether they changed so were sent.");
+    metrics_sample(w, "fcch_lcd_bands_total", "result=\"sent\"",
+        stats.bands_sent);
+    metrics_sample(w, "fcch_lcd_bands_total", "result=\"unchanged\"",
+        stats.bands_skipped);
+
+    char labels[LCD_POWER_NUM][16];
+    for (int i = 0; i < LCD_POWER_NUM; i++) {
+        snprintf(labels[i], sizeof(labels[i]), "state=\"%s\"",
+            lcd_power_state_name((lcd_power_state)i));
+    }
+    metrics_header(w, "fcch_lcd_power_state", "gauge",
+        "1 for the display's current power state.");
+    for (int i = 0; i < LCD_POWER_NUM; i++) {
+        metrics_sample(w, "fcch_lcd_power_state", labels[i],
+            stats.power == i);
+    }
+    metrics_header(w, "fcch_lcd_power_seconds_total", "counter",
+        "Time the display has spent in each power state.");
+    for (int i = 0; i < LCD_POWER_NUM; i++) {
+        metrics_sample_us(w, "fcch_lcd_power_seconds_total", labels[i],
+            stats.power_us[i]);
+    }
+}
+
+static void metrics_write_log(metrics_writer *w) {
+    logsink_stats stats;
+    logsink_get_stats(&stats);
+    metrics_header(w, "fcch_log_lines_total", "counter",
+        "Log lines, by whether they were written or dropped.");
+    metrics_sample(w, "fcch_log_lines_total", "result=\"written\"",
+        stats.lines);
+    metrics_sample(w, "fcch_log_lines_total", "result=\"rate_limited\"",
+        stats.rate_limited);
+    metrics_sample(w, "fcch_log_lines_total", "result=\"buffer_full\"",
+        stats.overflows);
+    metrics_header(w, "fcch_log_tag_overflow_lines_total", "counter",
+        "Log lines from tags beyond the rate limit table, sharing one limit.");
+    metrics_sample(w, "fcch_log_tag_overflow_lines_total", nullptr,
+        stats.tag_overflows);
+    metrics_header(w, "fcch_log_syslog_total", "counter",
+        "Log lines sent to the syslog server, by result.");
+    metrics_sample(w, "fcch_log_syslog_total", "result=\"sent\"",
+        stats.forwarded);
+    metrics_sample(w, "fcch_log_syslog_total", "result=\"error\"",
+        stats.forward_errors);
+}
+
+static void metrics_write_latency(metrics_writer *w) {
+    metrics_header(w, "fcch_latency_seconds", "histogram",
+        "Swipe-to-relay latency, by stage.");
+    for (int i = 0; i < LATENCY_STAGE_NUM; i++) {
+        latency_stage stage = (latency_stage)i;
+        latency_histogram hist;
+        latency_get(stage, &hist);
+        char labels[32];
+        snprintf(labels, sizeof(labels), "stage=\"%s\"",
+            latency_stage_name(stage));
+        metrics_histogram_us(w, "fcch_latency_seconds", labels,
+            latency_bucket_bounds_us, LATENCY_BUCKETS - 1, hist.buckets,
+            hist.sum_us);
+    }
+}
+
+static esp_err_t metrics_http_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    metrics_writer w;
+    metrics_writer_init(&w, metrics_chunk, sizeof(metrics_chunk),
+        metrics_http_flush, req);
+    metrics_write_system(&w);
+    metrics_write_rfid(&w);
+    metrics_write_acl(&w);
+    metrics_write_dispatch(&w);
+    metrics_write_mqtt(&w);
+    metrics_write_lcd(&w);
+    metrics_write_log(&w);
+    metrics_write_latency(&w);
+    if (!metrics_writer_finish(&w))
+        return ESP_FAIL;
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static const httpd_uri_t metrics_http_uri = {
+    .uri = "/metrics",
+    .method = HTTP_GET,
+    .handler = metrics_http_handler,
+    .user_ctx = NULL,
+};
+
+void metrics_init() {
+    cm_http_register_uri_handler(&metrics_http_uri);
+}
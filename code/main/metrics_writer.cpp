@@ -0,0 +1,130 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "metrics_writer.h"
+
+void metrics_writer_init(
+    metrics_writer *w,
+    char *buf,
+    size_t size,
+    metrics_flush_func *flush,
+    void *ctx
+) {
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->flush = flush;
+    w->ctx = ctx;
+    w->ok = true;
+}
+
+static void metrics_flush(metrics_writer *w) {
+    if (w->ok && w->len)
+        w->ok = w->flush(w->ctx, w->buf, w->len);
+    w->len = 0;
+}
+
+void metrics_printf(metrics_writer *w, const char *fmt, ...) {
+    if (!w->ok)
+        return;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        size_t space = w->size - w->len;
+        va_list ap;
+        va_start(ap, fmt);
+        int len = vsnprintf(w->buf + w->len, space, fmt, ap);
+        va_end(ap);
+        if (len < 0) {
+            w->ok = false;
+            return;
+        }
+        if ((size_t)len < space) {
+            w->len += len;
+            return;
+        }
+        // Didn't fit; drop the partial line, flush, and retry once into the
+        // empty buffer.
+        if (!w->len) {
+            w->ok = false;
+            return;
+        }
+        metrics_flush(w);
+    }
+}
+
+void metrics_header(
+    metrics_writer *w,
+    const char *name,
+    const char *type,
+    const char *help
+) {
+    metrics_printf(w, "# HELP %s %s\n", name, help);
+    metrics_printf(w, "# TYPE %s %s\n", name, type);
+}
+
+void metrics_sample(
+    metrics_writer *w,
+    const char *name,
+    const char *labels,
+    uint64_t value
+) {
+    if (labels)
+        metrics_printf(w, "%s{%s} %llu\n", name, labels,
+            (unsigned long long)value);
+    else
+        metrics_printf(w, "%s %llu\n", name, (unsigned long long)value);
+}
+
+void metrics_sample_us(
+    metrics_writer *w,
+    const char *name,
+    const char *labels,
+    uint64_t us
+) {
+    unsigned long long s = us / 1000000;
+    unsigned long frac = us % 1000000;
+    if (labels)
+        metrics_printf(w, "%s{%s} %llu.%06lu\n", name, labels, s, frac);
+    else
+        metrics_printf(w, "%s %llu.%06lu\n", name, s, frac);
+}
+
+void metrics_histogram_us(
+    metrics_writer *w,
+    const char *name,
+    const char *labels,
+    const uint32_t *bounds_us,
+    int n_bounds,
+    const uint32_t *buckets,
+    uint64_t sum_us
+) {
+    const char *sep = labels ? "," : "";
+    if (!labels)
+        labels = "";
+    uint64_t cumulative = 0;
+    for (int i = 0; i < n_bounds; i++) {
+        cumulative += buckets[i];
+        metrics_printf(w, "%s_bucket{%s%sle=\"%lu.%06lu\"} %llu\n",
+            name, labels, sep,
+            (unsigned long)(bounds_us[i] / 1000000),
+            (unsigned long)(bounds_us[i] % 1000000),
+            (unsigned long long)cumulative);
+    }
+    cumulative += buckets[n_bounds];
+    metrics_printf(w, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels, sep,
+        (unsigned long long)cumulative);
+    metrics_printf(w, "%s_sum%s%s%s %llu.%06lu\n", name,
+        *labels ? "{" : "", labels, *labels ? "}" : "",
+        (unsigned long long)(sum_us / 1000000),
+        (unsigned long)(sum_us % 1000000));
+    metrics_printf(w, "%s_count%s%s%s %llu\n", name,
+        *labels ? "{" : "", labels, *labels ? "}" : "",
+        (unsigned long long)cumulative);
+}
+
+bool metrics_writer_finish(metrics_writer *w) {
+    metrics_flush(w);
+    return w->ok;
+}
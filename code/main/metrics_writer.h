@@ -0,0 +1,69 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Incremental Prometheus text exposition format (version 0.0.4) writer. Output
+// accumulates in a small caller-supplied buffer, which is flushed whenever the
+// next line wouldn't fit, so the full document is never held in memory.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Returns false on error; no further output is attempted.
+typedef bool metrics_flush_func(void *ctx, const char *buf, size_t len);
+
+struct metrics_writer {
+    char *buf;
+    size_t size;
+    size_t len;
+    metrics_flush_func *flush;
+    void *ctx;
+    bool ok;
+};
+
+extern void metrics_writer_init(
+    metrics_writer *w,
+    char *buf,
+    size_t size,
+    metrics_flush_func *flush,
+    void *ctx
+);
+// Each line must fit in the buffer.
+__attribute__((format(printf, 2, 3)))
+extern void metrics_printf(metrics_writer *w, const char *fmt, ...);
+// type is "counter", "gauge" or "histogram".
+extern void metrics_header(
+    metrics_writer *w,
+    const char *name,
+    const char *type,
+    const char *help
+);
+// labels is e.g. "result=\"grant\"", or nullptr.
+extern void metrics_sample(
+    metrics_writer *w,
+    const char *name,
+    const char *labels,
+    uint64_t value
+);
+// A microsecond value, written in seconds.
+extern void metrics_sample_us(
+    metrics_writer *w,
+    const char *name,
+    const char *labels,
+    uint64_t us
+);
+// buckets[] are per-bucket (not cumulative) counts; there are n_bounds + 1
+// of them, the last being unbounded. Bounds and sum are in microseconds,
+// and are written in seconds.
+extern void metrics_histogram_us(
+    metrics_writer *w,
+    const char *name,
+    const char *labels,
+    const uint32_t *bounds_us,
+    int n_bounds,
+    const uint32_t *buckets,
+    uint64_t sum_us
+);
+// Flush any remaining output. Returns false if any flush failed.
+extern bool metrics_writer_finish(metrics_writer *w);
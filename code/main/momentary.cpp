@@ -4,27 +4,15 @@
 #include <esp_log.h>
 #include <freertos/FreeRTOS.h>
 
+#include "conf_watch.h"
+#include "dispatch.h"
 #include "fcch_connmgr/cm_conf.h"
 #include "fcch_connmgr/cm_util.h"
+#include "fcch_trace/trace.h"
 #include "momentary.h"
 
 static const char *TAG = "momentary";
 
-enum momentary_message_id {
-    MOMENTARY_MESSAGE_TIMER,
-    MOMENTARY_MESSAGE_RFID_PRESENT,
-    MOMENTARY_MESSAGE_RFID_ABSENT,
-};
-
-struct momentary_message {
-    momentary_message_id id;
-    union {
-        uint32_t dummy;
-        uint32_t rfid;
-        uint32_t timer_epoch;
-    };
-};
-
 #define BLOCK_TIME (10 / portTICK_PERIOD_MS)
 
 static uint16_t momentary_seconds;
@@ -57,33 +45,43 @@ static cm_conf_page momentary_page = {
     .items_count = ARRAY_SIZE(momentary_items),
 };
 
-static QueueHandle_t momentary_queue;
+static StaticTimer_t momentary_timer_buf;
 static TimerHandle_t momentary_timer;
 static uint32_t momentary_timer_epoch;
+// Applied momentary time; 0 if disabled. Only changed by momentary_apply(), so
+// the configuration can change without the timer state becoming inconsistent.
+static uint32_t momentary_ms;
+// A card has been granted/denied, and the absent callback not yet called.
+static bool momentary_active;
 static momentary_callback_present *momentary_cb_present;
 static momentary_callback_absent *momentary_cb_absent;
 
 static bool momentary_enabled() {
-    return (momentary_seconds != 0) || (momentary_milliseconds != 0);
+    return momentary_ms != 0;
 }
 
 static uint32_t momentary_calc_ms() {
     return (momentary_seconds * 1000) + momentary_milliseconds;
 }
 
-static void momentary_on_msg_timer(momentary_message &msg) {
-    assert(momentary_enabled());
+static void momentary_absent() {
+    momentary_active = false;
+    momentary_cb_absent();
+}
 
-    if (msg.timer_epoch != momentary_timer_epoch) {
-        ESP_LOGW(TAG, "epoch mismatch: msg:%" PRIu32 ", state:%" PRIu32,
-            msg.timer_epoch, momentary_timer_epoch);
+static void momentary_on_event_timer(const dispatch_event &ev) {
+    if (ev.timer_epoch != momentary_timer_epoch) {
+        trace(TRACE_ID_MOMENTARY_EPOCH_STALE, ev.timer_epoch,
+            momentary_timer_epoch);
         return;
     }
-    momentary_cb_absent();
+    assert(momentary_enabled());
+    momentary_absent();
 }
 
-static void momentary_on_msg_rfid_present(momentary_message &msg) {
-    momentary_cb_present(msg.rfid);
+static void momentary_on_event_rfid_present(const dispatch_event &ev) {
+    momentary_active = true;
+    momentary_cb_present(ev.rfid);
 
     if (momentary_enabled()) {
         assert(xTimerStop(momentary_timer, BLOCK_TIME) == pdPASS);
@@ -92,85 +90,74 @@ static void momentary_on_msg_rfid_present(momentary_message &msg) {
     }
 }
 
-static void momentary_on_msg_rfid_absent(momentary_message &msg) {
+static void momentary_on_event_rfid_absent(const dispatch_event &ev) {
     if (!momentary_enabled()) {
-        momentary_cb_absent();
-    }
-}
-
-static void momentary_task(void *pvParameters) {
-    for (;;) {
-        momentary_message msg;
-        assert(xQueueReceive(momentary_queue, &msg, portMAX_DELAY) == pdTRUE);
-        ESP_LOGD(TAG, "msg.id %d", msg.id);
-        switch (msg.id) {
-        case MOMENTARY_MESSAGE_TIMER:
-            momentary_on_msg_timer(msg);
-            break;
-        case MOMENTARY_MESSAGE_RFID_PRESENT:
-            momentary_on_msg_rfid_present(msg);
-            break;
-        case MOMENTARY_MESSAGE_RFID_ABSENT:
-            momentary_on_msg_rfid_absent(msg);
-            break;
-        default:
-            ESP_LOGE(TAG, "Unknown message: %d", (int)msg.id);
-            break;
-        }
+        momentary_absent();
     }
 }
 
 static void momentary_on_timer(TimerHandle_t xTimer) {
-    assert(momentary_enabled());
-
-    momentary_message msg{
-        .id = MOMENTARY_MESSAGE_TIMER,
+    dispatch_event ev{
+        .id = DISPATCH_EVENT_MOMENTARY_TIMER,
         .timer_epoch = momentary_timer_epoch,
     };
-    assert(xQueueSend(momentary_queue, &msg, BLOCK_TIME) == pdTRUE);
+    dispatch_post(ev);
 }
 
-void momentary_register_conf() {
-    cm_conf_register_page(&momentary_page);
-}
-
-void momentary_init(
-    momentary_callback_present *present,
-    momentary_callback_absent *absent
-) {
-    momentary_cb_present = present;
-    momentary_cb_absent = absent;
+// Runs in the dispatch task, at init and on configuration change. Any current
+// session is ended, since its timing (or lack of it) no longer applies: with
+// momentary newly disabled, the card may already have gone, so no absent
+// event would ever end it, and with it newly enabled, the card's absent event
+// would be ignored.
+static void momentary_apply() {
+    uint32_t ms = momentary_calc_ms();
+    if (ms == momentary_ms)
+        return;
+    ESP_LOGI(TAG, "momentary time %lu ms", ms);
 
-    momentary_queue = xQueueCreate(8, sizeof(momentary_message));
-    assert(momentary_queue != NULL);
+    if (momentary_timer != NULL)
+        assert(xTimerStop(momentary_timer, BLOCK_TIME) == pdPASS);
+    momentary_timer_epoch++;
+    momentary_ms = ms;
+    if (momentary_active)
+        momentary_absent();
+    if (!ms)
+        return;
 
-    uint32_t ms = momentary_calc_ms();
-    if (ms > 0) {
-        momentary_timer = xTimerCreate(
+    if (momentary_timer == NULL) {
+        momentary_timer = xTimerCreateStatic(
             "momentary",
             ms / portTICK_PERIOD_MS,
             pdFALSE,
             NULL,
-            momentary_on_timer);
+            momentary_on_timer,
+            &momentary_timer_buf);
         assert(momentary_timer != NULL);
+    } else {
+        // This also starts the timer, so stop it again.
+        assert(xTimerChangePeriod(momentary_timer, ms / portTICK_PERIOD_MS,
+            BLOCK_TIME) == pdPASS);
+        assert(xTimerStop(momentary_timer, BLOCK_TIME) == pdPASS);
     }
-
-    BaseType_t xRet = xTaskCreate(momentary_task, "momentary", 1024, NULL, 5, NULL);
-    assert(xRet == pdPASS);
 }
 
-void momentary_on_rfid_present(uint32_t rfid) {
-    momentary_message msg{
-        .id = MOMENTARY_MESSAGE_RFID_PRESENT,
-        .rfid = rfid,
-    };
-    assert(xQueueSend(momentary_queue, &msg, BLOCK_TIME) == pdTRUE);
+void momentary_register_conf() {
+    cm_conf_register_page(&momentary_page);
 }
 
-void momentary_on_rfid_absent() {
-    momentary_message msg{
-        .id = MOMENTARY_MESSAGE_RFID_ABSENT,
-        .dummy = 0,
-    };
-    assert(xQueueSend(momentary_queue, &msg, BLOCK_TIME) == pdTRUE);
+void momentary_init(
+    momentary_callback_present *present,
+    momentary_callback_absent *absent
+) {
+    momentary_cb_present = present;
+    momentary_cb_absent = absent;
+
+    momentary_apply();
+    conf_watch_register_page(&momentary_page, momentary_apply);
+
+    dispatch_register(DISPATCH_EVENT_MOMENTARY_TIMER, momentary_on_event_timer);
+    dispatch_register(DISPATCH_EVENT_RFID_PRESENT,
+        momentary_on_event_rfid_present);
+    dispatch_register(DISPATCH_EVENT_RFID_ABSENT,
+        momentary_on_event_rfid_absent);
 }
@@ -1,4 +1,4 @@
-// Copyright 2024-2025 Stephen Warren <swarren@wwwdotorg.org>
+// Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
 // SPDX-License-Identifier: MIT
 
 #pragma once
@@ -13,5 +13,3 @@ extern void momentary_init(
     momentary_callback_present *present,
     momentary_callback_absent *absent
 );
-extern void momentary_on_rfid_present(uint32_t rfid);
-extern void momentary_on_rfid_absent();
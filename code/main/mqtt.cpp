@@ -1,183 +1,609 @@
 // Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
 // SPDX-License-Identifier: MIT
 
+#include <esp_heap_caps.h>
 #include <esp_log.h>
 #include <freertos/FreeRTOS.h>
 #include <stdio.h>
+#include <sys/param.h>
 
+#include "boot.h"
+#include "conf_watch.h"
+#include "dispatch.h"
+#include "fcch_connmgr/cm_conf.h"
 #include "fcch_connmgr/cm_mqtt.h"
 #include "fcch_connmgr/cm_util.h"
+#include "fcch_rfid/rfid.h"
+#include "latency.h"
+#include "lcd.h"
 #include "mqtt.h"
+#include "mqtt_format.h"
+#include "mqtt_queue.h"
+#include "relay.h"
+#include "stall.h"
+#include "tasks.h"
+#include "timesync.h"
 
 static const char *TAG = "mqtt";
 
-enum mqtt_message_id {
-    MQTT_MESSAGE_TIMER,
-    MQTT_MESSAGE_RFID_ERR,
-    MQTT_MESSAGE_RFID_OK,
-    MQTT_MESSAGE_RFID_BAD,
-    MQTT_MESSAGE_RFID_NONE,
+// The dispatch task only queues each state change and wakes mqtt_task, so a
+// slow broker never stalls event dispatch. Changes wait in the queue while
+// the broker is unreachable, and are then published in order, in batches of
+// at most MQTT_DRAIN_BATCH every MQTT_DRAIN_INTERVAL_MS, so a backlog
+// doesn't flood the broker after an outage.
+//
+// On a periodic tick, if the latest change was already published, only a
+// small heartbeat is sent, except that every MQTT_STATUS_REFRESH_PERIODS
+// ticks the full status is repeated, so a subscriber that starts later learns
+// the current state. (connmgr's publish API has no retained flag, which would
+// make the refresh unnecessary.)
+//
+// The boot phase times are published once, when connected after the last
+// phase is reached, since they don't change after that.
+//
+// The stats messages (rfid_reader, fast_grant, dispatch, tasks, stall and
+// latency) are only for diagnosis, and /metrics has the same numbers, so they
+// go out on their own, much longer period, and each is skipped if it's
+// identical to the last one of its kind published.
+#define MQTT_DRAIN_BATCH 8
+#define MQTT_DRAIN_INTERVAL_MS 500
+#define MQTT_STATUS_REFRESH_PERIODS 10
+
+static const uint16_t mqtt_default_stats_period = 15;
+
+static uint16_t mqtt_stats_period;
+static cm_conf_item mqtt_item_stats_period = {
+    .slug_name = "sp", // Stats Period
+    .text_name = "Stats Message Period (Minutes, 0 for 15)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &mqtt_stats_period },
+    .default_func = &cm_conf_default_u16_0,
 };
 
-struct mqtt_message {
-    mqtt_message_id id;
-    union {
-        uint32_t rfid;
-        uint32_t timer_epoch;
-    };
+static cm_conf_item *mqtt_items[] = {
+    &mqtt_item_stats_period,
 };
 
-#define BLOCK_TIME (10 / portTICK_PERIOD_MS)
+static cm_conf_page mqtt_page = {
+    .slug_name = "mqs", // MQtt Stats
+    .text_name = "MQTT Stats",
+    .items = mqtt_items,
+    .items_count = ARRAY_SIZE(mqtt_items),
+};
 
-static QueueHandle_t mqtt_queue;
-static TimerHandle_t mqtt_timer;
-static uint32_t mqtt_timer_epoch;
-static const char* mqtt_last_status;
-static const char* mqtt_last_rfid_status;
-static uint32_t mqtt_last_rfid;
+static portMUX_TYPE mqtt_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t mqtt_task_handle;
+static mqtt_state mqtt_last_state{
+    .rfid_status = MQTT_RFID_STATUS_ABSENT,
+    .rfid = 0,
+    .boot = 0,
+    .seq = 0,
+    .time_ms = -1,
+    .decision_us = -1,
+};
+static uint32_t mqtt_seq;
+// Set when the status period changed, so mqtt_task must reschedule.
+static bool mqtt_period_changed;
+static mqtt_stats mqtt_cur_stats;
+// Only used by mqtt_task. The seq and length of the last status of this boot
+// published.
+static uint32_t mqtt_published_seq = UINT32_MAX;
+static size_t mqtt_published_len;
+static uint32_t mqtt_periods_since_status;
+static rfid_stats mqtt_last_rfid_stats;
+static TickType_t mqtt_last_rfid_stats_time;
+// Hashes of the last stats message of each kind published.
+static uint32_t mqtt_rfid_stats_hash;
+static uint32_t mqtt_fast_grant_stats_hash;
+static uint32_t mqtt_dispatch_stats_hash;
+static uint32_t mqtt_task_stats_hash;
+static uint32_t mqtt_stall_stats_hash;
+static bool mqtt_boot_stats_published;
+static uint32_t mqtt_latency_stats_hashes[LATENCY_STAGE_NUM];
 
-static void mqtt_publish_status() {
-    AutoFree<char> data;
-    asprintf(
-        &data.val,
-        "{\"status\":\"%s\",\"rfid_status\":\"%s\",\"rfid\":%lu}",
-        mqtt_last_status, mqtt_last_rfid_status, mqtt_last_rfid);
-    assert(data.val != NULL);
+static void mqtt_publish_status(const mqtt_state &state) {
+    char buf[MQTT_STATUS_BUF_SIZE];
+    size_t len = mqtt_format_status(buf, state);
+    cm_mqtt_publish_stat(buf);
+    if (state.boot == boot_get_count()) {
+        mqtt_published_seq = state.seq;
+        mqtt_published_len = len;
+        mqtt_periods_since_status = 0;
+    }
 
-    cm_mqtt_publish_stat(data.val);
+    portENTER_CRITICAL(&mqtt_lock);
+    mqtt_cur_stats.status_msgs++;
+    mqtt_cur_stats.bytes += len;
+    portEXIT_CRITICAL(&mqtt_lock);
 }
 
-static void mqtt_start_timer() {
-    if (mqtt_timer == NULL)
+// Returns true if changes remain queued: either more than one batch, or the
+// broker is unreachable.
+static bool mqtt_drain() {
+    // A message published while disconnected would be dropped.
+    if (!cm_mqtt_get_info().connected) {
+        mqtt_queue_spill();
+        return mqtt_queue_depth() != 0;
+    }
+    for (int i = 0; i < MQTT_DRAIN_BATCH; i++) {
+        mqtt_state state;
+        if (!mqtt_queue_peek(&state))
+            return false;
+        mqtt_publish_status(state);
+        mqtt_queue_pop();
+    }
+    return mqtt_queue_depth() != 0;
+}
+
+static void mqtt_publish_status_or_heartbeat() {
+    // Anything queued is published by mqtt_drain(), in order.
+    if (!cm_mqtt_get_info().connected || mqtt_queue_depth())
         return;
-    mqtt_timer_epoch++;
-    assert(xTimerStart(mqtt_timer, BLOCK_TIME) == pdPASS);
+
+    portENTER_CRITICAL(&mqtt_lock);
+    mqtt_state state = mqtt_last_state;
+    portEXIT_CRITICAL(&mqtt_lock);
+
+    mqtt_periods_since_status++;
+    if (state.seq != mqtt_published_seq ||
+        mqtt_periods_since_status >= MQTT_STATUS_REFRESH_PERIODS
+    ) {
+        mqtt_publish_status(state);
+        return;
+    }
+
+    char buf[MQTT_STATUS_BUF_SIZE];
+    size_t len = mqtt_format_heartbeat(buf, state.boot, state.seq);
+    cm_mqtt_publish_stat(buf);
+
+    portENTER_CRITICAL(&mqtt_lock);
+    mqtt_cur_stats.heartbeat_msgs++;
+    mqtt_cur_stats.bytes += len;
+    if (mqtt_published_len > len)
+        mqtt_cur_stats.bytes_saved += mqtt_published_len - len;
+    portEXIT_CRITICAL(&mqtt_lock);
+}
+
+static uint32_t mqtt_hash(const char *s) {
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (; *s; s++)
+        hash = (hash ^ (uint8_t)*s) * 16777619UL;
+    return hash;
 }
 
-static void mqtt_on_msg_timer(mqtt_message &msg) {
-    if (msg.timer_epoch != mqtt_timer_epoch) {
-        ESP_LOGW(TAG, "epoch mismatch: msg:%" PRIu32 ", state:%" PRIu32,
-            msg.timer_epoch, mqtt_timer_epoch);
+// Publish a stats message, unless it's the same as the last one of its kind,
+// whose hash is *last_hash.
+static void mqtt_publish_stats_msg(const char *buf, size_t len,
+    uint32_t *last_hash) {
+    // A message published while disconnected would be dropped, and then
+    // wrongly skipped next time as unchanged.
+    if (!cm_mqtt_get_info().connected)
         return;
+    uint32_t hash = mqtt_hash(buf);
+    bool unchanged = hash == *last_hash;
+    if (!unchanged) {
+        cm_mqtt_publish_stat(buf);
+        *last_hash = hash;
     }
-    mqtt_publish_status();
+
+    portENTER_CRITICAL(&mqtt_lock);
+    if (unchanged) {
+        mqtt_cur_stats.stats_unchanged++;
+        mqtt_cur_stats.bytes_saved += len;
+    } else {
+        mqtt_cur_stats.stats_msgs++;
+        mqtt_cur_stats.bytes += len;
+    }
+    portEXIT_CRITICAL(&mqtt_lock);
+}
+
+static void mqtt_publish_rfid_stats() {
+    rfid_stats stats;
+    rfid_get_stats(&stats);
+    TickType_t now = xTaskGetTickCount();
+
+    uint32_t elapsed_ms =
+        (now - mqtt_last_rfid_stats_time) * portTICK_PERIOD_MS;
+    uint32_t frames = stats.frames - mqtt_last_rfid_stats.frames;
+    // Fixed point with 2 decimal places, to avoid floating point formatting.
+    uint32_t frames_per_s_x100 =
+        elapsed_ms ? (uint32_t)((frames * 100000ULL) / elapsed_ms) : 0;
+    uint32_t frames_per_presentation_x100 = stats.presentations ?
+        (uint32_t)((stats.frames * 100ULL) / stats.presentations) : 0;
+
+    char buf[256];
+    int len = snprintf(buf, sizeof(buf),
+        "{\"rfid_reader\":{"
+        "\"frames\":%lu,"
+        "\"frames_per_s\":%lu.%02lu,"
+        "\"crc_errors\":%lu,"
+        "\"framing_errors\":%lu,"
+        "\"timeouts\":%lu,"
+        "\"presentations\":%lu,"
+        "\"frames_per_presentation\":%lu.%02lu}}",
+        stats.frames,
+        frames_per_s_x100 / 100, frames_per_s_x100 % 100,
+        stats.crc_errors,
+        stats.framing_errors,
+        stats.timeouts,
+        stats.presentations,
+        frames_per_presentation_x100 / 100, frames_per_presentation_x100 % 100);
+    assert(len < (int)sizeof(buf));
+
+    mqtt_publish_stats_msg(buf, len, &mqtt_rfid_stats_hash);
+
+    mqtt_last_rfid_stats = stats;
+    mqtt_last_rfid_stats_time = now;
 }
 
-static void mqtt_on_msg_rfid_err(mqtt_message &msg) {
-    mqtt_last_rfid = msg.rfid;
-    mqtt_last_status = "OFF";
-    mqtt_last_rfid_status = "ERROR";
-    mqtt_publish_status();
+// Runs in the dispatch task, immediately after the decision (if any).
+static void mqtt_set_state(mqtt_state state) {
+    if (!timesync_get_time_ms(&state.time_ms))
+        state.time_ms = -1;
+    state.boot = boot_get_count();
+    portENTER_CRITICAL(&mqtt_lock);
+    state.seq = ++mqtt_seq;
+    mqtt_last_state = state;
+    portEXIT_CRITICAL(&mqtt_lock);
+    mqtt_queue_push(state);
+    xTaskNotifyGive(mqtt_task_handle);
 }
 
-static void mqtt_on_msg_rfid_ok(mqtt_message &msg) {
-    mqtt_last_rfid = msg.rfid;
-    mqtt_last_status = "ON";
-    mqtt_last_rfid_status = "GRANT";
-    mqtt_publish_status();
+static void mqtt_on_event_rfid_err(const dispatch_event &ev) {
+    mqtt_set_state({
+        .rfid_status = MQTT_RFID_STATUS_ERROR,
+        .rfid = ev.rfid,
+        .decision_us = latency_get_decision_us(),
+    });
 }
 
-static void mqtt_on_msg_rfid_bad(mqtt_message &msg) {
-    mqtt_last_rfid = msg.rfid;
-    mqtt_last_status = "OFF";
-    mqtt_last_rfid_status = "DENY";
-    mqtt_publish_status();
+static void mqtt_on_event_rfid_ok(const dispatch_event &ev) {
+    mqtt_set_state({
+        .rfid_status = MQTT_RFID_STATUS_GRANT,
+        .rfid = ev.rfid,
+        .decision_us = latency_get_decision_us(),
+    });
 }
 
-static void mqtt_on_msg_rfid_none(mqtt_message &msg) {
-    mqtt_last_rfid = msg.rfid;
-    mqtt_last_status = "OFF";
-    mqtt_last_rfid_status = "ABSENT";
-    mqtt_publish_status();
+static void mqtt_on_event_rfid_bad(const dispatch_event &ev) {
+    mqtt_set_state({
+        .rfid_status = MQTT_RFID_STATUS_DENY,
+        .rfid = ev.rfid,
+        .decision_us = latency_get_decision_us(),
+    });
 }
 
-static void mqtt_task(void *pvParameters) {
-    for (;;) {
-        mqtt_message msg;
-        assert(xQueueReceive(mqtt_queue, &msg, portMAX_DELAY) == pdTRUE);
-        ESP_LOGI(TAG, "msg.id %d", msg.id);
-        switch (msg.id) {
-        case MQTT_MESSAGE_TIMER:
-            mqtt_on_msg_timer(msg);
-            break;
-        case MQTT_MESSAGE_RFID_ERR:
-            mqtt_on_msg_rfid_err(msg);
-            break;
-        case MQTT_MESSAGE_RFID_OK:
-            mqtt_on_msg_rfid_ok(msg);
-            break;
-        case MQTT_MESSAGE_RFID_BAD:
-            mqtt_on_msg_rfid_bad(msg);
-            break;
-        case MQTT_MESSAGE_RFID_NONE:
-            mqtt_on_msg_rfid_none(msg);
-            break;
-        default:
-            ESP_LOGE(TAG, "Unknown message: %d", (int)msg.id);
-            break;
+static void mqtt_on_event_rfid_none(const dispatch_event &ev) {
+    mqtt_set_state({
+        .rfid_status = MQTT_RFID_STATUS_ABSENT,
+        .rfid = 0,
+        .decision_us = -1,
+    });
+}
+
+static void mqtt_publish_fast_grant_stats() {
+    relay_fast_stats stats;
+    relay_get_fast_stats(&stats);
+    if (!stats.grants)
+        return;
+
+    char buf[128];
+    int len = snprintf(buf, sizeof(buf),
+        "{\"fast_grant\":{"
+        "\"grants\":%lu,"
+        "\"latency_us_last\":%lu,"
+        "\"latency_us_max\":%lu}}",
+        stats.grants,
+        (uint32_t)stats.latency_us_last,
+        (uint32_t)stats.latency_us_max);
+    assert(len < (int)sizeof(buf));
+
+    mqtt_publish_stats_msg(buf, len, &mqtt_fast_grant_stats_hash);
+}
+
+static void mqtt_publish_dispatch_stats() {
+    dispatch_stats stats;
+    dispatch_get_stats(&stats);
+    mqtt_queue_stats queue_stats;
+    mqtt_queue_get_stats(&queue_stats);
+
+    char buf[320];
+    int len = snprintf(buf, sizeof(buf),
+        "{\"dispatch\":{"
+        "\"events\":%lu,"
+        "\"queue_hwm\":%lu,"
+        "\"queue_coalesced\":%lu,"
+        "\"queue_drops\":%lu,"
+        "\"presence_hwm\":%lu,"
+        "\"presence_overflows\":%lu,"
+        "\"lcd_coalesced\":%lu,"
+        "\"mqtt_queue_drops\":%lu}}",
+        stats.events,
+        stats.queue_hwm,
+        stats.queue_coalesced,
+        stats.queue_drops,
+        stats.presence_hwm,
+        stats.presence_overflows,
+        lcd_get_coalesced(),
+        queue_stats.drops);
+    assert(len < (int)sizeof(buf));
+
+    mqtt_publish_stats_msg(buf, len, &mqtt_dispatch_stats_hash);
+}
+
+static void mqtt_publish_task_stats() {
+    char buf[256];
+    int len = snprintf(buf, sizeof(buf), "{\"tasks\":{\"stack_free\":{");
+    for (int i = 0; i < TASKS_ID_NUM; i++) {
+        tasks_id id = (tasks_id)i;
+        uint32_t stack_free = tasks_get_stack_free(id);
+        if (stack_free == UINT32_MAX)
+            continue;
+        const char *name = tasks_get_config(id)->name;
+        if (tasks_stack_low(stack_free))
+            ESP_LOGW(TAG, "task %s stack low: %lu free", name, stack_free);
+        len += snprintf(buf + len, sizeof(buf) - len, "%s\"%s\":%lu",
+            (buf[len - 1] == '{') ? "" : ",", name, stack_free);
+        assert(len < (int)sizeof(buf));
+    }
+    len += snprintf(buf + len, sizeof(buf) - len,
+        "},\"heap_free\":%u,\"heap_min_free\":%u}}",
+        heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    assert(len < (int)sizeof(buf));
+
+    mqtt_publish_stats_msg(buf, len, &mqtt_task_stats_hash);
+}
+
+static void mqtt_publish_stall_stats() {
+    char buf[384];
+    int len = snprintf(buf, sizeof(buf), "{\"stall\":{");
+    for (int i = 0; i < STALL_ID_NUM; i++) {
+        stall_id id = (stall_id)i;
+        stall_stats stats;
+        stall_get_stats(id, &stats);
+        len += snprintf(buf + len, sizeof(buf) - len,
+            "%s\"%s\":{"
+            "\"count\":%lu,"
+            "\"over_budget\":%lu,"
+            "\"us_p50\":%lu,"
+            "\"us_p99\":%lu,"
+            "\"us_max\":%lu}",
+            i ? "," : "", stall_name(id),
+            stats.count,
+            stats.over_budget,
+            stats.us_p50,
+            stats.us_p99,
+            stats.us_max);
+        assert(len < (int)sizeof(buf));
+    }
+    len += snprintf(buf + len, sizeof(buf) - len, "}}");
+    assert(len < (int)sizeof(buf));
+
+    mqtt_publish_stats_msg(buf, len, &mqtt_stall_stats_hash);
+}
+
+// Warnings are published as they're raised, not on a period.
+static void mqtt_publish_stall_warnings() {
+    stall_warning warning;
+    while (stall_pop_warning(&warning)) {
+        char buf[160];
+        int len = snprintf(buf, sizeof(buf),
+            "{\"stall_warning\":{"
+            "\"task\":\"%s\","
+            "\"event\":%lu,"
+            "\"duration_us\":%lu,"
+            "\"budget_us\":%lu,"
+            "\"in_progress\":%s}}",
+            stall_name(warning.id),
+            warning.tag,
+            warning.duration_us,
+            warning.budget_us,
+            warning.in_progress ? "true" : "false");
+        assert(len < (int)sizeof(buf));
+
+        cm_mqtt_publish_stat(buf);
+
+        if (cm_mqtt_get_info().connected) {
+            portENTER_CRITICAL(&mqtt_lock);
+            mqtt_cur_stats.bytes += len;
+            portEXIT_CRITICAL(&mqtt_lock);
         }
     }
 }
 
-static void mqtt_on_timer(TimerHandle_t xTimer) {
-    ESP_LOGI(TAG, "mqtt_on_timer()");
-    mqtt_message msg{
-        .id = MQTT_MESSAGE_TIMER,
-        .timer_epoch = mqtt_timer_epoch,
-    };
-    assert(xQueueSend(mqtt_queue, &msg, BLOCK_TIME) == pdTRUE);
+static void mqtt_publish_boot_stats() {
+    if (mqtt_boot_stats_published || !cm_mqtt_get_info().connected ||
+        boot_get_time((boot_phase)(BOOT_PHASE_NUM - 1)) < 0)
+        return;
+
+    char buf[256];
+    int len = snprintf(buf, sizeof(buf), "{\"boot_us\":{");
+    for (int i = 0; i < BOOT_PHASE_NUM; i++) {
+        boot_phase phase = (boot_phase)i;
+        int64_t t = boot_get_time(phase);
+        if (t < 0)
+            continue;
+        len += snprintf(buf + len, sizeof(buf) - len, "%s\"%s\":%lu",
+            (buf[len - 1] == '{') ? "" : ",", boot_phase_name(phase),
+            (uint32_t)t);
+        assert(len < (int)sizeof(buf));
+    }
+    len += snprintf(buf + len, sizeof(buf) - len, "}}");
+    assert(len < (int)sizeof(buf));
+
+    cm_mqtt_publish_stat(buf);
+    mqtt_boot_stats_published = true;
+
+    portENTER_CRITICAL(&mqtt_lock);
+    mqtt_cur_stats.stats_msgs++;
+    mqtt_cur_stats.bytes += len;
+    portEXIT_CRITICAL(&mqtt_lock);
 }
 
-void mqtt_init() {
-    mqtt_queue = xQueueCreate(8, sizeof(mqtt_message));
-    assert(mqtt_queue != NULL);
-    mqtt_on_rfid_none();
-
-    if (cm_mqtt_status_period) {
-        mqtt_timer = xTimerCreate(
-            "mqtt",
-            (cm_mqtt_status_period * 1000) / portTICK_PERIOD_MS,
-            pdTRUE,
-            NULL,
-            mqtt_on_timer);
-        assert(mqtt_timer != NULL);
-        mqtt_start_timer();
-    } else {
-        mqtt_timer = NULL;
+// One message per stage, to keep each buffer small. Bucket bounds are listed
+// in README.md.
+static void mqtt_publish_latency_stats() {
+    for (int i = 0; i < LATENCY_STAGE_NUM; i++) {
+        latency_stage stage = (latency_stage)i;
+        latency_histogram hist;
+        latency_get(stage, &hist);
+        if (!hist.count)
+            continue;
+
+        char buf[320];
+        int len = snprintf(buf, sizeof(buf),
+            "{\"latency\":{"
+            "\"stage\":\"%s\","
+            "\"count\":%lu,"
+            "\"avg_us\":%lu,"
+            "\"max_us\":%lu,"
+            "\"buckets\":[",
+            latency_stage_name(stage),
+            hist.count,
+            (uint32_t)(hist.sum_us / hist.count),
+            hist.max_us);
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            len += snprintf(buf + len, sizeof(buf) - len, "%s%lu",
+                b ? "," : "", hist.buckets[b]);
+        }
+        len += snprintf(buf + len, sizeof(buf) - len, "]}}");
+        assert(len < (int)sizeof(buf));
+
+        mqtt_publish_stats_msg(buf, len, &mqtt_latency_stats_hashes[i]);
     }
+}
 
-    BaseType_t xRet = xTaskCreate(mqtt_task, "mqtt", 4096, NULL, 5, NULL);
-    assert(xRet == pdPASS);
+static void mqtt_on_stall_warning() {
+    xTaskNotifyGive(mqtt_task_handle);
 }
 
-void mqtt_on_rfid_err(uint32_t rfid) {
-    mqtt_message msg{
-        .id = MQTT_MESSAGE_RFID_ERR,
-        .rfid = rfid,
-    };
-    assert(xQueueSend(mqtt_queue, &msg, BLOCK_TIME) == pdTRUE);
+static TickType_t mqtt_calc_period() {
+    return (cm_mqtt_status_period * 1000) / portTICK_PERIOD_MS;
 }
 
-void mqtt_on_rfid_ok(uint32_t rfid) {
-    mqtt_message msg{
-        .id = MQTT_MESSAGE_RFID_OK,
-        .rfid = rfid,
-    };
-    assert(xQueueSend(mqtt_queue, &msg, BLOCK_TIME) == pdTRUE);
+static TickType_t mqtt_calc_stats_period() {
+    uint32_t minutes =
+        mqtt_stats_period ? mqtt_stats_period : mqtt_default_stats_period;
+    return (minutes * 60 * 1000) / portTICK_PERIOD_MS;
 }
 
-void mqtt_on_rfid_bad(uint32_t rfid) {
-    mqtt_message msg{
-        .id = MQTT_MESSAGE_RFID_BAD,
-        .rfid = rfid,
-    };
-    assert(xQueueSend(mqtt_queue, &msg, BLOCK_TIME) == pdTRUE);
+// Runs in the dispatch task.
+static void mqtt_on_conf_changed() {
+    portENTER_CRITICAL(&mqtt_lock);
+    mqtt_period_changed = true;
+    portEXIT_CRITICAL(&mqtt_lock);
+    xTaskNotifyGive(mqtt_task_handle);
 }
 
-void mqtt_on_rfid_none() {
-    mqtt_message msg{
-        .id = MQTT_MESSAGE_RFID_NONE,
-        .rfid = 0,
-    };
-    assert(xQueueSend(mqtt_queue, &msg, BLOCK_TIME) == pdTRUE);
+static void mqtt_task(void *pvParameters) {
+    TickType_t period = mqtt_calc_period();
+    TickType_t next_periodic = xTaskGetTickCount() + period;
+    TickType_t stats_period = mqtt_calc_stats_period();
+    TickType_t next_stats = xTaskGetTickCount() + stats_period;
+    // While changes are queued, mqtt_drain() runs when this is reached.
+    TickType_t next_drain = xTaskGetTickCount();
+
+    for (;;) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = portMAX_DELAY;
+        if (period) {
+            int32_t remaining = (int32_t)(next_periodic - now);
+            wait = (remaining > 0) ? remaining : 0;
+        }
+        int32_t stats_remaining = (int32_t)(next_stats - now);
+        wait = MIN(wait, (TickType_t)MAX(stats_remaining, 0));
+        bool queued = mqtt_queue_depth() != 0;
+        if (queued) {
+            int32_t remaining = (int32_t)(next_drain - now);
+            wait = MIN(wait, (TickType_t)MAX(remaining, 0));
+        }
+        bool notified = ulTaskNotifyTake(pdTRUE, wait);
+        now = xTaskGetTickCount();
+        if (notified) {
+            portENTER_CRITICAL(&mqtt_lock);
+            bool period_changed = mqtt_period_changed;
+            mqtt_period_changed = false;
+            portEXIT_CRITICAL(&mqtt_lock);
+            if (period_changed) {
+                period = mqtt_calc_period();
+                next_periodic = now + period;
+                stats_period = mqtt_calc_stats_period();
+                next_stats = now + stats_period;
+                ESP_LOGI(TAG, "status period %u s, stats period %lu min",
+                    cm_mqtt_status_period,
+                    stats_period * portTICK_PERIOD_MS / (60 * 1000));
+            }
+        }
+        queued = mqtt_queue_depth() != 0;
+        bool drain = queued && (int32_t)(next_drain - now) <= 0;
+        if (drain || notified) {
+            stall_enter(STALL_ID_MQTT, STALL_MQTT_TAG_STATE);
+            // Otherwise, changes that arrive go out immediately.
+            if (drain && mqtt_drain())
+                next_drain = now + MQTT_DRAIN_INTERVAL_MS / portTICK_PERIOD_MS;
+            mqtt_publish_boot_stats();
+            mqtt_publish_stall_warnings();
+            stall_exit(STALL_ID_MQTT);
+        }
+        if (period && (int32_t)(next_periodic - now) <= 0) {
+            ESP_LOGD(TAG, "periodic");
+            stall_enter(STALL_ID_MQTT, STALL_MQTT_TAG_PERIODIC);
+            mqtt_publish_status_or_heartbeat();
+            mqtt_publish_boot_stats();
+            mqtt_publish_stall_warnings();
+            stall_exit(STALL_ID_MQTT);
+            next_periodic += period;
+            now = xTaskGetTickCount();
+            if ((int32_t)(next_periodic - now) <= 0)
+                next_periodic = now + period;
+        }
+        if ((int32_t)(next_stats - now) <= 0) {
+            ESP_LOGD(TAG, "stats");
+            stall_enter(STALL_ID_MQTT, STALL_MQTT_TAG_PERIODIC);
+            mqtt_publish_rfid_stats();
+            mqtt_publish_fast_grant_stats();
+            mqtt_publish_dispatch_stats();
+            mqtt_publish_task_stats();
+            mqtt_publish_stall_stats();
+            mqtt_publish_latency_stats();
+            stall_exit(STALL_ID_MQTT);
+            next_stats = xTaskGetTickCount() + stats_period;
+        }
+    }
+}
+
+uint32_t mqtt_get_pending() {
+    return mqtt_queue_depth() + stall_get_pending_warnings();
+}
+
+void mqtt_get_stats(mqtt_stats *stats) {
+    portENTER_CRITICAL(&mqtt_lock);
+    *stats = mqtt_cur_stats;
+    portEXIT_CRITICAL(&mqtt_lock);
+}
+
+void mqtt_register_conf() {
+    cm_conf_register_page(&mqtt_page);
+    mqtt_queue_register_conf();
+}
+
+void mqtt_init() {
+    mqtt_last_rfid_stats_time = xTaskGetTickCount();
+    mqtt_queue_init();
+    // Publish the boot state once connected.
+    mqtt_last_state.boot = boot_get_count();
+    mqtt_queue_push(mqtt_last_state);
+
+    mqtt_task_handle = tasks_create(TASKS_ID_MQTT, mqtt_task);
+    assert(mqtt_task_handle != NULL);
+    stall_set_callback_warning(&mqtt_on_stall_warning);
+    conf_watch_register_u16(&cm_mqtt_status_period, mqtt_on_conf_changed);
+    conf_watch_register_page(&mqtt_page, mqtt_on_conf_changed);
+
+    dispatch_register(DISPATCH_EVENT_RFID_ERR, mqtt_on_event_rfid_err);
+    dispatch_register(DISPATCH_EVENT_RFID_OK, mqtt_on_event_rfid_ok);
+    dispatch_register(DISPATCH_EVENT_RFID_BAD, mqtt_on_event_rfid_bad);
+    dispatch_register(DISPATCH_EVENT_RFID_NONE, mqtt_on_event_rfid_none);
 }
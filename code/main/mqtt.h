@@ -1,10 +1,26 @@
-// Copyright 2024-2025 Stephen Warren <swarren@wwwdotorg.org>
+// Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
 // SPDX-License-Identifier: MIT
 
 #pragma once
 
+#include <stdint.h>
+
+// All monotonically increasing since boot. Only messages published while
+// connected are counted.
+struct mqtt_stats {
+    uint32_t status_msgs;     // Full status messages
+    uint32_t heartbeat_msgs;  // Heartbeats sent instead of an unchanged status
+    uint32_t stats_msgs;      // Stats messages
+    uint32_t stats_unchanged; // Stats messages skipped as unchanged
+    uint32_t bytes;           // Bytes of every message published
+    // Bytes not sent because a heartbeat replaced the full status, or a stats
+    // message was unchanged
+    uint32_t bytes_saved;
+};
+
+extern void mqtt_register_conf();
+// Call after boot_init().
 extern void mqtt_init();
-extern void mqtt_on_rfid_err(uint32_t rfid);
-extern void mqtt_on_rfid_ok(uint32_t rfid);
-extern void mqtt_on_rfid_bad(uint32_t rfid);
-extern void mqtt_on_rfid_none();
+// Messages waiting for mqtt_task to publish them.
+extern uint32_t mqtt_get_pending();
+extern void mqtt_get_stats(mqtt_stats *stats);
@@ -0,0 +1,64 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <assert.h>
+#include <string.h>
+
+#include "mqtt_format.h"
+
+static char *mqtt_format_u64(char *p, uint64_t val) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = '0' + (val % 10);
+        val /= 10;
+    } while (val);
+    while (n)
+        *p++ = digits[--n];
+    return p;
+}
+
+// JSON null for unknown (negative) values.
+static char *mqtt_format_i64_or_null(char *p, int64_t val) {
+    if (val < 0)
+        return stpcpy(p, "null");
+    return mqtt_format_u64(p, val);
+}
+
+static const char *mqtt_rfid_status_names[MQTT_RFID_STATUS_NUM] = {
+    [MQTT_RFID_STATUS_ABSENT] = "ABSENT",
+    [MQTT_RFID_STATUS_GRANT] = "GRANT",
+    [MQTT_RFID_STATUS_DENY] = "DENY",
+    [MQTT_RFID_STATUS_ERROR] = "ERROR",
+};
+
+size_t mqtt_format_status(char *buf, const mqtt_state &state) {
+    assert(state.rfid_status < MQTT_RFID_STATUS_NUM);
+    bool on = state.rfid_status == MQTT_RFID_STATUS_GRANT;
+
+    char *p = stpcpy(buf, "{\"status\":\"");
+    p = stpcpy(p, on ? "ON" : "OFF");
+    p = stpcpy(p, "\",\"rfid_status\":\"");
+    p = stpcpy(p, mqtt_rfid_status_names[state.rfid_status]);
+    p = stpcpy(p, "\",\"rfid\":");
+    p = mqtt_format_u64(p, state.rfid);
+    p = stpcpy(p, ",\"boot\":");
+    p = mqtt_format_u64(p, state.boot);
+    p = stpcpy(p, ",\"seq\":");
+    p = mqtt_format_u64(p, state.seq);
+    p = stpcpy(p, ",\"time_ms\":");
+    p = mqtt_format_i64_or_null(p, state.time_ms);
+    p = stpcpy(p, ",\"decision_us\":");
+    p = mqtt_format_i64_or_null(p, state.decision_us);
+    p = stpcpy(p, "}");
+    return p - buf;
+}
+
+size_t mqtt_format_heartbeat(char *buf, uint32_t boot, uint32_t seq) {
+    char *p = stpcpy(buf, "{\"heartbeat\":{\"boot\":");
+    p = mqtt_format_u64(p, boot);
+    p = stpcpy(p, ",\"seq\":");
+    p = mqtt_format_u64(p, seq);
+    p = stpcpy(p, "}}");
+    return p - buf;
+}
@@ -0,0 +1,45 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// MQTT status message formatting, into a fixed buffer with no heap use, since
+// it runs for every decision.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The JSON "status" is "ON" for GRANT, else "OFF".
+enum mqtt_rfid_status : uint8_t {
+    MQTT_RFID_STATUS_ABSENT,
+    MQTT_RFID_STATUS_GRANT,
+    MQTT_RFID_STATUS_DENY,
+    MQTT_RFID_STATUS_ERROR,
+    MQTT_RFID_STATUS_NUM,
+};
+
+struct mqtt_state {
+    mqtt_rfid_status rfid_status;
+    uint32_t rfid;
+    // Set by mqtt_set_state(), when the state changes. seq increments with
+    // each change, so consumers can order messages and detect missed ones;
+    // periodic republishes of an unchanged state repeat it. It restarts from
+    // 1 at boot, and boot (see boot_get_count()) identifies which boot it's
+    // from.
+    uint32_t boot;
+    uint32_t seq;
+    // Wall clock time of the change, or -1 if not synchronized.
+    int64_t time_ms;
+    // UART data to decision, or -1 if not a (timed) decision.
+    int64_t decision_us;
+};
+
+// Large enough for any status or heartbeat message, plus NUL.
+#define MQTT_STATUS_BUF_SIZE 192
+
+// Writes the status JSON document to buf, which must hold
+// MQTT_STATUS_BUF_SIZE bytes. Returns its length.
+extern size_t mqtt_format_status(char *buf, const mqtt_state &state);
+// Writes a heartbeat naming the boot and seq of the unchanged state, e.g.
+// {"heartbeat":{"boot":7,"seq":42}}. Returns its length.
+extern size_t mqtt_format_heartbeat(char *buf, uint32_t boot, uint32_t seq);
@@ -0,0 +1,329 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <stdio.h>
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <nvs.h>
+
+#include "fcch_connmgr/cm_conf.h"
+#include "fcch_connmgr/cm_util.h"
+#include "mqtt_queue.h"
+
+static const char *TAG = "mqtt_queue";
+
+// RAM holds MQTT_QUEUE_RAM_SIZE changes. Flash holds up to
+// MQTT_QUEUE_FLASH_BLOCKS blocks of MQTT_QUEUE_BLOCK_SIZE, each in its own NVS
+// key; a block is written once RAM holds that many changes, so each flash
+// write covers many swipes. Block numbers increase forever; the key is the
+// number modulo MQTT_QUEUE_FLASH_BLOCKS. The first and next block numbers are
+// saved in MQTT_QUEUE_NVS_KEY_INDEX.
+//
+// A block is erased once all its changes are published. Progress within a
+// block isn't saved, so after a reboot some changes may be published again;
+// consumers can discard repeated boot/seq pairs.
+#define MQTT_QUEUE_RAM_SIZE 32
+#define MQTT_QUEUE_BLOCK_SIZE 16
+#define MQTT_QUEUE_FLASH_BLOCKS 16
+#define MQTT_QUEUE_NVS_NAMESPACE "mqtt_queue"
+#define MQTT_QUEUE_NVS_KEY_INDEX "index"
+
+static uint16_t mqtt_queue_spill_enabled;
+static cm_conf_item mqtt_queue_item_spill = {
+    .slug_name = "fs", // Flash Spill
+    .text_name = "Queue Unpublished Changes in Flash (0: no, other: yes)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &mqtt_queue_spill_enabled },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static cm_conf_item *mqtt_queue_items[] = {
+    &mqtt_queue_item_spill,
+};
+
+static cm_conf_page mqtt_queue_page = {
+    .slug_name = "mqq", // MQtt Queue
+    .text_name = "MQTT Queue",
+    .items = mqtt_queue_items,
+    .items_count = ARRAY_SIZE(mqtt_queue_items),
+};
+
+struct __attribute__((packed)) mqtt_queue_record {
+    uint32_t boot;
+    uint32_t seq;
+    uint32_t rfid;
+    int64_t time_ms;
+    int32_t decision_us;
+    uint8_t rfid_status;
+};
+
+struct mqtt_queue_index {
+    uint32_t first;
+    uint32_t next;
+};
+
+static portMUX_TYPE mqtt_queue_lock = portMUX_INITIALIZER_UNLOCKED;
+static mqtt_state mqtt_queue_ram[MQTT_QUEUE_RAM_SIZE];
+// Free-running; the oldest change is at mqtt_queue_ram_tail.
+static uint32_t mqtt_queue_ram_head;
+static uint32_t mqtt_queue_ram_tail;
+static mqtt_queue_stats mqtt_queue_cur_stats;
+
+// Only used by mqtt_task.
+static mqtt_queue_index mqtt_queue_flash;
+// The oldest flash block, once loaded, and the next change in it to publish.
+static mqtt_queue_record mqtt_queue_block[MQTT_QUEUE_BLOCK_SIZE];
+static uint32_t mqtt_queue_block_len;
+static uint32_t mqtt_queue_block_pos;
+// The seq of the RAM change mqtt_queue_peek() returned.
+static uint32_t mqtt_queue_peek_seq;
+
+void mqtt_queue_register_conf() {
+    cm_conf_register_page(&mqtt_queue_page);
+}
+
+static void mqtt_queue_block_key(char *key, uint32_t block) {
+    snprintf(key, 8, "b%lu", block % MQTT_QUEUE_FLASH_BLOCKS);
+}
+
+// Must be called with mqtt_queue_lock held.
+static void mqtt_queue_update_depth() {
+    uint32_t flash = (mqtt_queue_flash.next - mqtt_queue_flash.first) *
+        MQTT_QUEUE_BLOCK_SIZE - mqtt_queue_block_pos;
+    mqtt_queue_cur_stats.depth_flash = flash;
+    mqtt_queue_cur_stats.depth =
+        flash + (mqtt_queue_ram_head - mqtt_queue_ram_tail);
+}
+
+void mqtt_queue_init() {
+    nvs_handle_t handle;
+    if (nvs_open(MQTT_QUEUE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+        return;
+    mqtt_queue_index index;
+    size_t size = sizeof(index);
+    esp_err_t err = nvs_get_blob(handle, MQTT_QUEUE_NVS_KEY_INDEX, &index,
+        &size);
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        if (err != ESP_ERR_NVS_NOT_FOUND)
+            ESP_LOGE(TAG, "index load: %s", esp_err_to_name(err));
+        return;
+    }
+    if (index.next - index.first > MQTT_QUEUE_FLASH_BLOCKS) {
+        ESP_LOGE(TAG, "index invalid: %lu..%lu", index.first, index.next);
+        return;
+    }
+
+    portENTER_CRITICAL(&mqtt_queue_lock);
+    mqtt_queue_flash = index;
+    mqtt_queue_update_depth();
+    portEXIT_CRITICAL(&mqtt_queue_lock);
+    if (index.next != index.first)
+        ESP_LOGI(TAG, "%lu blocks queued in flash", index.next - index.first);
+}
+
+void mqtt_queue_push(const mqtt_state &state) {
+    portENTER_CRITICAL(&mqtt_queue_lock);
+    if (mqtt_queue_ram_head - mqtt_queue_ram_tail == MQTT_QUEUE_RAM_SIZE) {
+        mqtt_queue_ram_tail++;
+        mqtt_queue_cur_stats.drops++;
+    }
+    mqtt_queue_ram[mqtt_queue_ram_head++ % MQTT_QUEUE_RAM_SIZE] = state;
+    mqtt_queue_update_depth();
+    portEXIT_CRITICAL(&mqtt_queue_lock);
+}
+
+static esp_err_t mqtt_queue_save_index(nvs_handle_t handle,
+    const mqtt_queue_index &index
+) {
+    esp_err_t err = nvs_set_blob(handle, MQTT_QUEUE_NVS_KEY_INDEX, &index,
+        sizeof(index));
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    return err;
+}
+
+// Erase the oldest flash block, whether or not it was published.
+static void mqtt_queue_discard_block() {
+    char key[8];
+    mqtt_queue_block_key(key, mqtt_queue_flash.first);
+    mqtt_queue_index index = mqtt_queue_flash;
+    index.first++;
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(MQTT_QUEUE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        nvs_erase_key(handle, key);
+        err = mqtt_queue_save_index(handle, index);
+        nvs_close(handle);
+    }
+    if (err != ESP_OK)
+        ESP_LOGE(TAG, "block discard: %s", esp_err_to_name(err));
+
+    // Even if NVS failed, so a bad block can't wedge the queue.
+    portENTER_CRITICAL(&mqtt_queue_lock);
+    mqtt_queue_flash = index;
+    mqtt_queue_block_len = 0;
+    mqtt_queue_block_pos = 0;
+    mqtt_queue_update_depth();
+    portEXIT_CRITICAL(&mqtt_queue_lock);
+}
+
+// Returns false if the block couldn't be read; it's then discarded.
+static bool mqtt_queue_load_block() {
+    char key[8];
+    mqtt_queue_block_key(key, mqtt_queue_flash.first);
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(MQTT_QUEUE_NVS_NAMESPACE, NVS_READONLY, &handle);
+    size_t size = sizeof(mqtt_queue_block);
+    if (err == ESP_OK) {
+        err = nvs_get_blob(handle, key, mqtt_queue_block, &size);
+        nvs_close(handle);
+    }
+    if (err == ESP_OK && size != sizeof(mqtt_queue_block))
+        err = ESP_ERR_INVALID_SIZE;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "block %lu load: %s", mqtt_queue_flash.first,
+            esp_err_to_name(err));
+        portENTER_CRITICAL(&mqtt_queue_lock);
+        mqtt_queue_cur_stats.drops += MQTT_QUEUE_BLOCK_SIZE;
+        portEXIT_CRITICAL(&mqtt_queue_lock);
+        mqtt_queue_discard_block();
+        return false;
+    }
+    mqtt_queue_block_len = MQTT_QUEUE_BLOCK_SIZE;
+    mqtt_queue_block_pos = 0;
+    return true;
+}
+
+bool mqtt_queue_peek(mqtt_state *state) {
+    // Flash holds the oldest changes.
+    while (mqtt_queue_flash.next != mqtt_queue_flash.first) {
+        if (!mqtt_queue_block_len && !mqtt_queue_load_block())
+            continue;
+        const mqtt_queue_record &r = mqtt_queue_block[mqtt_queue_block_pos];
+        *state = {
+            .rfid_status = (mqtt_rfid_status)r.rfid_status,
+            .rfid = r.rfid,
+            .boot = r.boot,
+            .seq = r.seq,
+            .time_ms = r.time_ms,
+            .decision_us = r.decision_us,
+        };
+        if (state->rfid_status >= MQTT_RFID_STATUS_NUM)
+            state->rfid_status = MQTT_RFID_STATUS_ERROR;
+        return true;
+    }
+
+    portENTER_CRITICAL(&mqtt_queue_lock);
+    bool found = mqtt_queue_ram_head != mqtt_queue_ram_tail;
+    if (found) {
+        *state = mqtt_queue_ram[mqtt_queue_ram_tail % MQTT_QUEUE_RAM_SIZE];
+        mqtt_queue_peek_seq = state->seq;
+    }
+    portEXIT_CRITICAL(&mqtt_queue_lock);
+    return found;
+}
+
+void mqtt_queue_pop() {
+    if (mqtt_queue_flash.next != mqtt_queue_flash.first) {
+        assert(mqtt_queue_block_len);
+        portENTER_CRITICAL(&mqtt_queue_lock);
+        mqtt_queue_block_pos++;
+        mqtt_queue_update_depth();
+        portEXIT_CRITICAL(&mqtt_queue_lock);
+        if (mqtt_queue_block_pos == mqtt_queue_block_len)
+            mqtt_queue_discard_block();
+        return;
+    }
+
+    portENTER_CRITICAL(&mqtt_queue_lock);
+    // Unless mqtt_queue_push() already dropped it to make room.
+    if (mqtt_queue_ram_head != mqtt_queue_ram_tail &&
+        mqtt_queue_ram[mqtt_queue_ram_tail % MQTT_QUEUE_RAM_SIZE].seq ==
+            mqtt_queue_peek_seq
+    ) {
+        mqtt_queue_ram_tail++;
+    }
+    mqtt_queue_update_depth();
+    portEXIT_CRITICAL(&mqtt_queue_lock);
+}
+
+void mqtt_queue_spill() {
+    if (!mqtt_queue_spill_enabled)
+        return;
+
+    static mqtt_queue_record records[MQTT_QUEUE_BLOCK_SIZE];
+    portENTER_CRITICAL(&mqtt_queue_lock);
+    uint32_t tail = mqtt_queue_ram_tail;
+    bool ready = mqtt_queue_ram_head - tail >= MQTT_QUEUE_BLOCK_SIZE;
+    if (ready) {
+        for (int i = 0; i < MQTT_QUEUE_BLOCK_SIZE; i++) {
+            const mqtt_state &s =
+                mqtt_queue_ram[(tail + i) % MQTT_QUEUE_RAM_SIZE];
+            records[i] = {
+                .boot = s.boot,
+                .seq = s.seq,
+                .rfid = s.rfid,
+                .time_ms = s.time_ms,
+                .decision_us = (int32_t)s.decision_us,
+                .rfid_status = s.rfid_status,
+            };
+        }
+    }
+    portEXIT_CRITICAL(&mqtt_queue_lock);
+    if (!ready)
+        return;
+
+    if (mqtt_queue_flash.next - mqtt_queue_flash.first ==
+        MQTT_QUEUE_FLASH_BLOCKS
+    ) {
+        portENTER_CRITICAL(&mqtt_queue_lock);
+        mqtt_queue_cur_stats.drops +=
+            MQTT_QUEUE_BLOCK_SIZE - mqtt_queue_block_pos;
+        portEXIT_CRITICAL(&mqtt_queue_lock);
+        mqtt_queue_discard_block();
+    }
+
+    char key[8];
+    mqtt_queue_block_key(key, mqtt_queue_flash.next);
+    mqtt_queue_index index = mqtt_queue_flash;
+    index.next++;
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(MQTT_QUEUE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, key, records, sizeof(records));
+        if (err == ESP_OK)
+            err = mqtt_queue_save_index(handle, index);
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        // The changes stay in RAM.
+        ESP_LOGE(TAG, "spill: %s", esp_err_to_name(err));
+        return;
+    }
+
+    portENTER_CRITICAL(&mqtt_queue_lock);
+    mqtt_queue_flash = index;
+    // mqtt_queue_push() may have dropped some of them meanwhile.
+    if ((int32_t)(mqtt_queue_ram_tail - (tail + MQTT_QUEUE_BLOCK_SIZE)) < 0)
+        mqtt_queue_ram_tail = tail + MQTT_QUEUE_BLOCK_SIZE;
+    mqtt_queue_cur_stats.spills++;
+    mqtt_queue_update_depth();
+    portEXIT_CRITICAL(&mqtt_queue_lock);
+    ESP_LOGI(TAG, "spilled block %lu", index.next - 1);
+}
+
+uint32_t mqtt_queue_depth() {
+    portENTER_CRITICAL(&mqtt_queue_lock);
+    uint32_t depth = mqtt_queue_cur_stats.depth;
+    portEXIT_CRITICAL(&mqtt_queue_lock);
+    return depth;
+}
+
+void mqtt_queue_get_stats(mqtt_queue_stats *stats) {
+    portENTER_CRITICAL(&mqtt_queue_lock);
+    *stats = mqtt_queue_cur_stats;
+    portEXIT_CRITICAL(&mqtt_queue_lock);
+}
@@ -0,0 +1,39 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Store-and-forward queue of status changes waiting to be published, so none
+// are lost while the broker is unreachable. Changes are held in RAM; if
+// flash spill is enabled, the oldest are moved to NVS in blocks once RAM is
+// half full, which also lets them survive a reboot. When full, the oldest
+// changes are dropped.
+//
+// mqtt_queue_push() may be called from any task; everything else is only for
+// mqtt_task.
+
+#include <stdint.h>
+
+#include "mqtt_format.h"
+
+struct mqtt_queue_stats {
+    uint32_t depth;       // Changes queued now, in RAM and flash
+    uint32_t depth_flash; // Of which in flash
+    uint32_t drops;       // Changes dropped because the queue was full
+    uint32_t spills;      // Blocks written to flash
+};
+
+extern void mqtt_queue_register_conf();
+// Loads the indices of any blocks spilled before the last reboot.
+extern void mqtt_queue_init();
+// Never blocks.
+extern void mqtt_queue_push(const mqtt_state &state);
+// The oldest queued change. Returns false if the queue is empty.
+extern bool mqtt_queue_peek(mqtt_state *state);
+// Remove the change mqtt_queue_peek() returned, once it's published.
+extern void mqtt_queue_pop();
+// Move changes to flash if spill is enabled and enough are in RAM. Call
+// while they can't be published.
+extern void mqtt_queue_spill();
+extern uint32_t mqtt_queue_depth();
+extern void mqtt_queue_get_stats(mqtt_queue_stats *stats);
@@ -0,0 +1,79 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "dispatch.h"
+#include "net_watch.h"
+
+static const char *TAG = "net_watch";
+
+static const uint64_t net_watch_poll_period_us = 250 * 1000;
+
+static esp_timer_handle_t net_watch_timer;
+static portMUX_TYPE net_watch_lock = portMUX_INITIALIZER_UNLOCKED;
+static net_watch_state net_watch_cur;
+
+// Network names are compared by pointer; fcch_connmgr replaces the string
+// when the configuration changes.
+static bool net_watch_equal(
+    const net_watch_state &a,
+    const net_watch_state &b
+) {
+    return a.ap.enabled == b.ap.enabled &&
+        a.ap.network == b.ap.network &&
+        a.ap.ip == b.ap.ip &&
+        a.sta.connected == b.sta.connected &&
+        a.sta.network == b.sta.network &&
+        a.sta.has_ip == b.sta.has_ip &&
+        a.sta.ip == b.sta.ip &&
+        a.mqtt.enabled == b.mqtt.enabled &&
+        a.mqtt.connected == b.mqtt.connected;
+}
+
+// Runs in the esp_timer task, which is the only writer of net_watch_cur.
+static void net_watch_poll(void *arg) {
+    net_watch_state state{
+        .ap = cm_net_get_ap_info(),
+        .sta = cm_net_get_sta_info(),
+        .mqtt = cm_mqtt_get_info(),
+    };
+    if (net_watch_equal(state, net_watch_cur))
+        return;
+
+    ESP_LOGI(TAG, "WiFi %s%s, MQTT %s",
+        state.sta.connected ? "connected" : "disconnected",
+        state.sta.has_ip ? " with IP" : "",
+        !state.mqtt.enabled ? "disabled" :
+            state.mqtt.connected ? "connected" : "disconnected");
+    portENTER_CRITICAL(&net_watch_lock);
+    net_watch_cur = state;
+    portEXIT_CRITICAL(&net_watch_lock);
+
+    dispatch_event ev{
+        .id = DISPATCH_EVENT_NET_CHANGED,
+        .dummy = 0,
+    };
+    dispatch_post(ev);
+}
+
+void net_watch_get(net_watch_state *state) {
+    portENTER_CRITICAL(&net_watch_lock);
+    *state = net_watch_cur;
+    portEXIT_CRITICAL(&net_watch_lock);
+}
+
+void net_watch_init() {
+    const esp_timer_create_args_t args = {
+        .callback = &net_watch_poll,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "net_watch",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &net_watch_timer));
+    ESP_ERROR_CHECK(
+        esp_timer_start_periodic(net_watch_timer, net_watch_poll_period_us));
+}
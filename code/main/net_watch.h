@@ -0,0 +1,23 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "fcch_connmgr/cm_mqtt.h"
+#include "fcch_connmgr/cm_net.h"
+
+// Network and MQTT connection state change notifications. fcch_connmgr
+// doesn't report changes, so its state is polled, which only compares a few
+// fields. When anything changes, a DISPATCH_EVENT_NET_CHANGED event is
+// posted; handlers registered for it call net_watch_get() for the new state.
+
+struct net_watch_state {
+    cm_net_ap_info ap;
+    cm_net_sta_info sta;
+    cm_mqtt_info mqtt;
+};
+
+// Call after all handlers are registered. Until the first poll, the state is
+// all zero (disconnected), so the first poll posts an event.
+extern void net_watch_init();
+extern void net_watch_get(net_watch_state *state);
@@ -3,11 +3,17 @@
 
 #include <driver/gpio.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <string.h>
 
 #include "app_config.h"
+#include "dispatch.h"
 #include "fcch_connmgr/cm.h"
+#include "fcch_connmgr/cm_conf.h"
+#include "fcch_connmgr/cm_util.h"
+#include "fcch_trace/trace.h"
+#include "latency.h"
 #include "relay.h"
 
 #if (ESP_MODULE == ESP_MODULE_IDEASPARK)
@@ -20,40 +26,151 @@
 
 // static const char *TAG = "relay";
 
+static uint16_t relay_fast_grant;
+static cm_conf_item relay_item_fast_grant = {
+    .slug_name = "fg", // Fast Grant
+    .text_name = "Fast Grant From Cached ACL Decision (0: no, other: yes)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &relay_fast_grant },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static cm_conf_item *relay_items[] = {
+    &relay_item_fast_grant,
+};
+
+static cm_conf_page relay_page = {
+    .slug_name = "r", // Relay
+    .text_name = "Relay",
+    .items = relay_items,
+    .items_count = ARRAY_SIZE(relay_items),
+};
+
+// The relay is driven from rfid_task (fast grant), the dispatch task and httpd
+// (toggle). relay_lock covers the level, the fast grant flag, the GPIO write
+// and the on time, so the GPIO always matches relay_level, and a fast grant
+// can't be revoked by a decision that raced with it.
+static portMUX_TYPE relay_lock = portMUX_INITIALIZER_UNLOCKED;
 static int relay_level = 0;
+// Set when the relay was turned on by the fast path, ahead of the ACL server's
+// decision, so that a subsequent denial or error turns it back off.
+static bool relay_fast_granted;
+// Total time the relay has been on, excluding the current on period, which
+// started at relay_on_since (0 while off).
+static int64_t relay_on_since;
+static int64_t relay_on_time_us;
+static portMUX_TYPE relay_fast_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static relay_fast_stats relay_fast_cur_stats;
 
-static void relay_write(int new_relay_level) {
+// Caller holds relay_lock.
+static void relay_write_locked(int new_relay_level, bool fast_granted) {
     relay_level = new_relay_level;
+    relay_fast_granted = fast_granted;
     ESP_ERROR_CHECK(gpio_set_level(RELAY_GPIO, relay_level));
+
+    int64_t now = esp_timer_get_time();
+    if (relay_level && !relay_on_since) {
+        relay_on_since = now;
+    } else if (!relay_level && relay_on_since) {
+        relay_on_time_us += now - relay_on_since;
+        relay_on_since = 0;
+    }
+}
+
+static void relay_write(int new_relay_level, bool fast_granted) {
+    portENTER_CRITICAL(&relay_lock);
+    relay_write_locked(new_relay_level, fast_granted);
+    portEXIT_CRITICAL(&relay_lock);
+    trace(TRACE_ID_RELAY, new_relay_level);
 }
 
 static void relay_http_action_toggle() {
-    relay_write(!relay_level);
+    portENTER_CRITICAL(&relay_lock);
+    int new_relay_level = !relay_level;
+    relay_write_locked(new_relay_level, relay_fast_granted);
+    portEXIT_CRITICAL(&relay_lock);
+    trace(TRACE_ID_RELAY, new_relay_level);
 }
 
 static const char *relay_http_action_toggle_description() {
-    if (relay_level) {
+    portENTER_CRITICAL(&relay_lock);
+    int level = relay_level;
+    portEXIT_CRITICAL(&relay_lock);
+    if (level) {
         return "Toggle Relay (Is On)";
     } else {
         return "Toggle Relay (Is Off)";
     }
 }
 
+static void relay_on_event_rfid_ok(const dispatch_event &ev) {
+    relay_write(1, false);
+    latency_stamp_relay();
+}
+
+static void relay_on_event_rfid_revoke(const dispatch_event &ev) {
+    portENTER_CRITICAL(&relay_lock);
+    bool revoke = relay_fast_granted;
+    if (revoke)
+        relay_write_locked(0, false);
+    portEXIT_CRITICAL(&relay_lock);
+    if (revoke)
+        trace(TRACE_ID_RELAY, 0);
+}
+
+static void relay_on_event_rfid_none(const dispatch_event &ev) {
+    relay_write(0, false);
+}
+
+void relay_register_conf() {
+    cm_conf_register_page(&relay_page);
+}
+
 void relay_init() {
     ESP_ERROR_CHECK(gpio_reset_pin(RELAY_GPIO));
     ESP_ERROR_CHECK(gpio_set_direction(RELAY_GPIO, GPIO_MODE_OUTPUT));
-    relay_on_rfid_none();
+    relay_write(0, false);
     cm_http_register_home_action(
         "toggle-relay",
         relay_http_action_toggle_description,
         relay_http_action_toggle
     );
+    dispatch_register(DISPATCH_EVENT_RFID_OK, relay_on_event_rfid_ok);
+    dispatch_register(DISPATCH_EVENT_RFID_ERR, relay_on_event_rfid_revoke);
+    dispatch_register(DISPATCH_EVENT_RFID_BAD, relay_on_event_rfid_revoke);
+    dispatch_register(DISPATCH_EVENT_RFID_NONE, relay_on_event_rfid_none);
+}
+
+bool relay_fast_grant_enabled() {
+    return relay_fast_grant != 0;
+}
+
+void relay_on_fast_grant(int64_t rx_time) {
+    relay_write(1, true);
+    int64_t latency = esp_timer_get_time() - rx_time;
+    latency_record(LATENCY_STAGE_FAST_GRANT, latency);
+
+    portENTER_CRITICAL(&relay_fast_stats_lock);
+    relay_fast_stats &stats = relay_fast_cur_stats;
+    stats.grants++;
+    stats.latency_us_last = latency;
+    if (latency > stats.latency_us_max)
+        stats.latency_us_max = latency;
+    portEXIT_CRITICAL(&relay_fast_stats_lock);
 }
 
-void relay_on_rfid_ok() {
-    relay_write(1);
+int64_t relay_get_on_time_us() {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&relay_lock);
+    int64_t ret = relay_on_time_us;
+    if (relay_on_since)
+        ret += now - relay_on_since;
+    portEXIT_CRITICAL(&relay_lock);
+    return ret;
 }
 
-void relay_on_rfid_none() {
-    relay_write(0);
+void relay_get_fast_stats(relay_fast_stats *stats) {
+    portENTER_CRITICAL(&relay_fast_stats_lock);
+    *stats = relay_fast_cur_stats;
+    portEXIT_CRITICAL(&relay_fast_stats_lock);
 }
@@ -1,8 +1,23 @@
-// Copyright 2024-2025 Stephen Warren <swarren@wwwdotorg.org>
+// Copyright 2024-2026 Stephen Warren <swarren@wwwdotorg.org>
 // SPDX-License-Identifier: MIT
 
 #pragma once
 
+#include <stdint.h>
+
+struct relay_fast_stats {
+    uint32_t grants;
+    // Time from rfid_task receiving the card's UART data to the relay GPIO
+    // being driven.
+    int64_t latency_us_last;
+    int64_t latency_us_max;
+};
+
+extern void relay_register_conf();
 extern void relay_init();
-extern void relay_on_rfid_ok();
-extern void relay_on_rfid_none();
+extern bool relay_fast_grant_enabled();
+// Drive the relay on immediately, from rfid_task, ahead of the ACL decision.
+extern void relay_on_fast_grant(int64_t rx_time);
+extern void relay_get_fast_stats(relay_fast_stats *stats);
+// Total time the relay has been on since boot.
+extern int64_t relay_get_on_time_us();
@@ -0,0 +1,55 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Fixed-capacity lock-free single-producer single-consumer ring. Exactly one
+// task may call push() and exactly one (other) task may call pop().
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "N must be a power of 2");
+
+    // Free-running indices; wrap naturally at 2^32. head is written only by
+    // the producer, tail only by the consumer.
+    std::atomic<uint32_t> m_head{0};
+    std::atomic<uint32_t> m_tail{0};
+    T m_items[N];
+
+public:
+    // Returns false, without modifying the ring, if it's full.
+    bool push(const T &item) {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        uint32_t tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail >= N)
+            return false;
+        m_items[head & (N - 1)] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false if the ring is empty.
+    bool pop(T *item) {
+        uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        uint32_t head = m_head.load(std::memory_order_acquire);
+        if (head == tail)
+            return false;
+        *item = m_items[tail & (N - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently with push() or pop().
+    uint32_t size() const {
+        return m_head.load(std::memory_order_acquire) -
+            m_tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr uint32_t capacity() {
+        return N;
+    }
+};
@@ -0,0 +1,291 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <string.h>
+#include <sys/param.h>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "fcch_connmgr/cm.h"
+#include "fcch_connmgr/cm_conf.h"
+#include "fcch_connmgr/cm_util.h"
+#include "stall.h"
+
+static const char *TAG = "stall";
+
+static const uint16_t stall_default_budget_ms = 500;
+// How often work in progress is checked against the budget.
+static const uint64_t stall_check_period_us = 100 * 1000;
+
+static uint16_t stall_budget_ms;
+static cm_conf_item stall_item_budget_ms = {
+    .slug_name = "b", // Budget
+    .text_name = "Handler Time Budget (ms, 0 for 500)",
+    .type = CM_CONF_ITEM_TYPE_U16,
+    .p_val = {.u16 = &stall_budget_ms },
+    .default_func = &cm_conf_default_u16_0,
+};
+
+static cm_conf_item *stall_items[] = {
+    &stall_item_budget_ms,
+};
+
+static cm_conf_page stall_page = {
+    .slug_name = "sw", // Stall Watchdog
+    .text_name = "Stall Watchdog",
+    .items = stall_items,
+    .items_count = ARRAY_SIZE(stall_items),
+};
+
+// Bucket n holds durations in [2^(n-1), 2^n) us; bucket 0 holds 0us. The last
+// bucket also holds anything longer.
+#define STALL_HIST_BUCKETS 25
+#define STALL_WARNINGS_LEN 4
+
+struct stall_loop {
+    const char *name;
+    bool active;
+    bool warned;
+    uint32_t tag;
+    int64_t start;
+    uint32_t count;
+    uint32_t over_budget;
+    uint32_t us_max;
+    uint32_t hist[STALL_HIST_BUCKETS];
+};
+
+static portMUX_TYPE stall_lock = portMUX_INITIALIZER_UNLOCKED;
+static stall_loop stall_loops[STALL_ID_NUM] = {
+    [STALL_ID_RFID] = { .name = "rfid" },
+    [STALL_ID_DISPATCH] = { .name = "dispatch" },
+    [STALL_ID_LCD] = { .name = "lcd" },
+    [STALL_ID_MQTT] = { .name = "mqtt" },
+};
+static stall_warning stall_warnings[STALL_WARNINGS_LEN];
+static uint32_t stall_warnings_head;
+static uint32_t stall_warnings_count;
+static stall_callback_warning *stall_cb_warning;
+static esp_timer_handle_t stall_check_timer;
+
+static uint32_t stall_budget_us() {
+    uint16_t ms = stall_budget_ms ? stall_budget_ms : stall_default_budget_ms;
+    return (uint32_t)ms * 1000;
+}
+
+static int stall_bucket(uint32_t us) {
+    int bucket = 0;
+    while (us && bucket < STALL_HIST_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static uint32_t stall_bucket_limit_us(int bucket) {
+    return bucket ? (1UL << bucket) - 1 : 0;
+}
+
+// Must be called with stall_lock held. If the queue is full, the oldest
+// warning is discarded; the newest is the most useful.
+static void stall_queue_warning(const stall_warning &warning) {
+    uint32_t idx;
+    if (stall_warnings_count < STALL_WARNINGS_LEN) {
+        idx = (stall_warnings_head + stall_warnings_count) % STALL_WARNINGS_LEN;
+        stall_warnings_count++;
+    } else {
+        idx = stall_warnings_head;
+        stall_warnings_head = (stall_warnings_head + 1) % STALL_WARNINGS_LEN;
+    }
+    stall_warnings[idx] = warning;
+}
+
+// Must be called with stall_lock held. Returns false if the loop's in-progress
+// warning has already been popped (or discarded).
+static bool stall_complete_warning(stall_id id, uint32_t duration_us) {
+    for (uint32_t i = 0; i < stall_warnings_count; i++) {
+        stall_warning &w =
+            stall_warnings[(stall_warnings_head + i) % STALL_WARNINGS_LEN];
+        if (w.id == id && w.in_progress) {
+            w.duration_us = duration_us;
+            w.in_progress = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void stall_warn(const stall_warning &warning) {
+    ESP_LOGW(TAG, "%s: tag %lu %s %lu us (budget %lu us)",
+        stall_loops[warning.id].name, warning.tag,
+        warning.in_progress ? "running for" : "took",
+        warning.duration_us, warning.budget_us);
+    if (stall_cb_warning != nullptr)
+        stall_cb_warning();
+}
+
+void stall_enter(stall_id id, uint32_t tag) {
+    assert(id < STALL_ID_NUM);
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&stall_lock);
+    stall_loop &loop = stall_loops[id];
+    loop.active = true;
+    loop.warned = false;
+    loop.tag = tag;
+    loop.start = now;
+    portEXIT_CRITICAL(&stall_lock);
+}
+
+void stall_exit(stall_id id) {
+    assert(id < STALL_ID_NUM);
+    int64_t now = esp_timer_get_time();
+    uint32_t budget_us = stall_budget_us();
+    bool over;
+    bool warned;
+    bool updated = false;
+    uint32_t tag;
+    stall_warning warning{};
+
+    portENTER_CRITICAL(&stall_lock);
+    stall_loop &loop = stall_loops[id];
+    uint32_t us = (uint32_t)MIN(now - loop.start, (int64_t)UINT32_MAX);
+    loop.active = false;
+    loop.count++;
+    if (us > loop.us_max)
+        loop.us_max = us;
+    loop.hist[stall_bucket(us)]++;
+    over = us > budget_us;
+    // A unit already reported as stuck gets no second warning; its pending
+    // report, if any, is given the final duration.
+    warned = loop.warned;
+    tag = loop.tag;
+    if (over)
+        loop.over_budget++;
+    if (warned) {
+        updated = stall_complete_warning(id, us);
+    } else if (over) {
+        warning = {
+            .id = id,
+            .tag = loop.tag,
+            .duration_us = us,
+            .budget_us = budget_us,
+            .in_progress = false,
+        };
+        stall_queue_warning(warning);
+    }
+    portEXIT_CRITICAL(&stall_lock);
+
+    if (warned) {
+        ESP_LOGI(TAG, "%s: tag %lu finished after %lu us%s",
+            stall_loops[id].name, tag, us,
+            updated ? "" : " (in-progress warning no longer queued)");
+    } else if (over) {
+        stall_warn(warning);
+    }
+}
+
+static void stall_check(void *arg) {
+    int64_t now = esp_timer_get_time();
+    uint32_t budget_us = stall_budget_us();
+
+    for (int i = 0; i < STALL_ID_NUM; i++) {
+        bool stuck = false;
+        stall_warning warning{};
+
+        portENTER_CRITICAL(&stall_lock);
+        stall_loop &loop = stall_loops[i];
+        if (loop.active && !loop.warned && now - loop.start > budget_us) {
+            loop.warned = true;
+            stuck = true;
+            warning = {
+                .id = (stall_id)i,
+                .tag = loop.tag,
+                .duration_us = (uint32_t)(now - loop.start),
+                .budget_us = budget_us,
+                .in_progress = true,
+            };
+            stall_queue_warning(warning);
+        }
+        portEXIT_CRITICAL(&stall_lock);
+
+        if (stuck)
+            stall_warn(warning);
+    }
+}
+
+const char *stall_name(stall_id id) {
+    assert(id < STALL_ID_NUM);
+    return stall_loops[id].name;
+}
+
+void stall_get_stats(stall_id id, stall_stats *stats) {
+    assert(id < STALL_ID_NUM);
+    uint32_t hist[STALL_HIST_BUCKETS];
+
+    portENTER_CRITICAL(&stall_lock);
+    const stall_loop &loop = stall_loops[id];
+    stats->count = loop.count;
+    stats->over_budget = loop.over_budget;
+    stats->us_max = loop.us_max;
+    memcpy(hist, loop.hist, sizeof(hist));
+    portEXIT_CRITICAL(&stall_lock);
+
+    stats->us_p50 = 0;
+    stats->us_p99 = 0;
+    uint32_t p50_rank = (stats->count + 1) / 2;
+    uint32_t p99_rank = stats->count - stats->count / 100;
+    uint32_t seen = 0;
+    for (int bucket = 0; bucket < STALL_HIST_BUCKETS; bucket++) {
+        uint32_t prev = seen;
+        seen += hist[bucket];
+        if (prev < p50_rank && seen >= p50_rank)
+            stats->us_p50 = stall_bucket_limit_us(bucket);
+        if (prev < p99_rank && seen >= p99_rank)
+            stats->us_p99 = stall_bucket_limit_us(bucket);
+    }
+    // The top bucket is open-ended; the max is a tighter bound.
+    stats->us_p50 = MIN(stats->us_p50, stats->us_max);
+    stats->us_p99 = MIN(stats->us_p99, stats->us_max);
+}
+
+bool stall_pop_warning(stall_warning *warning) {
+    bool popped = false;
+    portENTER_CRITICAL(&stall_lock);
+    if (stall_warnings_count) {
+        *warning = stall_warnings[stall_warnings_head];
+        stall_warnings_head = (stall_warnings_head + 1) % STALL_WARNINGS_LEN;
+        stall_warnings_count--;
+        popped = true;
+    }
+    portEXIT_CRITICAL(&stall_lock);
+    return popped;
+}
+
+uint32_t stall_get_pending_warnings() {
+    portENTER_CRITICAL(&stall_lock);
+    uint32_t ret = stall_warnings_count;
+    portEXIT_CRITICAL(&stall_lock);
+    return ret;
+}
+
+void stall_set_callback_warning(stall_callback_warning *cb) {
+    stall_cb_warning = cb;
+}
+
+void stall_register_conf() {
+    cm_conf_register_page(&stall_page);
+}
+
+void stall_init() {
+    const esp_timer_create_args_t args = {
+        .callback = &stall_check,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "stall",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &stall_check_timer));
+    ESP_ERROR_CHECK(
+        esp_timer_start_periodic(stall_check_timer, stall_check_period_us));
+}
@@ -0,0 +1,58 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+// Stall detector. Each monitored loop brackets one unit of work with
+// stall_enter()/stall_exit(). Durations feed per-loop statistics, and any unit
+// of work that exceeds the configured budget raises one warning, either when
+// it finally completes or, if it's stuck, while still in progress. A stuck
+// unit's warning gets its final duration if it's still queued at completion.
+
+enum stall_id {
+    STALL_ID_RFID,     // Present callback in rfid_task; tag: dispatch_event_id
+    STALL_ID_DISPATCH, // One event in the dispatch task; tag: dispatch_event_id
+    STALL_ID_LCD,      // One redraw; tag: LCD page
+    STALL_ID_MQTT,     // One round of publishing; tag: stall_mqtt_tag
+    STALL_ID_NUM,
+};
+
+enum stall_mqtt_tag {
+    STALL_MQTT_TAG_STATE,
+    STALL_MQTT_TAG_PERIODIC,
+};
+
+struct stall_stats {
+    uint32_t count;
+    uint32_t over_budget;
+    uint32_t us_max;
+    // Upper bound of the histogram bucket containing the percentile.
+    uint32_t us_p50;
+    uint32_t us_p99;
+};
+
+struct stall_warning {
+    stall_id id;
+    uint32_t tag;
+    uint32_t duration_us;
+    uint32_t budget_us;
+    // The work hadn't completed when the warning was raised, or by the time
+    // it was popped.
+    bool in_progress;
+};
+
+// Called, from any task, when a warning is queued. Must not block.
+typedef void stall_callback_warning();
+
+extern void stall_register_conf();
+extern void stall_init();
+extern void stall_set_callback_warning(stall_callback_warning *cb);
+extern void stall_enter(stall_id id, uint32_t tag);
+extern void stall_exit(stall_id id);
+extern const char *stall_name(stall_id id);
+extern void stall_get_stats(stall_id id, stall_stats *stats);
+// Returns false if no warning is queued.
+extern bool stall_pop_warning(stall_warning *warning);
+extern uint32_t stall_get_pending_warnings();
@@ -0,0 +1,300 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+#include <time.h>
+
+#include <esp_heap_caps.h>
+#include <esp_http_server.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "dispatch.h"
+#include "fcch_acl_client/acl_client.h"
+#include "fcch_connmgr/cm.h"
+#include "fcch_connmgr/cm_util.h"
+#include "fcch_rfid/rfid.h"
+#include "latency.h"
+#include "lcd.h"
+#include "logsink.h"
+#include "mqtt.h"
+#include "mqtt_queue.h"
+#include "status.h"
+#include "tasks.h"
+#include "timesync.h"
+
+// GET /status: a plain text summary of runtime health. It's rendered into a
+// static buffer, and every value is a snapshot taken under (at most) a short
+// spinlock, so viewing it never allocates or blocks the swipe path. The HTTP
+// server runs one handler at a time, so the buffer needs no lock.
+
+#define STATUS_DECISIONS 8
+#define STATUS_BUF_SIZE 3072
+
+struct status_decision {
+    int64_t time_us;
+    // Wall clock time, or -1 if not synchronized.
+    int64_t time_ms;
+    // UART data to decision, or -1 if not timed.
+    int64_t decision_us;
+    uint32_t rfid;
+    dispatch_event_id result;
+    bool from_cache;
+};
+
+static portMUX_TYPE status_lock = portMUX_INITIALIZER_UNLOCKED;
+static status_decision status_decisions[STATUS_DECISIONS];
+static uint32_t status_decisions_next;
+static uint32_t status_decisions_count;
+static status_decision_counts status_counts;
+
+static char status_buf[STATUS_BUF_SIZE];
+static int status_buf_len;
+
+void status_record_decision(
+    uint32_t rfid,
+    dispatch_event_id result,
+    bool from_cache
+) {
+    int64_t now = esp_timer_get_time();
+    int64_t time_ms;
+    if (!timesync_get_time_ms(&time_ms))
+        time_ms = -1;
+    int64_t decision_us = latency_get_decision_us();
+    portENTER_CRITICAL(&status_lock);
+    status_decisions[status_decisions_next] = {
+        .time_us = now,
+        .time_ms = time_ms,
+        .decision_us = decision_us,
+        .rfid = rfid,
+        .result = result,
+        .from_cache = from_cache,
+    };
+    status_decisions_next = (status_decisions_next + 1) % STATUS_DECISIONS;
+    if (status_decisions_count < STATUS_DECISIONS)
+        status_decisions_count++;
+    switch (result) {
+    case DISPATCH_EVENT_RFID_OK:
+        status_counts.grants++;
+        break;
+    case DISPATCH_EVENT_RFID_BAD:
+        status_counts.denials++;
+        break;
+    default:
+        status_counts.errors++;
+        break;
+    }
+    if (from_cache)
+        status_counts.from_cache++;
+    portEXIT_CRITICAL(&status_lock);
+}
+
+void status_get_decision_counts(status_decision_counts *counts) {
+    portENTER_CRITICAL(&status_lock);
+    *counts = status_counts;
+    portEXIT_CRITICAL(&status_lock);
+}
+
+// Truncates silently if the buffer fills; STATUS_BUF_SIZE has ample margin.
+__attribute__((format(printf, 1, 2)))
+static void status_printf(const char *fmt, ...) {
+    int space = sizeof(status_buf) - status_buf_len;
+    if (space <= 1)
+        return;
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(status_buf + status_buf_len, space, fmt, ap);
+    va_end(ap);
+    if (len > 0)
+        status_buf_len += MIN(len, space - 1);
+}
+
+static const char *status_result_name(dispatch_event_id result) {
+    switch (result) {
+    case DISPATCH_EVENT_RFID_OK:
+        return "grant";
+    case DISPATCH_EVENT_RFID_BAD:
+        return "deny";
+    case DISPATCH_EVENT_RFID_ERR:
+        return "error";
+    default:
+        return "?";
+    }
+}
+
+static void status_render_system(int64_t now) {
+    uint32_t uptime_s = now / 1000000;
+    status_printf("uptime: %lud %02lu:%02lu:%02lu\n",
+        uptime_s / 86400, (uptime_s / 3600) % 24, (uptime_s / 60) % 60,
+        uptime_s % 60);
+    status_printf("heap: free %u, min free %u, largest block %u\n",
+        heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+        heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+
+    status_printf("\nstack free (bytes):\n");
+    for (int i = 0; i < TASKS_ID_NUM; i++) {
+        tasks_id id = (tasks_id)i;
+        uint32_t stack_free = tasks_get_stack_free(id);
+        const char *name = tasks_get_config(id)->name;
+        if (stack_free == UINT32_MAX)
+            status_printf("  %-8s not running\n", name);
+        else
+            status_printf("  %-8s %lu%s\n", name, stack_free,
+                tasks_stack_low(stack_free) ? " LOW" : "");
+    }
+}
+
+static void status_render_dispatch() {
+    dispatch_stats stats;
+    dispatch_get_stats(&stats);
+    status_printf("\ndispatch:\n");
+    status_printf("  queue: depth %lu, max %lu, coalesced %lu, dropped %lu\n",
+        stats.queue_depth, stats.queue_hwm, stats.queue_coalesced,
+        stats.queue_drops);
+    status_printf("  presence ring: depth %lu, max %lu, dropped %lu\n",
+        stats.presence_depth, stats.presence_hwm, stats.presence_overflows);
+    status_printf("  events %lu, latency max %lu us, handler max %lu us\n",
+        stats.events, (uint32_t)stats.latency_us_max,
+        (uint32_t)stats.handler_us_max);
+    status_printf("  lcd coalesced %lu, mqtt pending %lu\n",
+        lcd_get_coalesced(), mqtt_get_pending());
+}
+
+static void status_render_mqtt() {
+    mqtt_stats stats;
+    mqtt_get_stats(&stats);
+    status_printf("\nmqtt status:\n");
+    status_printf("  status %lu, heartbeat %lu, stats %lu (unchanged %lu)\n",
+        stats.status_msgs, stats.heartbeat_msgs, stats.stats_msgs,
+        stats.stats_unchanged);
+    status_printf("  bytes %lu, bytes saved %lu\n",
+        stats.bytes, stats.bytes_saved);
+    mqtt_queue_stats queue_stats;
+    mqtt_queue_get_stats(&queue_stats);
+    status_printf("  queue: depth %lu (flash %lu), dropped %lu, "
+        "flash writes %lu\n",
+        queue_stats.depth, queue_stats.depth_flash, queue_stats.drops,
+        queue_stats.spills);
+}
+
+static void status_render_lcd() {
+    lcd_stats stats;
+    lcd_get_stats(&stats);
+    uint32_t avg_us = stats.frames ?
+        (uint32_t)(stats.frame_us_sum / stats.frames) : 0;
+    uint32_t avg_bytes = stats.frames ?
+        (uint32_t)(stats.spi_bytes / stats.frames) : 0;
+    status_printf("\nlcd:\n");
+    status_printf("  frames %lu, avg %lu us, max %lu us, avg %lu SPI bytes\n",
+        stats.frames, avg_us, stats.frame_us_max, avg_bytes);
+    status_printf("  bands: sent %lu, unchanged %lu\n",
+        stats.bands_sent, stats.bands_skipped);
+    status_printf("  power: %s; on %lu s, dim %lu s, sleep %lu s\n",
+        lcd_power_state_name(stats.power),
+        (uint32_t)(stats.power_us[LCD_POWER_ON] / 1000000),
+        (uint32_t)(stats.power_us[LCD_POWER_DIM] / 1000000),
+        (uint32_t)(stats.power_us[LCD_POWER_SLEEP] / 1000000));
+}
+
+static void status_render_acl() {
+    acl_client_stats stats;
+    acl_client_get_stats(&stats);
+    uint32_t avg_ms = stats.requests ?
+        (uint32_t)(stats.latency_us_sum / stats.requests / 1000) : 0;
+    uint32_t hit_pct = stats.cache_lookups ?
+        (uint32_t)((stats.cache_hits * 100ULL) / stats.cache_lookups) : 0;
+    status_printf("\nacl:\n");
+    status_printf("  requests %lu, errors %lu, avg %lu ms, max %lu ms\n",
+        stats.requests, stats.errors, avg_ms,
+        (uint32_t)(stats.latency_us_max / 1000));
+    status_printf("  cache: lookups %lu, hits %lu (%lu%%)\n",
+        stats.cache_lookups, stats.cache_hits, hit_pct);
+}
+
+static void status_render_rfid() {
+    rfid_stats stats;
+    rfid_get_stats(&stats);
+    status_printf("\nrfid reader:\n");
+    status_printf("  frames %lu, crc errors %lu, framing errors %lu, "
+        "timeouts %lu, presentations %lu\n",
+        stats.frames, stats.crc_errors, stats.framing_errors,
+        stats.timeouts, stats.presentations);
+}
+
+static void status_render_log() {
+    logsink_stats stats;
+    logsink_get_stats(&stats);
+    status_printf("\nlogging:\n");
+    status_printf("  lines %lu, rate limited %lu, buffer full %lu\n",
+        stats.lines, stats.rate_limited, stats.overflows);
+    status_printf("  lines from tags beyond the rate limit table %lu\n",
+        stats.tag_overflows);
+    status_printf("  syslog: sent %lu, errors %lu\n",
+        stats.forwarded, stats.forward_errors);
+}
+
+static void status_render_decisions(int64_t now) {
+    status_decision decisions[STATUS_DECISIONS];
+    portENTER_CRITICAL(&status_lock);
+    uint32_t count = status_decisions_count;
+    uint32_t next = status_decisions_next;
+    memcpy(decisions, status_decisions, sizeof(decisions));
+    portEXIT_CRITICAL(&status_lock);
+
+    status_printf("\nlast decisions (newest first):\n");
+    if (!count)
+        status_printf("  none\n");
+    for (uint32_t i = 0; i < count; i++) {
+        const status_decision &d =
+            decisions[(next + STATUS_DECISIONS - 1 - i) % STATUS_DECISIONS];
+        char wall[32] = "time not synchronized";
+        if (d.time_ms >= 0) {
+            time_t t = d.time_ms / 1000;
+            struct tm tm;
+            gmtime_r(&t, &tm);
+            size_t len = strftime(wall, sizeof(wall), "%Y-%m-%dT%H:%M:%S",
+                &tm);
+            snprintf(wall + len, sizeof(wall) - len, ".%03luZ",
+                (uint32_t)(d.time_ms % 1000));
+        }
+        char latency[16] = "";
+        if (d.decision_us >= 0)
+            snprintf(latency, sizeof(latency), " %lu ms",
+                (uint32_t)(d.decision_us / 1000));
+        status_printf("  %6lus ago  %-24s  %10lu  %s%s%s\n",
+            (uint32_t)((now - d.time_us) / 1000000), wall, d.rfid,
+            status_result_name(d.result), latency,
+            d.from_cache ? " (cached)" : "");
+    }
+}
+
+static esp_err_t status_http_handler(httpd_req_t *req) {
+    int64_t now = esp_timer_get_time();
+    status_buf_len = 0;
+    status_render_system(now);
+    status_render_dispatch();
+    status_render_mqtt();
+    status_render_lcd();
+    status_render_acl();
+    status_render_rfid();
+    status_render_log();
+    status_render_decisions(now);
+
+    httpd_resp_set_type(req, "text/plain");
+    return httpd_resp_send(req, status_buf, status_buf_len);
+}
+
+static const httpd_uri_t status_http_uri = {
+    .uri = "/status",
+    .method = HTTP_GET,
+    .handler = status_http_handler,
+    .user_ctx = NULL,
+};
+
+void status_init() {
+    cm_http_register_uri_handler(&status_http_uri);
+}
@@ -0,0 +1,26 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+#include "dispatch.h"
+
+// All monotonically increasing since boot.
+struct status_decision_counts {
+    uint32_t grants;
+    uint32_t denials;
+    uint32_t errors;
+    uint32_t from_cache; // Grants and denials made from the decision cache
+};
+
+extern void status_init();
+// result is DISPATCH_EVENT_RFID_OK, _BAD or _ERR. from_cache is set if the
+// ACL server couldn't be reached and a cached decision was used.
+extern void status_record_decision(
+    uint32_t rfid,
+    dispatch_event_id result,
+    bool from_cache
+);
+extern void status_get_decision_counts(status_decision_counts *counts);
@@ -0,0 +1,289 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <esp_heap_caps.h>
+#include <esp_http_server.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fcch_connmgr/cm.h"
+#include "fcch_rfid/rfid.h"
+#include "tasks.h"
+
+static const char *TAG = "tasks";
+
+// Cores and priorities come from Kconfig ("FCCH RFID task layout"). The
+// defaults put the RFID reader (which also drives the relay on a fast grant)
+// and the dispatch task (ACL query, relay) on core 1, away from WiFi/lwIP on
+// core 0, and above the LCD and MQTT tasks, which only report state.
+#define TASKS_CORE(c) (((c) < 0) ? tskNO_AFFINITY : (BaseType_t)(c))
+
+// Stack sizes, in bytes. Re-derive these from the /tasks stack column after a
+// synthetic load run (see README.md) whenever a task's work changes: size =
+// used + TASKS_STACK_MARGIN, rounded up to 256. Measured with
+// host/sim/scenarios/stack_load.txt; used: dispatch 4247, mqtt 3991, lcd 3799,
+// loadgen 3159, log 3607.
+#define TASKS_STACK_DISPATCH 4864
+#define TASKS_STACK_MQTT 4608
+#define TASKS_STACK_LCD 4352
+#define TASKS_STACK_LOADGEN 3840
+#define TASKS_STACK_LOG 4352
+
+// A task whose minimum free stack drops below this is reported at boot and
+// in the periodic MQTT task stats.
+#define TASKS_STACK_MARGIN 512
+
+// Long-lived tasks use static storage, so they're accounted for at link time
+// and can't fail or fragment the heap at boot.
+static StackType_t tasks_stack_dispatch[TASKS_STACK_DISPATCH];
+static StaticTask_t tasks_tcb_dispatch;
+static StackType_t tasks_stack_mqtt[TASKS_STACK_MQTT];
+static StaticTask_t tasks_tcb_mqtt;
+static StackType_t tasks_stack_lcd[TASKS_STACK_LCD];
+static StaticTask_t tasks_tcb_lcd;
+static StackType_t tasks_stack_log[TASKS_STACK_LOG];
+static StaticTask_t tasks_tcb_log;
+
+static const tasks_config tasks_configs[TASKS_ID_NUM] = {
+    // Created, with static storage, by the fcch_rfid component.
+    [TASKS_ID_RFID] = {
+        .name = "rfid",
+        .stack_size = RFID_TASK_STACK_SIZE,
+        .priority = CONFIG_FCCH_TASK_RFID_PRIORITY,
+        .core = TASKS_CORE(CONFIG_FCCH_TASK_RFID_CORE),
+        .stack = nullptr,
+        .tcb = nullptr,
+    },
+    // Runs the ACL HTTP client, so needs a little more stack than the main
+    // esp_event loop task it replaced. Not named "main", which is app_main's
+    // task.
+    [TASKS_ID_DISPATCH] = {
+        .name = "dispatch",
+        .stack_size = TASKS_STACK_DISPATCH,
+        .priority = CONFIG_FCCH_TASK_DISPATCH_PRIORITY,
+        .core = TASKS_CORE(CONFIG_FCCH_TASK_DISPATCH_CORE),
+        .stack = tasks_stack_dispatch,
+        .tcb = &tasks_tcb_dispatch,
+    },
+    [TASKS_ID_MQTT] = {
+        .name = "mqtt",
+        .stack_size = TASKS_STACK_MQTT,
+        .priority = CONFIG_FCCH_TASK_MQTT_PRIORITY,
+        .core = TASKS_CORE(CONFIG_FCCH_TASK_MQTT_CORE),
+        .stack = tasks_stack_mqtt,
+        .tcb = &tasks_tcb_mqtt,
+    },
+    [TASKS_ID_LCD] = {
+        .name = "lcd",
+        .stack_size = TASKS_STACK_LCD,
+        .priority = CONFIG_FCCH_TASK_LCD_PRIORITY,
+        .core = TASKS_CORE(CONFIG_FCCH_TASK_LCD_CORE),
+        .stack = tasks_stack_lcd,
+        .tcb = &tasks_tcb_lcd,
+    },
+    // Only exists while a synthetic load runs, so it comes from the heap
+    // rather than permanently reserving its stack.
+    [TASKS_ID_LOADGEN] = {
+        .name = "loadgen",
+        .stack_size = TASKS_STACK_LOADGEN,
+        .priority = CONFIG_FCCH_TASK_LOADGEN_PRIORITY,
+        .core = TASKS_CORE(CONFIG_FCCH_TASK_LOADGEN_CORE),
+        .stack = nullptr,
+        .tcb = nullptr,
+    },
+    // Writes out buffered log output; lowest priority, so logging never
+    // delays card handling.
+    [TASKS_ID_LOG] = {
+        .name = "log",
+        .stack_size = TASKS_STACK_LOG,
+        .priority = CONFIG_FCCH_TASK_LOG_PRIORITY,
+        .core = TASKS_CORE(CONFIG_FCCH_TASK_LOG_CORE),
+        .stack = tasks_stack_log,
+        .tcb = &tasks_tcb_log,
+    },
+};
+
+// Handles of running tasks, recorded at creation rather than looked up by
+// name, which needn't be unique. A handle is copied under the lock and counted
+// in tasks_handle_users while in use, so that tasks_exit() can wait for it to
+// be released before the task is deleted, without the stack scan running in
+// a critical section.
+static portMUX_TYPE tasks_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t tasks_handles[TASKS_ID_NUM];
+static uint8_t tasks_handle_users[TASKS_ID_NUM];
+
+const tasks_config *tasks_get_config(tasks_id id) {
+    assert(id < TASKS_ID_NUM);
+    const tasks_config *config = &tasks_configs[id];
+    assert(config->name != nullptr);
+    return config;
+}
+
+BaseType_t tasks_get_core(tasks_id id) {
+    BaseType_t core = tasks_get_config(id)->core;
+    if (core != tskNO_AFFINITY && core >= portNUM_PROCESSORS)
+        return tskNO_AFFINITY;
+    return core;
+}
+
+TaskHandle_t tasks_create(tasks_id id, TaskFunction_t fn) {
+    const tasks_config *config = tasks_get_config(id);
+    BaseType_t core = tasks_get_core(id);
+    ESP_LOGI(TAG, "%s: core %d priority %u", config->name, (int)core,
+        (unsigned)config->priority);
+    TaskHandle_t handle;
+    if (config->stack != nullptr) {
+        handle = xTaskCreateStaticPinnedToCore(fn, config->name,
+            config->stack_size, NULL, config->priority, config->stack,
+            config->tcb, core);
+    } else {
+        BaseType_t xRet = xTaskCreatePinnedToCore(fn, config->name,
+            config->stack_size, NULL, config->priority, &handle, core);
+        if (xRet != pdPASS)
+            handle = NULL;
+    }
+    tasks_set_handle(id, handle);
+    return handle;
+}
+
+void tasks_set_handle(tasks_id id, TaskHandle_t handle) {
+    assert(id < TASKS_ID_NUM);
+    portENTER_CRITICAL(&tasks_lock);
+    tasks_handles[id] = handle;
+    portEXIT_CRITICAL(&tasks_lock);
+}
+
+void tasks_exit(tasks_id id) {
+    tasks_set_handle(id, NULL);
+    for (;;) {
+        portENTER_CRITICAL(&tasks_lock);
+        bool in_use = tasks_handle_users[id] != 0;
+        portEXIT_CRITICAL(&tasks_lock);
+        if (!in_use)
+            break;
+        vTaskDelay(1);
+    }
+    vTaskDelete(NULL);
+}
+
+uint32_t tasks_get_stack_free(tasks_id id) {
+    assert(id < TASKS_ID_NUM);
+    portENTER_CRITICAL(&tasks_lock);
+    TaskHandle_t handle = tasks_handles[id];
+    if (handle != NULL)
+        tasks_handle_users[id]++;
+    portEXIT_CRITICAL(&tasks_lock);
+    if (handle == NULL)
+        return UINT32_MAX;
+
+    uint32_t stack_free = uxTaskGetStackHighWaterMark(handle);
+    portENTER_CRITICAL(&tasks_lock);
+    tasks_handle_users[id]--;
+    portEXIT_CRITICAL(&tasks_lock);
+    return stack_free;
+}
+
+bool tasks_stack_low(uint32_t stack_free) {
+    return stack_free < TASKS_STACK_MARGIN;
+}
+
+void tasks_log_ram_budget() {
+    uint32_t static_total = 0;
+    for (int i = 0; i < TASKS_ID_NUM; i++) {
+        tasks_id id = (tasks_id)i;
+        const tasks_config *config = tasks_get_config(id);
+        uint32_t stack_free = tasks_get_stack_free(id);
+        bool is_static = (config->stack != nullptr) || (id == TASKS_ID_RFID);
+        if (is_static)
+            static_total += config->stack_size + sizeof(StaticTask_t);
+        if (stack_free == UINT32_MAX) {
+            ESP_LOGI(TAG, "ram: %-8s stack %5lu (%s), not running",
+                config->name, config->stack_size,
+                is_static ? "static" : "heap");
+            continue;
+        }
+        if (tasks_stack_low(stack_free)) {
+            ESP_LOGW(TAG, "ram: %-8s stack %5lu (%s), %lu free: LOW",
+                config->name, config->stack_size,
+                is_static ? "static" : "heap", stack_free);
+        } else {
+            ESP_LOGI(TAG, "ram: %-8s stack %5lu (%s), %lu free",
+                config->name, config->stack_size,
+                is_static ? "static" : "heap", stack_free);
+        }
+    }
+    ESP_LOGI(TAG, "ram: static task storage %lu", static_total);
+    ESP_LOGI(TAG, "ram: internal heap free %u, min free %u, largest block %u",
+        heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+        heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+}
+
+// Runtime stats view. CPU share is measured between consecutive requests (or
+// since boot for the first), as a percentage of one core. Only the HTTP
+// server task touches this state, so no locking is required.
+#define TASKS_STATS_MAX 32
+
+static TaskStatus_t tasks_stats_prev[TASKS_STATS_MAX];
+static UBaseType_t tasks_stats_prev_count;
+static uint32_t tasks_stats_prev_total;
+static TaskStatus_t tasks_stats_cur[TASKS_STATS_MAX];
+
+static uint32_t tasks_prev_run_time(const TaskStatus_t &cur) {
+    for (UBaseType_t i = 0; i < tasks_stats_prev_count; i++) {
+        if (tasks_stats_prev[i].xTaskNumber == cur.xTaskNumber)
+            return tasks_stats_prev[i].ulRunTimeCounter;
+    }
+    return 0;
+}
+
+static esp_err_t tasks_http_handler_stats(httpd_req_t *req) {
+    uint32_t total;
+    UBaseType_t count =
+        uxTaskGetSystemState(tasks_stats_cur, TASKS_STATS_MAX, &total);
+    uint32_t elapsed = total - tasks_stats_prev_total;
+
+    httpd_resp_set_type(req, "text/plain");
+    char line[96];
+    snprintf(line, sizeof(line), "%-16s %4s %4s %6s %7s\n",
+        "task", "core", "prio", "stack", "cpu%");
+    esp_err_t err = httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN);
+    for (UBaseType_t i = 0; (err == ESP_OK) && (i < count); i++) {
+        const TaskStatus_t &t = tasks_stats_cur[i];
+        uint32_t run = t.ulRunTimeCounter - tasks_prev_run_time(t);
+        // Fixed point with 1 decimal place.
+        uint32_t cpu_x10 =
+            elapsed ? (uint32_t)((run * 1000ULL) / elapsed) : 0;
+        char core[8];
+        if (t.xCoreID == tskNO_AFFINITY)
+            snprintf(core, sizeof(core), "%s", "-");
+        else
+            snprintf(core, sizeof(core), "%d", (int)t.xCoreID);
+        snprintf(line, sizeof(line), "%-16s %4s %4u %6lu %5lu.%lu\n",
+            t.pcTaskName, core, (unsigned)t.uxCurrentPriority,
+            (uint32_t)t.usStackHighWaterMark, cpu_x10 / 10, cpu_x10 % 10);
+        err = httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN);
+    }
+    if (err == ESP_OK)
+        err = httpd_resp_send_chunk(req, NULL, 0);
+
+    memcpy(tasks_stats_prev, tasks_stats_cur, count * sizeof(TaskStatus_t));
+    tasks_stats_prev_count = count;
+    tasks_stats_prev_total = total;
+    return err;
+}
+
+static const httpd_uri_t tasks_http_uri_stats = {
+    .uri = "/tasks",
+    .method = HTTP_GET,
+    .handler = tasks_http_handler_stats,
+    .user_ctx = NULL,
+};
+
+void tasks_init() {
+    cm_http_register_uri_handler(&tasks_http_uri_stats);
+}
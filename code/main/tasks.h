@@ -0,0 +1,46 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdint.h>
+
+// Every application task, so that the core/priority plan lives in one place.
+enum tasks_id {
+    TASKS_ID_RFID,
+    TASKS_ID_DISPATCH,
+    TASKS_ID_MQTT,
+    TASKS_ID_LCD,
+    TASKS_ID_LOADGEN,
+    TASKS_ID_LOG,
+    TASKS_ID_NUM,
+};
+
+struct tasks_config {
+    const char *name;
+    uint32_t stack_size;
+    UBaseType_t priority;
+    BaseType_t core; // tskNO_AFFINITY, or a core ID
+    // Static storage, or nullptr to allocate from the heap.
+    StackType_t *stack;
+    StaticTask_t *tcb;
+};
+
+extern const tasks_config *tasks_get_config(tasks_id id);
+// The configured core, or tskNO_AFFINITY if that core doesn't exist.
+extern BaseType_t tasks_get_core(tasks_id id);
+// Returns NULL if the task couldn't be created.
+extern TaskHandle_t tasks_create(tasks_id id, TaskFunction_t fn);
+// Record the handle of a task created elsewhere, i.e. by a component.
+extern void tasks_set_handle(tasks_id id, TaskHandle_t handle);
+// Delete the calling task, which must be id, created by tasks_create().
+extern void tasks_exit(tasks_id id);
+// Minimum free stack (bytes) since the task started, or UINT32_MAX if the task
+// isn't running.
+extern uint32_t tasks_get_stack_free(tasks_id id);
+extern bool tasks_stack_low(uint32_t stack_free);
+// Log each task's stack and the heap state. Call once boot is complete.
+extern void tasks_log_ram_budget();
+extern void tasks_init();
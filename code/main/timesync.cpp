@@ -0,0 +1,86 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <esp_log.h>
+#include <esp_sntp.h>
+
+#include "conf_watch.h"
+#include "fcch_connmgr/cm_conf.h"
+#include "fcch_connmgr/cm_util.h"
+#include "timesync.h"
+
+static const char *TAG = "timesync";
+
+static const char *timesync_default_server = "pool.ntp.org";
+
+static const char *timesync_server;
+static cm_conf_item timesync_item_server = {
+    .slug_name = "s", // Server
+    .text_name = "NTP Server (empty for pool.ntp.org)",
+    .type = CM_CONF_ITEM_TYPE_STR,
+    .p_val = {.str = &timesync_server },
+    .default_func = &cm_conf_default_str_empty,
+};
+
+static cm_conf_item *timesync_items[] = {
+    &timesync_item_server,
+};
+
+static cm_conf_page timesync_page = {
+    .slug_name = "t", // Time
+    .text_name = "Time",
+    .items = timesync_items,
+    .items_count = ARRAY_SIZE(timesync_items),
+};
+
+// SNTP keeps a pointer to the server name, rather than a copy, so it can't
+// point at the configuration value, which is freed when it changes.
+static char timesync_server_name[64];
+static volatile bool timesync_synced;
+
+// Runs in the lwIP task.
+static void timesync_on_sync(struct timeval *tv) {
+    if (!timesync_synced)
+        ESP_LOGI(TAG, "synchronized");
+    timesync_synced = true;
+}
+
+// Runs in the dispatch task, and at init.
+static void timesync_apply() {
+    const char *server = timesync_server[0] ?
+        timesync_server : timesync_default_server;
+    if (esp_sntp_enabled()) {
+        if (!strcmp(server, timesync_server_name))
+            return;
+        esp_sntp_stop();
+    }
+    snprintf(timesync_server_name, sizeof(timesync_server_name), "%s", server);
+    ESP_LOGI(TAG, "server %s", timesync_server_name);
+    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, timesync_server_name);
+    esp_sntp_init();
+}
+
+void timesync_register_conf() {
+    cm_conf_register_page(&timesync_page);
+}
+
+// SNTP retries by itself until the network is up.
+void timesync_init() {
+    sntp_set_time_sync_notification_cb(timesync_on_sync);
+    timesync_apply();
+    conf_watch_register_page(&timesync_page, timesync_apply);
+}
+
+bool timesync_get_time_ms(int64_t *ms) {
+    if (!timesync_synced)
+        return false;
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    *ms = ((int64_t)tv.tv_sec * 1000) + (tv.tv_usec / 1000);
+    return true;
+}
@@ -0,0 +1,14 @@
+// Copyright 2026 Stephen Warren <swarren@wwwdotorg.org>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+// Wall clock time, kept by SNTP.
+
+extern void timesync_register_conf();
+extern void timesync_init();
+// UTC milliseconds since the Unix epoch. Returns false if the clock hasn't
+// been synchronized since boot.
+extern bool timesync_get_time_ms(int64_t *ms);